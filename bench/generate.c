@@ -0,0 +1,235 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Writes a random but valid .teeny program to stdout, for the compiler
+// throughput benchmark. The same options and seed always give the same
+// program. Loops are not meant to terminate, the program is only compiled.
+//
+//   -l lines      about how many lines to write (1000)
+//   -d depth      how deep IF, WHILE and FOR may nest (3)
+//   -s symbols    how many variables to declare up front (50)
+//   -e terms      how many terms an expression has at most (4)
+//   -g percent    how many statements are a LABEL or a GOTO (2)
+//   -t length     how long string literals are at most (16)
+//   -r seed       (1)
+
+typedef struct Generator {
+	int lines;
+	int depth;
+	int symbols;
+	int terms;
+	int gotos;
+	int stringLength;
+	unsigned long long state;
+	// lines written so far, and labels placed and ever to be placed
+	int written;
+	int labelsPlaced;
+	int labelCount;
+} Generator;
+
+// xorshift64*, so the output does not depend on the C library
+static unsigned int Generator_random(Generator *gen, unsigned int bound) {
+	gen->state ^= gen->state >> 12;
+	gen->state ^= gen->state << 25;
+	gen->state ^= gen->state >> 27;
+	return (unsigned int) ((gen->state * 2685821657736338717ULL) >> 32) % bound;
+}
+
+static void Generator_indent(int depth) {
+	int i;
+	for (i = 0; i < depth; i++)
+		putchar('\t');
+}
+
+static void Generator_line(Generator *gen, int depth, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	Generator_indent(depth);
+	vprintf(format, args);
+	va_end(args);
+	putchar('\n');
+	gen->written++;
+}
+
+// variables are declared as INT, FLOAT and STRING in a fixed pattern, so
+// the type of every index is known: vN, fN and sN
+static char Generator_kind(int symbol) {
+	return symbol % 10 < 7 ? 'v' : symbol % 10 < 9 ? 'f' : 's';
+}
+
+static int Generator_symbol(Generator *gen, char kind) {
+	int symbol;
+	do {
+		symbol = Generator_random(gen, gen->symbols);
+	} while (Generator_kind(symbol) != kind);
+	return symbol;
+}
+
+static void Generator_string(Generator *gen, char *text) {
+	int length = 1 + Generator_random(gen, gen->stringLength);
+	int i;
+	for (i = 0; i < length; i++)
+		text[i] = i % 6 == 5 ? ' ' : 'a' + Generator_random(gen, 26);
+	text[length] = '\0';
+}
+
+// an INT or FLOAT expression of up to gen->terms terms
+static void Generator_expression(Generator *gen, char kind, char *text) {
+	static const char *operators[] = { " + ", " - ", " * " };
+	int terms = 1 + Generator_random(gen, gen->terms);
+	int i;
+	text[0] = '\0';
+	for (i = 0; i < terms; i++) {
+		char term[32];
+		if (Generator_random(gen, 2) == 0)
+			snprintf(term, sizeof(term), "%c%d", kind, Generator_symbol(gen, kind));
+		else if (kind == 'f')
+			snprintf(term, sizeof(term), "%u.5", Generator_random(gen, 100));
+		else
+			snprintf(term, sizeof(term), "%u", Generator_random(gen, 100));
+		if (i > 0)
+			strcat(text, operators[Generator_random(gen, 3)]);
+		strcat(text, term);
+	}
+}
+
+static void Generator_comparison(Generator *gen, char *text) {
+	static const char *operators[] = { " < ", " <= ", " > ", " >= ", " == ", " != " };
+	char kind = Generator_random(gen, 4) == 0 ? 'f' : 'v';
+	char right[1024];
+	Generator_expression(gen, kind, text);
+	Generator_expression(gen, kind, right);
+	strcat(text, operators[Generator_random(gen, 6)]);
+	strcat(text, right);
+}
+
+static void Generator_statements(Generator *gen, int depth, int count);
+
+static void Generator_statement(Generator *gen, int depth) {
+	char text[1024];
+	char other[1024];
+	int symbol;
+	unsigned int pick = Generator_random(gen, 100);
+	// labels only at the top, so every one of them is placed exactly once
+	if (pick < (unsigned int) gen->gotos) {
+		if (depth == 0 && gen->labelsPlaced < gen->labelCount && Generator_random(gen, 2) == 0)
+			Generator_line(gen, depth, "LABEL l%d", gen->labelsPlaced++);
+		else
+			Generator_line(gen, depth, "GOTO l%u", Generator_random(gen, gen->labelCount));
+		return;
+	}
+	pick = Generator_random(gen, 100);
+	int nest = depth < gen->depth;
+	if (pick < 40) {
+		char kind = Generator_random(gen, 4) == 0 ? 'f' : 'v';
+		Generator_expression(gen, kind, text);
+		Generator_line(gen, depth, "LET %c%d = %s", kind, Generator_symbol(gen, kind), text);
+	} else if (pick < 50) {
+		Generator_expression(gen, 'v', text);
+		Generator_line(gen, depth, "PRINT %s", text);
+	} else if (pick < 55) {
+		Generator_string(gen, text);
+		Generator_line(gen, depth, "PRINT \"%s\"", text);
+	} else if (pick < 62) {
+		symbol = Generator_symbol(gen, 's');
+		Generator_string(gen, text);
+		Generator_line(gen, depth, "LET s%d = s%d + \"%s\"", symbol, Generator_symbol(gen, 's'), text);
+	} else if (pick < 80 && nest) {
+		int arms = Generator_random(gen, 3);
+		Generator_comparison(gen, text);
+		Generator_line(gen, depth, "IF %s THEN", text);
+		Generator_statements(gen, depth + 1, 1 + Generator_random(gen, 4));
+		while (arms-- > 0) {
+			Generator_comparison(gen, text);
+			Generator_line(gen, depth, "ELSEIF %s THEN", text);
+			Generator_statements(gen, depth + 1, 1 + Generator_random(gen, 4));
+		}
+		if (Generator_random(gen, 2) == 0) {
+			Generator_line(gen, depth, "ELSE");
+			Generator_statements(gen, depth + 1, 1 + Generator_random(gen, 4));
+		}
+		Generator_line(gen, depth, "ENDIF");
+	} else if (pick < 88 && nest) {
+		Generator_comparison(gen, text);
+		Generator_line(gen, depth, "WHILE %s REPEAT", text);
+		Generator_statements(gen, depth + 1, 1 + Generator_random(gen, 4));
+		Generator_line(gen, depth, "ENDWHILE");
+	} else if (nest) {
+		Generator_expression(gen, 'v', text);
+		Generator_expression(gen, 'v', other);
+		Generator_line(gen, depth, "FOR v%d = %s TO %s REPEAT", Generator_symbol(gen, 'v'), text, other);
+		Generator_statements(gen, depth + 1, 1 + Generator_random(gen, 4));
+		Generator_line(gen, depth, "ENDFOR");
+	} else {
+		Generator_expression(gen, 'v', text);
+		Generator_line(gen, depth, "LET v%d = %s", Generator_symbol(gen, 'v'), text);
+	}
+}
+
+// the first statement is written even past the line budget, so no block
+// is left empty
+static void Generator_statements(Generator *gen, int depth, int count) {
+	Generator_statement(gen, depth);
+	while (--count > 0 && gen->written < gen->lines)
+		Generator_statement(gen, depth);
+}
+
+static int Generator_option(int argc, char *argv[], int *i) {
+	if (*i + 1 >= argc) {
+		printf("%s needs a number.\n", argv[*i]);
+		exit(1);
+	}
+	return atoi(argv[++*i]);
+}
+
+int main(int argc, char *argv[]) {
+	Generator gen = { 1000, 3, 50, 4, 2, 16, 1, 0, 0, 0 };
+	int i;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-l") == 0)
+			gen.lines = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-d") == 0)
+			gen.depth = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-s") == 0)
+			gen.symbols = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-e") == 0)
+			gen.terms = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-g") == 0)
+			gen.gotos = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-t") == 0)
+			gen.stringLength = Generator_option(argc, argv, &i);
+		else if (strcmp(argv[i], "-r") == 0)
+			gen.state = Generator_option(argc, argv, &i);
+		else {
+			printf("Unknown option %s.\n", argv[i]);
+			exit(1);
+		}
+	}
+	// at least one variable of every kind, and expressions that fit in text
+	if (gen.symbols < 10)
+		gen.symbols = 10;
+	if (gen.terms < 1 || gen.terms > 32)
+		gen.terms = gen.terms < 1 ? 1 : 32;
+	if (gen.stringLength < 1 || gen.stringLength > 512)
+		gen.stringLength = gen.stringLength < 1 ? 1 : 512;
+	if (gen.state == 0)
+		gen.state = 1;
+	gen.labelCount = gen.lines * gen.gotos / 200 + 1;
+
+	for (i = 0; i < gen.symbols; i++) {
+		char kind = Generator_kind(i);
+		if (kind == 'v')
+			Generator_line(&gen, 0, "LET INT v%d = %d", i, i);
+		else if (kind == 'f')
+			Generator_line(&gen, 0, "LET FLOAT f%d = %d.5", i, i);
+		else
+			Generator_line(&gen, 0, "LET STRING s%d = \"s%d\"", i, i);
+	}
+	while (gen.written < gen.lines)
+		Generator_statement(&gen, 0);
+	while (gen.labelsPlaced < gen.labelCount)
+		Generator_line(&gen, 0, "LABEL l%d", gen.labelsPlaced++);
+	return 0;
+}
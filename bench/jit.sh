@@ -0,0 +1,21 @@
+#!/bin/bash
+# compares --jit with the bytecode VM and with gcc -O2, run from the repository root.
+
+PROGRAM=bench/fibonacci.teeny
+
+echo "teenytiny --jit:"
+time src/teenytiny --jit $PROGRAM || exit 1
+
+echo
+echo "teenytiny run:"
+time src/teenytiny run $PROGRAM || exit 1
+
+echo
+echo "teenytiny + gcc -O2, build and run:"
+time (src/teenytiny --no-eval $PROGRAM > /dev/null && gcc -O2 out.c -o jit_bench && ./jit_bench) || exit 1
+rm out.c
+
+echo
+echo "gcc -O2 binary alone:"
+time ./jit_bench
+rm jit_bench
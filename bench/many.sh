@@ -0,0 +1,39 @@
+#!/bin/bash
+# compiles a corpus of FILES small generated programs once with a process
+# per file and once with all of them given to a single process, and prints
+# the files per second of both, run from the repository root after
+# building bench/generate.
+
+FILES=${FILES:-3000}
+LINES=${LINES:-200}
+JOBS=${JOBS:-$(nproc)}
+DIR=$(mktemp -d)
+
+mkdir $DIR/corpus $DIR/each $DIR/one
+for i in $(seq $FILES); do
+	bench/generate -l $LINES -r $i > $DIR/corpus/p$i.teeny || exit 1
+done
+ROOT=$(pwd)
+
+rate() {
+	awk -v files=$FILES -v ns=$1 'BEGIN { printf "%.3f s, %.0f files/s", ns / 1e9, files / (ns / 1e9) }'
+}
+
+cd $DIR/each
+start=$(date +%s%N)
+for program in $DIR/corpus/*.teeny; do
+	$ROOT/src/teenytiny --no-eval $program > /dev/null || exit 1
+	mv out.c $(basename $program .teeny).c
+done
+end=$(date +%s%N)
+echo "process per file: $(rate $(( end - start )))"
+
+cd $DIR/one
+start=$(date +%s%N)
+$ROOT/src/teenytiny --no-eval -j $JOBS $DIR/corpus/*.teeny > /dev/null || exit 1
+end=$(date +%s%N)
+echo "one process, -j $JOBS: $(rate $(( end - start )))"
+
+cd $ROOT
+diff -r -q $DIR/each $DIR/one > /dev/null || echo "outputs differ"
+rm -rf $DIR
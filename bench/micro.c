@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/lex.h"
+#include "../src/parse.h"
+#include "../src/ast.h"
+#include "../src/list.h"
+#include "../src/mem.h"
+
+// Calls single compiler functions on fixed inputs and reports ns and counted
+// allocations per call. With a baseline file it fails when a function got
+// more than the threshold slower, or allocates more than it did.
+//
+//   bench/micro                           report only
+//   bench/micro -b bench/micro.baseline   compare, -t percent (25)
+//   bench/micro -w bench/micro.baseline   record a new baseline
+
+#define MICRO_ROUNDS 5
+#define MICRO_SYMBOLS 50
+
+typedef struct Micro {
+	const char *name;
+	// sets up, runs ops calls and tears down, only the calls are timed
+	void (*run)(long long ops, long long *ns);
+	long long ops;
+	double nsPerOp;
+	double allocsPerOp;
+} Micro;
+
+static const char *lexSource =
+	"# a line of everything the lexer knows\n"
+	"LET FLOAT average = (total + 12.5) / count * -3\n"
+	"IF name != \"some text\" THEN\n"
+	"    PRINT data[index] >= 100\n"
+	"ENDIF\n";
+
+// a parenthesis only opens an expression, so it ends this one
+static const char *expressionSource = "a + b * 3 - c / 2 + d * e - (f - 17)\n";
+
+// the text the lexer being benchmarked reads, freed with it
+static char *lexBuffer = NULL;
+
+static long long Micro_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// a lexer over copies of text
+static Lexer *Micro_lexer(const char *text, long long copies) {
+	size_t length = strlen(text);
+	char *source = malloc(length * copies + 1);
+	if (source == NULL) {
+		printf("Unable to allocate memory for the benchmark.\n");
+		exit(1);
+	}
+	long long i;
+	for (i = 0; i < copies; i++)
+		memcpy(source + length * i, text, length);
+	source[length * copies] = '\0';
+	lexBuffer = source;
+	FILE *file = fmemopen(source, length * copies, "r");
+	return Lexer_create(file);
+}
+
+static void Micro_killLexer(Lexer *lex) {
+	Lexer_kill(lex);
+	free(lexBuffer);
+	lexBuffer = NULL;
+}
+
+static void Micro_symbols(AST *ast) {
+	int i;
+	for (i = 0; i < MICRO_SYMBOLS; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "v%d", i);
+		AST_addSymbol(ast, name, INT_VAR);
+	}
+	const char *names[] = { "a", "b", "c", "d", "e", "f" };
+	for (i = 0; i < 6; i++)
+		AST_addSymbol(ast, (char *) names[i], INT_VAR);
+}
+
+static void Micro_getToken(long long ops, long long *ns) {
+	// the text has 31 tokens
+	Lexer *lex = Micro_lexer(lexSource, ops / 31 + 2);
+	long long i;
+	long long start = Micro_now();
+	for (i = 0; i < ops; i++)
+		Token_kill(Lexer_getToken(lex));
+	*ns = Micro_now() - start;
+	Micro_killLexer(lex);
+}
+
+static void Micro_getKeyword(long long ops, long long *ns) {
+	char *words[] = { "LET", "ENDWHILE", "total", "ARRAY", "x" };
+	long long i;
+	int found = 0;
+	long long start = Micro_now();
+	for (i = 0; i < ops; i++)
+		found += Lexer_getKeyword(words[i % 5]) == IDENT;
+	*ns = Micro_now() - start;
+	if (found < 0)
+		printf("%d\n", found);
+}
+
+// stops unless the expression just parsed was all of its line, or every op
+// would time a different part of it
+static void Micro_wholeLine(Parser *par) {
+	if (par->curToken->type != NEWLINE) {
+		printf("The benchmark expression does not parse to the end of its line.\n");
+		exit(1);
+	}
+}
+
+static void Micro_expression(long long ops, long long *ns) {
+	Lexer *lex = Micro_lexer(expressionSource, ops + 2);
+	AST *ast = AST_create(lex);
+	Micro_symbols(ast);
+	Parser *par = Parser_create(lex, ast);
+	Parser_start(par);
+	long long i;
+	long long start = Micro_now();
+	for (i = 0; i < ops; i++) {
+		ASTNode_kill(Parser_expression(par));
+		Micro_wholeLine(par);
+		Parser_nextToken(par);
+	}
+	*ns = Micro_now() - start;
+	Parser_kill(par);
+	AST_kill(ast);
+	Micro_killLexer(lex);
+}
+
+static void Micro_checkExpression(long long ops, long long *ns) {
+	Lexer *lex = Micro_lexer(expressionSource, 2);
+	AST *ast = AST_create(lex);
+	Micro_symbols(ast);
+	Parser *par = Parser_create(lex, ast);
+	Parser_start(par);
+	ASTNode *expression = Parser_expression(par);
+	Micro_wholeLine(par);
+	long long i;
+	int types = 0;
+	long long start = Micro_now();
+	for (i = 0; i < ops; i++)
+		types += AST_checkExpression(expression) == INT_VAR;
+	*ns = Micro_now() - start;
+	if (types < 0)
+		printf("%d\n", types);
+	ASTNode_kill(expression);
+	Parser_kill(par);
+	AST_kill(ast);
+	Micro_killLexer(lex);
+}
+
+static void Micro_getSymbolType(long long ops, long long *ns) {
+	Lexer *lex = Micro_lexer("\n", 1);
+	AST *ast = AST_create(lex);
+	Micro_symbols(ast);
+	char names[MICRO_SYMBOLS][16];
+	int i;
+	for (i = 0; i < MICRO_SYMBOLS; i++)
+		snprintf(names[i], sizeof(names[i]), "v%d", i);
+	long long op;
+	int found = 0;
+	long long start = Micro_now();
+	for (op = 0; op < ops; op++)
+		found += AST_getSymbolType(names[op % MICRO_SYMBOLS]) == INT_VAR;
+	*ns = Micro_now() - start;
+	if (found < 0)
+		printf("%d\n", found);
+	AST_kill(ast);
+	Micro_killLexer(lex);
+}
+
+// a push and a shift are one call, through a queue 64 long
+static void Micro_pushShift(long long ops, long long *ns) {
+	List *list = List_create();
+	long long i;
+	for (i = 0; i < 64; i++)
+		List_push(list, NULL);
+	long long start = Micro_now();
+	for (i = 0; i < ops; i++) {
+		List_push(list, list);
+		List_shift(list);
+	}
+	*ns = Micro_now() - start;
+	List_destroy(list);
+}
+
+static Micro micros[] = {
+	{ "Lexer_getToken", Micro_getToken, 1000000, 0, 0 },
+	{ "Lexer_getKeyword", Micro_getKeyword, 2000000, 0, 0 },
+	{ "Parser_expression", Micro_expression, 50000, 0, 0 },
+	{ "AST_checkExpression", Micro_checkExpression, 300000, 0, 0 },
+	{ "AST_getSymbolType", Micro_getSymbolType, 2000000, 0, 0 },
+	{ "List_push/List_shift", Micro_pushShift, 5000000, 0, 0 }
+};
+
+#define MICRO_COUNT ((int) (sizeof(micros) / sizeof(micros[0])))
+
+// the fastest of a few rounds, then one more with allocations counted, as
+// counting makes every allocation slower
+static void Micro_measure(Micro *micro) {
+	int round;
+	for (round = 0; round < MICRO_ROUNDS; round++) {
+		long long ns;
+		micro->run(micro->ops, &ns);
+		double perOp = (double) ns / micro->ops;
+		if (round == 0 || perOp < micro->nsPerOp)
+			micro->nsPerOp = perOp;
+	}
+}
+
+static void Micro_count(Micro *micro) {
+	long long ns;
+	long long before = Mem_allocations();
+	micro->run(micro->ops, &ns);
+	micro->allocsPerOp = (double) (Mem_allocations() - before) / micro->ops;
+}
+
+// returns how many functions regressed against the baseline
+static int Micro_compare(char *path, double threshold) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		printf("Baseline could not be opened.\n");
+		exit(1);
+	}
+	int regressions = 0;
+	char text[256];
+	while (fgets(text, sizeof(text), file) != NULL) {
+		char name[64];
+		double ns;
+		double allocs;
+		if (text[0] == '#' || text[0] == '\n')
+			continue;
+		if (sscanf(text, "%63s %lf %lf", name, &ns, &allocs) != 3) {
+			printf("%s is not a microbenchmark baseline.\n", path);
+			exit(1);
+		}
+		int i;
+		for (i = 0; i < MICRO_COUNT && strcmp(micros[i].name, name) != 0; i++)
+			;
+		if (i == MICRO_COUNT)
+			continue;
+		Micro *micro = &micros[i];
+		double change = (micro->nsPerOp - ns) / ns * 100;
+		int slower = change > threshold;
+		// counts are exact, a single extra allocation per call is a regression
+		int allocating = micro->allocsPerOp > allocs + 0.01;
+		printf("%-22s %10.2f ns %+7.1f%% %8.2f allocs (was %.2f)%s\n", name, micro->nsPerOp, change,
+			micro->allocsPerOp, allocs, slower || allocating ? "  REGRESSED" : "");
+		regressions += slower || allocating;
+	}
+	fclose(file);
+	return regressions;
+}
+
+static void Micro_write(char *path) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Baseline could not be opened.\n");
+		exit(1);
+	}
+	fprintf(file, "# function ns/op allocs/op, written by bench/micro -w\n");
+	int i;
+	for (i = 0; i < MICRO_COUNT; i++)
+		fprintf(file, "%s %.2f %.2f\n", micros[i].name, micros[i].nsPerOp, micros[i].allocsPerOp);
+	fclose(file);
+}
+
+int main(int argc, char *argv[]) {
+	char *baseline = NULL;
+	char *record = NULL;
+	double threshold = 25;
+	int i;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+			baseline = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			record = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else {
+			printf("Unknown option %s.\n", argv[i]);
+			exit(1);
+		}
+	}
+
+	for (i = 0; i < MICRO_COUNT; i++)
+		Micro_measure(&micros[i]);
+	Mem_enable();
+	for (i = 0; i < MICRO_COUNT; i++)
+		Micro_count(&micros[i]);
+
+	if (record != NULL)
+		Micro_write(record);
+	if (baseline == NULL) {
+		for (i = 0; i < MICRO_COUNT; i++)
+			printf("%-22s %10.2f ns %8.2f allocs\n", micros[i].name, micros[i].nsPerOp, micros[i].allocsPerOp);
+		return 0;
+	}
+	int regressions = Micro_compare(baseline, threshold);
+	if (regressions > 0) {
+		printf("%d of %d functions regressed by more than %.0f%%.\n", regressions, MICRO_COUNT, threshold);
+		return 1;
+	}
+	return 0;
+}
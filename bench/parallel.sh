@@ -0,0 +1,51 @@
+#!/bin/bash
+# builds bench/parallel.teeny at gcc -O2, once as written and once with its
+# PARALLEL FOR made a plain FOR, and writes the best of RUNS times of the
+# plain one and of the parallel one at each of THREADS workers, with the
+# speedup over the plain one, to bench/parallel.tsv. Run from the repository
+# root, the speedup can not pass the number of CPUs.
+
+OUT=${1:-bench/parallel.tsv}
+RUNS=${RUNS:-3}
+THREADS=${THREADS:-"1 2 4 8 16"}
+PROGRAM=bench/parallel.teeny
+DIR=$(mktemp -d)
+
+# best wall time in seconds of running $1 with $TT_THREADS set to $2
+best() {
+	local best=""
+	local i
+	for i in $(seq $RUNS); do
+		local start=$(date +%s%N)
+		TT_THREADS=$2 $1 > $DIR/output || return
+		local end=$(date +%s%N)
+		cmp -s $DIR/output $DIR/expected || return
+		local time=$(( end - start ))
+		if [ -z "$best" ] || [ $time -lt $best ]; then
+			best=$time
+		fi
+	done
+	awk -v ns=$best 'BEGIN { printf "%.4f", ns / 1e9 }'
+}
+
+sed 's/^PARALLEL //; s/ REDUCE .* REPEAT$/ REPEAT/' $PROGRAM > $DIR/serial.teeny
+src/teenytiny --no-eval $DIR/serial.teeny > /dev/null || exit 1
+gcc -O2 -w out.c -o $DIR/serial || exit 1
+src/teenytiny --no-eval $PROGRAM > /dev/null || exit 1
+gcc -O2 -w out.c -o $DIR/parallel -pthread || exit 1
+$DIR/serial > $DIR/expected
+
+serial=$(best $DIR/serial 1)
+printf "build\tthreads\tseconds\tspeedup\n" > $OUT
+printf "serial\t1\t%s\t1.00\n" $serial >> $OUT
+for threads in $THREADS; do
+	time=$(best $DIR/parallel $threads)
+	if [ -z "$time" ]; then
+		echo "$threads threads: wrong output"
+		exit 1
+	fi
+	printf "parallel\t%s\t%s\t%s\n" $threads $time $(awk -v a=$serial -v b=$time 'BEGIN { printf "%.2f", a / b }') >> $OUT
+done
+
+rm -rf $DIR out.c
+cat $OUT
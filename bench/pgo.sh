@@ -0,0 +1,24 @@
+#!/bin/bash
+# times a branch heavy program before and after feeding its profile back in,
+# run from the repository root.
+
+PROGRAM=${1:-bench/branches.teeny}
+
+src/teenytiny --profile $PROGRAM > /dev/null || exit 1
+gcc -O2 out.c -o pgo_profiled || exit 1
+TT_PROFILE=pgo_bench.prof ./pgo_profiled > /dev/null || exit 1
+
+src/teenytiny --no-eval $PROGRAM > /dev/null || exit 1
+gcc -O2 out.c -o pgo_plain || exit 1
+src/teenytiny --no-eval --use-profile pgo_bench.prof $PROGRAM > /dev/null || exit 1
+gcc -O2 out.c -o pgo_guided || exit 1
+rm out.c
+
+echo "gcc -O2:"
+time ./pgo_plain > /dev/null
+
+echo
+echo "gcc -O2 with --use-profile:"
+time ./pgo_guided > /dev/null
+cmp -s <(./pgo_plain) <(./pgo_guided) || echo "outputs differ!"
+rm pgo_profiled pgo_plain pgo_guided pgo_bench.prof
@@ -0,0 +1,18 @@
+#!/bin/bash
+# measures what --profile costs, run from the repository root.
+
+PROGRAM=${1:-bench/fibonacci.teeny}
+
+src/teenytiny --no-eval $PROGRAM > /dev/null || exit 1
+gcc -O2 out.c -o profile_plain || exit 1
+src/teenytiny --profile $PROGRAM > /dev/null || exit 1
+gcc -O2 out.c -o profile_counted || exit 1
+rm out.c
+
+echo "gcc -O2:"
+time ./profile_plain > /dev/null
+
+echo
+echo "gcc -O2 with --profile:"
+time TT_PROFILE=profile_bench.prof ./profile_counted > /dev/null
+rm profile_plain profile_counted profile_bench.prof
@@ -0,0 +1,50 @@
+#!/bin/bash
+# builds every program in bench/runtime through the compiler and its hand
+# written C version at each gcc level, checks both against the recorded
+# output and writes their best of RUNS times and the ratio to
+# bench/runtime.tsv, run from the repository root or through make
+# bench-runtime.
+
+OUT=${1:-bench/runtime.tsv}
+RUNS=${RUNS:-3}
+LEVELS=${LEVELS:-"-O0 -O1 -O2 -O3"}
+DIR=$(mktemp -d)
+
+# best wall time in seconds of running $1 on stdin $2, or nothing when its
+# output is not the expected one
+best() {
+	local best=""
+	local i
+	for i in $(seq $RUNS); do
+		local start=$(date +%s%N)
+		$1 < $2 > $DIR/output
+		local end=$(date +%s%N)
+		cmp -s $DIR/output $3 || return
+		local time=$(( end - start ))
+		if [ -z "$best" ] || [ $time -lt $best ]; then
+			best=$time
+		fi
+	done
+	awk -v ns=$best 'BEGIN { printf "%.4f", ns / 1e9 }'
+}
+
+printf "program\tlevel\tteeny_s\tc_s\tratio\n" > $OUT
+for program in bench/runtime/*.teeny; do
+	name=$(basename $program .teeny)
+	src/teenytiny --no-eval $program > /dev/null || exit 1
+	cp out.c $DIR/$name.c
+	for level in $LEVELS; do
+		gcc $level -w $DIR/$name.c -o $DIR/teeny || exit 1
+		gcc $level -w bench/runtime/$name.c -o $DIR/baseline || exit 1
+		teeny=$(best $DIR/teeny bench/runtime/$name.in bench/runtime/$name.expected)
+		baseline=$(best $DIR/baseline bench/runtime/$name.in bench/runtime/$name.expected)
+		if [ -z "$teeny" ] || [ -z "$baseline" ]; then
+			echo "$name $level: wrong output"
+			exit 1
+		fi
+		printf "%s\t%s\t%s\t%s\t%s\n" $name $level $teeny $baseline $(awk -v a=$teeny -v b=$baseline 'BEGIN { printf "%.2f", a / b }') >> $OUT
+	done
+done
+
+rm -rf $DIR out.c
+cat $OUT
@@ -0,0 +1,21 @@
+#include <stdio.h>
+
+int main(void) {
+	int count, passes;
+	int scores[64];
+	if (scanf("%d %d", &count, &passes) != 2 || count < 1 || count > 64)
+		return 1;
+	for (int i = 0; i < count; i++)
+		if (scanf("%d", &scores[i]) != 1)
+			return 1;
+	int m = 1000003;
+	int checksum = 0;
+	for (int pass = 1; pass <= passes; pass++) {
+		int s = 0;
+		for (int i = 0; i < count; i++)
+			s += scores[i] * pass;
+		checksum = (checksum + s / count) % m;
+	}
+	printf("Average: \n%d\n", checksum);
+	return 0;
+}
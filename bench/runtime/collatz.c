@@ -0,0 +1,24 @@
+#include <stdio.h>
+
+int main(void) {
+	int limit, passes;
+	if (scanf("%d %d", &limit, &passes) != 2)
+		return 1;
+	int steps = 0, longest = 0, best = 0;
+	for (int pass = 1; pass <= passes; pass++) {
+		for (int n = 1; n <= limit; n++) {
+			int x = n, count = 0;
+			while (x != 1) {
+				x = x % 2 == 0 ? x / 2 : 3 * x + 1;
+				count++;
+			}
+			steps += count;
+			if (count > longest) {
+				longest = count;
+				best = n;
+			}
+		}
+	}
+	printf("%d\n%d\n%d\n", steps, best, longest);
+	return 0;
+}
@@ -0,0 +1,21 @@
+#include <stdio.h>
+
+int main(void) {
+	int rounds, steps;
+	if (scanf("%d %d", &rounds, &steps) != 2)
+		return 1;
+	int m = 1000000;
+	int a = 0, b = 1, c, total = 0;
+	for (int round = 1; round <= rounds; round++) {
+		a = 0;
+		b = 1;
+		for (int i = 1; i <= steps; i++) {
+			c = (a + b) % m;
+			a = b;
+			b = c;
+		}
+		total = (total + a) % m;
+	}
+	printf("%d\n", total);
+	return 0;
+}
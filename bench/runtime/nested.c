@@ -0,0 +1,27 @@
+#include <stdio.h>
+
+int a[14400], b[14400], c[14400];
+
+int main(void) {
+	int n, rounds;
+	if (scanf("%d %d", &n, &rounds) != 2 || n < 1 || n > 120)
+		return 1;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			a[i * n + j] = (i * 7 + j * 3) % 10;
+			b[i * n + j] = (i * 5 + j) % 7;
+		}
+	int checksum = 0;
+	for (int round = 1; round <= rounds; round++) {
+		for (int i = 0; i < n; i++)
+			for (int j = 0; j < n; j++) {
+				int s = round;
+				for (int k = 0; k < n; k++)
+					s += a[i * n + k] * b[k * n + j];
+				c[i * n + j] = s;
+			}
+		checksum += c[round % n];
+	}
+	printf("%d\n", checksum);
+	return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <string.h>
+
+static char words[4][256];
+
+static int readLine(char *line) {
+	if (fgets(line, 256, stdin) == NULL)
+		return 0;
+	line[strcspn(line, "\n")] = '\0';
+	return 1;
+}
+
+int main(void) {
+	int rounds;
+	for (int i = 0; i < 4; i++)
+		if (!readLine(words[i]))
+			return 1;
+	if (scanf("%d", &rounds) != 1)
+		return 1;
+	char current[256] = "";
+	int same = 0, different = 0;
+	for (int i = 1; i <= rounds; i++) {
+		strcpy(current, words[i % 4]);
+		if (strcmp(current, words[1]) == 0)
+			same++;
+		if (strcmp(current, words[2]) != 0)
+			different++;
+	}
+	printf("%d\n%d\n", same, different);
+	return 0;
+}
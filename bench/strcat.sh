@@ -0,0 +1,9 @@
+#!/bin/bash
+# times string concatenation in a loop, run from the repository root.
+
+src/teenytiny bench/strcat.teeny || exit 1
+gcc -O2 out.c -o strcat_bench || exit 1
+rm out.c
+
+time ./strcat_bench
+rm strcat_bench
@@ -0,0 +1,50 @@
+#!/bin/bash
+# compiles generated programs of growing size and shape and writes one tab
+# separated row per program to bench/throughput.tsv, run from the repository
+# root after building bench/generate, or through make bench.
+# the phase columns are milliseconds of wall time from --time-report, with
+# lexing taken out of Parser_program, so they add up to the total less
+# startup.
+
+OUT=${1:-bench/throughput.tsv}
+DIR=$(mktemp -d)
+PHASES="lex Parser_program AST_check IR_lower IR_optimize IR_emit Emitter_writeFile killAll"
+
+# name and generator options
+PROGRAMS="
+flat-1k -l 1000 -d 0
+flat-10k -l 10000 -d 0
+flat-100k -l 100000 -d 0
+nested-10k -l 10000 -d 8
+nested-100k -l 100000 -d 8
+symbols-10k -l 10000 -s 2000
+expressions-10k -l 10000 -e 24
+gotos-10k -l 10000 -g 20
+strings-10k -l 10000 -t 400
+"
+
+printf "program\tlines\tbytes\ttotal_ms\tlines_per_sec\tpeak_rss_kb" > $OUT
+for phase in $PHASES; do
+	printf "\t%s_ms" $phase >> $OUT
+done
+printf "\n" >> $OUT
+
+echo "$PROGRAMS" | while read name options; do
+	[ -z "$name" ] && continue
+	bench/generate $options > $DIR/$name.teeny || exit 1
+	lines=$(wc -l < $DIR/$name.teeny)
+	bytes=$(wc -c < $DIR/$name.teeny)
+	# timed and measured apart, as counting allocations slows the compiler
+	src/teenytiny --no-eval --time-report $DIR/$name.teeny 2> $DIR/time > /dev/null || exit 1
+	src/teenytiny --no-eval --mem-stats $DIR/$name.teeny 2> $DIR/mem > /dev/null || exit 1
+	total=$(awk '$1 == "total" { print $2 }' $DIR/time)
+	rss=$(awk '$1 == "peak" && $2 == "RSS" { print $3 }' $DIR/mem)
+	printf "%s\t%d\t%d\t%s\t%.0f\t%s" $name $lines $bytes $total $(echo "$lines $total" | awk '{ print $1 / ($2 / 1000) }') $rss >> $OUT
+	for phase in $PHASES; do
+		printf "\t%s" $(awk -v phase=$phase '$1 == phase { found = phase == "Parser_program" ? $4 : $3 } END { print found == "" ? 0 : found }' $DIR/time) >> $OUT
+	done
+	printf "\n" >> $OUT
+done
+
+rm -rf $DIR out.c
+cat $OUT
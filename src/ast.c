@@ -1,9 +1,11 @@
 #include "ast.h"
+#include "mem.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 // only use when needed because i said so, probably could change?
-AST *astGlobal;
+_Thread_local AST *astGlobal;
 
 AST *AST_create(Lexer *lex) {
 	AST *ast = malloc(sizeof(AST));
@@ -13,16 +15,14 @@ AST *AST_create(Lexer *lex) {
 	ast->children = List_create();
 	if (ast->children == NULL) {
 		free(ast);
-		printf("Unable to allocate memory for ast children list.\n");
-		exit(1);
+		Diagnostic_raise(0, "Unable to allocate memory for ast children list.");
 	}
 
 	ast->symbols = List_create();
 	if (ast->symbols == NULL) {
 		free(ast->children);
 		free(ast);
-		printf("Unable to allocate memory for symbols list.\n");
-		exit(1);
+		Diagnostic_raise(0, "Unable to allocate memory for symbols list.");
 	}
 
 	ast->labelsDeclared = List_create();
@@ -30,8 +30,7 @@ AST *AST_create(Lexer *lex) {
 		free(ast->children);
 		free(ast->symbols);
 		free(ast);
-		printf("Unable to allocate memory for labelsDeclared list.\n");
-		exit(1);
+		Diagnostic_raise(0, "Unable to allocate memory for labelsDeclared list.");
 	}
 	ast->labelsGotoed = List_create();
 	if (ast->labelsGotoed == NULL) {
@@ -39,36 +38,66 @@ AST *AST_create(Lexer *lex) {
 		free(ast->symbols);
 		free(ast->labelsDeclared);
 		free(ast);
-		printf("Unable to allocate memory for labelsGotoed list.\n");
-		exit(1);
+		Diagnostic_raise(0, "Unable to allocate memory for labelsGotoed list.");
+	}
+	ast->stringLiterals = List_create();
+	if (ast->stringLiterals == NULL) {
+		free(ast->children);
+		free(ast->symbols);
+		free(ast->labelsDeclared);
+		free(ast->labelsGotoed);
+		free(ast);
+		Diagnostic_raise(0, "Unable to allocate memory for stringLiterals list.");
+	}
+	ast->checking = List_create();
+	if (ast->checking == NULL) {
+		free(ast->children);
+		free(ast->symbols);
+		free(ast->labelsDeclared);
+		free(ast->labelsGotoed);
+		free(ast->stringLiterals);
+		free(ast);
+		Diagnostic_raise(0, "Unable to allocate memory for checking list.");
 	}
 
 	ast->lex = lex;
+	ast->seenInput = 0;
 	ast->seenStrInput = 0;
+	ast->seenString = 0;
+	ast->seenArray = 0;
+	ast->stringTemps = 0;
 	ast->currentLineNumber = 0;
+	ast->nodes.prevNode = &ast->nodes;
+	ast->nodes.nextNode = &ast->nodes;
 
 	astGlobal = ast;
 	return ast;
 }
 
 ASTNode *ASTNode_create(Token *t) {
+	return AST_createNode(astGlobal, t, astGlobal->lex->lineNumber);
+}
+
+// a node of ast, for when there is no lexer to tell the line
+ASTNode *AST_createNode(AST *ast, Token *t, int line) {
 	ASTNode *astNode = malloc(sizeof(ASTNode));
-	if (astNode == NULL) {
-		printf("memory allocated to ast was null.\n");
-		return NULL;
-	}
+	if (astNode == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for an AST node.");
 
+	Mem_add(MEM_AST, astNode);
 	astNode->token = Token_copy(t);
 	astNode->children = List_create();
 	astNode->subType = eOF;
-	astNode->lineNumber = astGlobal->lex->lineNumber;
+	astNode->lineNumber = line;
+	astNode->prevNode = &ast->nodes;
+	astNode->nextNode = ast->nodes.nextNode;
+	astNode->nextNode->prevNode = astNode;
+	ast->nodes.nextNode = astNode;
 	return astNode;
 }
 
 void AST_abort(const char *message) {
-	printf("ERROR AT LINE #%d:\n", astGlobal->currentLineNumber);
-	printf("%s\n", message);
-	exit(1);
+	Diagnostic_raise(astGlobal->currentLineNumber, message);
 }
 
 void ASTNode_add(ASTNode *parent, ASTNode *child) {
@@ -91,6 +120,9 @@ void ASTNode_kill(ASTNode *node) {
         cur->value = NULL;
 	}
 	List_destroy(node->children);
+	node->prevNode->nextNode = node->nextNode;
+	node->nextNode->prevNode = node->prevNode;
+	Mem_remove(MEM_AST, node);
 	free(node);
 }
 
@@ -165,6 +197,10 @@ void AST_checkStatement(ASTNode *statement) {
 				AST_checkStatement(temp);
 				current = current->next;
 			}
+			if (statement->subType == PARALLEL) {
+				astGlobal->currentLineNumber = statement->lineNumber;
+				AST_checkParallel(statement);
+			}
 			break;
 
 		case LABEL:
@@ -172,15 +208,20 @@ void AST_checkStatement(ASTNode *statement) {
 		case INPUT:
 			current = statement->children->first;
 			temp = (ASTNode *) current->value;
-			temp->subType = AST_getSymbolType(temp->token->text);
-			if (temp->subType == STRING_VAR)
+			if (statement->token->type == INPUT)
+				temp->subType = AST_checkVariable(temp);
+			else
+				temp->subType = AST_getSymbolType(temp->token->text);
+			if (statement->token->type == INPUT)
+				astGlobal->seenInput = 1;
+			if (statement->token->type == INPUT && temp->subType == STRING_VAR)
 				astGlobal->seenStrInput = 1;
 			break;
 
 		case LET:
 			current = statement->children->first;
 			temp = (ASTNode *) current->value;
-			TokenType symbolType = AST_getSymbolType(temp->token->text);
+			TokenType symbolType = AST_checkVariable(temp);
 			temp->subType = symbolType;
 
 			current = current->next;
@@ -189,12 +230,332 @@ void AST_checkStatement(ASTNode *statement) {
 			AST_getSubType(symbolType, expType, EQ);
 			break;
 
+		case ARRAY:
+			// sized and typed by the parser already
+			break;
+
 		default:
 			AST_abort("How did we get here?");
 			break;
 	}
 }
 
+// A PARALLEL FOR runs its iterations at once and in no fixed order, so it is
+// only allowed when that gives what running them one after another would,
+// but for rounding: an iteration may write the element of an array its loop
+// variable indexes, read no element another iteration writes, add to its
+// REDUCE variables and set scalars for itself, as long as it sets them on
+// every path and before it reads them. The values the last iteration leaves
+// are kept after the loop. A FLOAT REDUCE variable is summed in no fixed
+// order, so it may round differently from the loop run in order, and from
+// run to run.
+typedef struct ASTParallel {
+	char *counter;
+	List *reductions;
+	// every scalar the body sets, REDUCE variables aside, and every array
+	List *scalars;
+	List *arrays;
+} ASTParallel;
+
+static void AST_parallelAbort(ASTNode *node, const char *format, char *name) {
+	char message[200];
+	snprintf(message, sizeof(message), format, name);
+	astGlobal->currentLineNumber = node->lineNumber;
+	AST_abort(message);
+}
+
+static int AST_named(List *names, char *name) {
+	ListNode *node;
+	for (node = names->first; node != NULL; node = node->next) {
+		if (strcmp((char *) node->value, name) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+// a list the check frees when it is done, or AST_kill when an error stops it
+static List *AST_parallelList() {
+	List *list = List_create();
+	List_push(astGlobal->checking, list);
+	return list;
+}
+
+static void AST_parallelDone(AST *ast) {
+	List *list;
+	while ((list = List_shift(ast->checking)) != NULL)
+		List_destroy(list);
+}
+
+static void AST_name(List *names, char *name) {
+	if (!AST_named(names, name))
+		List_push(names, name);
+}
+
+static List *AST_copyNames(List *names) {
+	List *copy = AST_parallelList();
+	ListNode *node;
+	for (node = names->first; node != NULL; node = node->next)
+		List_push(copy, node->value);
+	return copy;
+}
+
+// the statements of a block: all children but the condition of an IF,
+// ELSEIF or WHILE and the header of a FOR, with an ELSEIF or ELSE last
+static ListNode *AST_body(ASTNode *statement) {
+	ListNode *first = statement->children->first;
+	switch (statement->token->type) {
+		case IF:
+		case ELSEIF:
+		case WHILE:
+			return first->next;
+		case FOR:
+			return first->next->next->next;
+		case ELSE:
+			return first;
+		default:
+			return NULL;
+	}
+}
+
+// whether name is one of the REDUCE idents of a PARALLEL FOR
+static int AST_reduces(List *reductions, char *name) {
+	ListNode *node;
+	for (node = reductions->first; node != NULL; node = node->next) {
+		if (strcmp(((ASTNode *) node->value)->token->text, name) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void AST_parallelWritesIn(ListNode *current, List *reductions, List *scalars, List *arrays) {
+	for (; current != NULL; current = current->next) {
+		ASTNode *statement = (ASTNode *) current->value;
+		ASTNode *ident = (ASTNode *) List_first(statement->children);
+		switch (statement->token->type) {
+			case PRINT:
+				AST_parallelAbort(statement, "%s can not be used in a PARALLEL FOR, its iterations run in no fixed order.", "PRINT");
+				break;
+			case INPUT:
+				AST_parallelAbort(statement, "%s can not be used in a PARALLEL FOR, its iterations run in no fixed order.", "INPUT");
+				break;
+			case LABEL:
+			case GOTO:
+				AST_parallelAbort(statement, "%s can not be used in a PARALLEL FOR.", statement->token->text);
+				break;
+			case FOR:
+				if (statement->subType == PARALLEL)
+					AST_parallelAbort(statement, "A %s can not be nested in another one.", "PARALLEL FOR");
+				// fall through
+			case LET:
+				if (AST_isArray(AST_getSymbolType(ident->token->text)))
+					AST_name(arrays, ident->token->text);
+				else if (!AST_reduces(reductions, ident->token->text))
+					AST_name(scalars, ident->token->text);
+				break;
+			default:
+				break;
+		}
+		AST_parallelWritesIn(AST_body(statement), reductions, scalars, arrays);
+	}
+}
+
+// what the body of a PARALLEL FOR sets, its own loop variable left out
+void AST_parallelWrites(ASTNode *loop, List *scalars, List *arrays) {
+	List *reductions = ((ASTNode *) List_first(loop->children))->children;
+	AST_parallelWritesIn(AST_body(loop), reductions, scalars, arrays);
+}
+
+static int AST_mentions(ASTNode *node, char *name) {
+	if (node->token->type == IDENT && strcmp(node->token->text, name) == 0)
+		return 1;
+	LIST_FOREACH(node->children, first, next, cur) {
+		if (AST_mentions((ASTNode *) cur->value, name))
+			return 1;
+	}
+	return 0;
+}
+
+// an array element another iteration writes is read only at [counter]
+static void AST_parallelIndex(ASTParallel *p, ASTNode *ident) {
+	ASTNode *index = (ASTNode *) List_first(ident->children);
+	if (index->token->type != IDENT || strcmp(index->token->text, p->counter) != 0)
+		AST_parallelAbort(ident, "%s is written in this PARALLEL FOR, so it can only be indexed by the loop variable.", ident->token->text);
+}
+
+// what an expression reads, with set holding the scalars this iteration has
+// set on every path so far, and reduction the one it may add to
+static void AST_parallelReads(ASTParallel *p, ASTNode *node, List *set, char *reduction) {
+	if (node->subType == STRING_VAR || node->token->type == STRING)
+		AST_parallelAbort(node, "%s can not be used in a PARALLEL FOR.", "Strings");
+	if (node->token->type == IDENT) {
+		char *name = node->token->text;
+		if (AST_isArray(AST_getSymbolType(name))) {
+			if (AST_named(p->arrays, name))
+				AST_parallelIndex(p, node);
+		} else if (AST_named(p->reductions, name)) {
+			if (reduction == NULL || strcmp(name, reduction) != 0)
+				AST_parallelAbort(node, "%s is a REDUCE variable, the PARALLEL FOR can only add to it.", name);
+		} else if (AST_named(p->scalars, name) && !AST_named(set, name)) {
+			AST_parallelAbort(node, "%s is read before this iteration of the PARALLEL FOR sets it, which would share it between iterations.", name);
+		}
+	}
+	LIST_FOREACH(node->children, first, next, cur) {
+		AST_parallelReads(p, (ASTNode *) cur->value, set, reduction);
+	}
+}
+
+// LET r = r + x or LET r = r - x, with x not reading r
+static void AST_parallelReduction(ASTParallel *p, ASTNode *statement, List *set) {
+	ASTNode *ident = (ASTNode *) List_first(statement->children);
+	ASTNode *value = (ASTNode *) List_last(statement->children);
+	char *name = ident->token->text;
+	ASTItem **items = AST_flatten(value);
+	int added = (value->token->type == PLUS || value->token->type == MINUS)
+		&& items[0]->kind == AST_ITEM_VALUE && items[0]->node->token->type == IDENT
+		&& strcmp(items[0]->node->token->text, name) == 0
+		&& (items[1]->node->token->type == PLUS || items[1]->node->token->type == MINUS);
+	int i;
+	for (i = 1; added && items[i] != NULL; i++) {
+		if (items[i]->kind == AST_ITEM_VALUE && AST_mentions(items[i]->node, name))
+			added = 0;
+	}
+	AST_killItems(items);
+	// an INT plus a FLOAT is truncated as a whole, which depends on r
+	if (!added || (ident->subType == INT_VAR && value->subType != INT_VAR))
+		AST_parallelAbort(statement, "%s is a REDUCE variable, it can only be set to itself plus or minus what the iteration adds.", name);
+	AST_parallelReads(p, value, set, name);
+}
+
+static void AST_parallelStatements(ASTParallel *p, ListNode *current, ListNode *end, List *set);
+
+// the scalars set on every path through an IF, ELSEIF or ELSE and the arms
+// that follow it
+static List *AST_parallelArms(ASTParallel *p, ASTNode *statement, List *set) {
+	ListNode *current = statement->children->first;
+	ListNode *end = NULL;
+	if (statement->token->type != ELSE) {
+		AST_parallelReads(p, (ASTNode *) current->value, set, NULL);
+		current = current->next;
+		TokenType tail = ((ASTNode *) List_last(statement->children))->token->type;
+		if (tail == ELSEIF || tail == ELSE)
+			end = statement->children->last;
+	}
+	List *arm = AST_copyNames(set);
+	AST_parallelStatements(p, current, end, arm);
+	if (statement->token->type == ELSE)
+		return arm;
+	// without an ELSE, no arm may run at all
+	List *rest = end != NULL ? AST_parallelArms(p, (ASTNode *) end->value, set) : AST_copyNames(set);
+	List *every = AST_parallelList();
+	ListNode *node;
+	for (node = arm->first; node != NULL; node = node->next) {
+		if (AST_named(rest, (char *) node->value))
+			List_push(every, node->value);
+	}
+	return every;
+}
+
+static void AST_parallelStatement(ASTParallel *p, ASTNode *statement, List *set) {
+	ASTNode *ident = (ASTNode *) List_first(statement->children);
+	ListNode *node;
+	List *inner;
+	switch (statement->token->type) {
+		case LET:
+			if (strcmp(ident->token->text, p->counter) == 0)
+				AST_parallelAbort(statement, "%s can not be set inside its own PARALLEL FOR.", p->counter);
+			if (AST_named(p->reductions, ident->token->text)) {
+				AST_parallelReduction(p, statement, set);
+				break;
+			}
+			AST_parallelReads(p, (ASTNode *) List_last(statement->children), set, NULL);
+			if (AST_isArray(AST_getSymbolType(ident->token->text)))
+				AST_parallelIndex(p, ident);
+			else
+				AST_name(set, ident->token->text);
+			break;
+
+		case IF:
+			inner = AST_parallelArms(p, statement, set);
+			for (node = inner->first; node != NULL; node = node->next)
+				AST_name(set, (char *) node->value);
+			break;
+
+		case WHILE:
+			AST_parallelReads(p, ident, set, NULL);
+			inner = AST_copyNames(set);
+			AST_parallelStatements(p, AST_body(statement), NULL, inner);
+			break;
+
+		case FOR:
+			if (strcmp(ident->token->text, p->counter) == 0)
+				AST_parallelAbort(statement, "%s can not be set inside its own PARALLEL FOR.", p->counter);
+			if (AST_named(p->reductions, ident->token->text))
+				AST_parallelAbort(statement, "%s is a REDUCE variable, the PARALLEL FOR can only add to it.", ident->token->text);
+			node = statement->children->first->next;
+			AST_parallelReads(p, (ASTNode *) node->value, set, NULL);
+			// the loop sets its variable even when its body never runs
+			AST_name(set, ident->token->text);
+			AST_parallelReads(p, (ASTNode *) node->next->value, set, NULL);
+			inner = AST_copyNames(set);
+			AST_parallelStatements(p, AST_body(statement), NULL, inner);
+			break;
+
+		default:
+			break;
+	}
+}
+
+// statements from current up to, not including, end
+static void AST_parallelStatements(ASTParallel *p, ListNode *current, ListNode *end, List *set) {
+	for (; current != end; current = current->next)
+		AST_parallelStatement(p, (ASTNode *) current->value, set);
+}
+
+void AST_checkParallel(ASTNode *loop) {
+	ASTNode *ident = (ASTNode *) List_first(loop->children);
+	ASTNode *bound = (ASTNode *) loop->children->first->next->next->value;
+	ASTParallel p = { ident->token->text, AST_parallelList(), AST_parallelList(), AST_parallelList() };
+	if (ident->subType != INT_VAR)
+		AST_abort("The loop variable of a PARALLEL FOR has to be an INT.");
+	if (bound->subType != INT_VAR)
+		AST_abort("The TO of a PARALLEL FOR has to be an INT.");
+	ListNode *node;
+	for (node = ident->children->first; node != NULL; node = node->next) {
+		ASTNode *reduction = (ASTNode *) node->value;
+		reduction->subType = AST_getSymbolType(reduction->token->text);
+		if (reduction->subType != INT_VAR && reduction->subType != FLOAT_VAR)
+			AST_parallelAbort(loop, "%s can not be a REDUCE variable, only an INT or a FLOAT can.", reduction->token->text);
+		if (strcmp(reduction->token->text, p.counter) == 0 || AST_named(p.reductions, reduction->token->text))
+			AST_parallelAbort(loop, "%s can not be a REDUCE variable of this PARALLEL FOR.", reduction->token->text);
+		List_push(p.reductions, reduction->token->text);
+	}
+	AST_parallelWrites(loop, p.scalars, p.arrays);
+
+	// the bound is worked out once instead of after every iteration, so it
+	// may not read anything the loop changes
+	List *changed[] = { p.scalars, p.arrays, p.reductions };
+	int i;
+	if (AST_mentions(bound, p.counter))
+		AST_parallelAbort(loop, "The TO of a PARALLEL FOR can not read %s, which the loop changes.", p.counter);
+	for (i = 0; i < 3; i++) {
+		for (node = changed[i]->first; node != NULL; node = node->next) {
+			if (AST_mentions(bound, (char *) node->value))
+				AST_parallelAbort(loop, "The TO of a PARALLEL FOR can not read %s, which the loop changes.", (char *) node->value);
+		}
+	}
+
+	List *set = AST_parallelList();
+	AST_parallelStatements(&p, AST_body(loop), NULL, set);
+	// the range holding the last iteration writes back what its own copy
+	// holds, which is only what a serial run leaves when the last iteration
+	// set it
+	for (node = p.scalars->first; node != NULL; node = node->next) {
+		if (!AST_named(set, (char *) node->value))
+			AST_parallelAbort(loop, "%s is not set on every path through an iteration of this PARALLEL FOR, so what it holds after the loop would depend on which thread ran last.", (char *) node->value);
+	}
+	AST_parallelDone(astGlobal);
+}
+
 TokenType AST_checkComparison(ASTNode *comparison) {
 	if (!AST_isComparisonOperator(comparison->token->type)) {
 		// it's not a comparison, it's either TRUE, FALSE, or an expression.
@@ -232,7 +593,7 @@ TokenType AST_checkExpression(ASTNode *expression) {
 		|| expression->token->type == SLASH)) {
 		switch (expression->token->type) {
 			case IDENT:
-				expression->subType = AST_getSymbolType(expression->token->text);
+				expression->subType = AST_checkVariable(expression);
 				break;
 			case STRING:
 				expression->subType = STRING_VAR;
@@ -250,6 +611,8 @@ TokenType AST_checkExpression(ASTNode *expression) {
 				AST_abort("checkExpression how did I get here?");
 				break;
 		}
+		if (expression->subType == STRING_VAR)
+			astGlobal->seenString = 1;
 		return expression->subType;
 	}
 
@@ -267,6 +630,23 @@ TokenType AST_checkExpression(ASTNode *expression) {
 	return expression->subType;
 }
 
+// the type of a variable as used, for an array that is the type of one
+// element, whose index has to be an INT
+TokenType AST_checkVariable(ASTNode *ident) {
+	TokenType type = AST_getSymbolType(ident->token->text);
+	if (!AST_isArray(type))
+		return type;
+	if (List_count(ident->children) != 1)
+		AST_abort("Array used without an index.");
+	if (AST_checkExpression((ASTNode *) List_first(ident->children)) != INT_VAR)
+		AST_abort("Array index must be an INT.");
+	return type == INT_ARRAY ? INT_VAR : FLOAT_VAR;
+}
+
+int AST_isArray(TokenType type) {
+	return type == INT_ARRAY || type == FLOAT_ARRAY;
+}
+
 TokenType AST_getSubType(TokenType type1, TokenType type2, TokenType operation) {
 	switch (operation) {
 		case PLUS:
@@ -274,6 +654,8 @@ TokenType AST_getSubType(TokenType type1, TokenType type2, TokenType operation)
 				return INT_VAR;
 			else if ((type1 == INT_VAR || type1 == FLOAT_VAR) && (type2 == INT_VAR || type2 == FLOAT_VAR))
 				return FLOAT_VAR;
+			else if (type1 == STRING_VAR && type2 == STRING_VAR)
+				return STRING_VAR;
 			else
 				AST_abort("Invalid types in operation.");
 			break;
@@ -306,7 +688,7 @@ TokenType AST_getSubType(TokenType type1, TokenType type2, TokenType operation)
 			else if (type1 == BOOL_VAR && type2 == BOOL_VAR)
 				return BOOL_VAR;
 			else if (type1 == STRING_VAR && type2 == STRING_VAR)
-				return STRING_VAR;
+				return BOOL_VAR;
 			else
 				AST_abort("Invalid types in equals/not equals comparison.");
 			break;
@@ -333,54 +715,56 @@ TokenType AST_getSubType(TokenType type1, TokenType type2, TokenType operation)
 	return eOF;
 }
 
-void AST_emit(AST *ast) {
-	Emitter_emitLine("#include <stdio.h>");
-	Emitter_emitLine("#include <stdlib.h>");
-	Emitter_emitLine("#include <string.h>");
-	Emitter_emitLine("");
-	Emitter_emitLine("int main (void) {");
-
-	AST_emitSymbolHeaders(ast->symbols);
-	if (ast->seenStrInput)
-		Emitter_emitLine("size_t len = 0;");
-
-	LIST_FOREACH(ast->children, first, next, cur) {
-		AST_statement((ASTNode *) cur->value);
-	}
-
-	AST_emitSymbolFrees(ast->symbols);
-
-	Emitter_emitLine("return 0;");
-	Emitter_emitLine("}");
-}
-
-void AST_emitSymbolHeaders(List *symbols) {
-	LIST_FOREACH(symbols, first, next, cur) {
-		Symbol *s = (Symbol *) cur->value;
-		if (s->type == FLOAT_VAR)
-			Emitter_emit("float ");
-		else if (s->type == INT_VAR)
-			Emitter_emit("int ");
-		else if (s->type == BOOL_VAR)
-			Emitter_emit("int ");	
-		else if (s->type == STRING_VAR)
-			Emitter_emit("char *");
-		Emitter_emit(s->text);
-		Emitter_emitLine(";");
-	}
-}
-
 void AST_emitSymbolFrees(List *symbols) {
 	LIST_FOREACH(symbols, first, next, cur) {
 		Symbol *s = (Symbol *) cur->value;
 		if (s->type == STRING_VAR) {
 			Emitter_emit("free(");
 			Emitter_emit(s->text);
-			Emitter_emitLine(");");
+			Emitter_emitLine(".buf);");
 		}
 	}
 }
 
+// every distinct literal is emitted once, with its length and hash worked
+// out here instead of at run time
+void AST_emitStringLiterals(List *literals) {
+	if (List_count(literals) == 0)
+		return;
+	char temp[64];
+	Emitter_headerLine("static const tt_str tt_lits[] = {");
+	LIST_FOREACH(literals, first, next, cur) {
+		char *text = (char *) cur->value;
+		Emitter_header("\t{ \"");
+		Emitter_header(text);
+		sprintf(temp, "\", %zu, NULL, 0, %uu },", strlen(text), AST_hashString(text));
+		Emitter_headerLine(temp);
+	}
+	Emitter_headerLine("};");
+}
+
+// returns the literal's index in tt_lits, adding it the first time it is seen
+int AST_internString(AST *ast, char *text) {
+	int index = 0;
+	LIST_FOREACH(ast->stringLiterals, first, next, cur) {
+		if (strcmp((char *) cur->value, text) == 0)
+			return index;
+		index++;
+	}
+	List_push(ast->stringLiterals, strdup(text));
+	return index;
+}
+
+// FNV-1a, never 0 since the runtime uses 0 for an unknown hash
+unsigned int AST_hashString(char *text) {
+	unsigned int hash = 2166136261u;
+	while (*text != '\0') {
+		hash ^= (unsigned char) *text++;
+		hash *= 16777619u;
+	}
+	return hash == 0 ? 1 : hash;
+}
+
 void AST_kill(AST *ast) {
 	if (ast == NULL) {
 		return;
@@ -389,11 +773,26 @@ void AST_kill(AST *ast) {
 		ASTNode_kill((ASTNode *) cur->value);
         cur->value = NULL;
 	}
+	// nodes left over from a statement an error stopped, their children
+	// are on the list as well so each is freed on its own
+	while (ast->nodes.nextNode != &ast->nodes) {
+		ASTNode *node = ast->nodes.nextNode;
+		ast->nodes.nextNode = node->nextNode;
+		Token_kill(node->token);
+		List_destroy(node->children);
+		Mem_remove(MEM_AST, node);
+		free(node);
+	}
 	AST_killSymbols(ast);
 	List_destroy(ast->symbols);
 	List_clear_destroy(ast->labelsDeclared);
 	List_clear_destroy(ast->labelsGotoed);
+	List_clear_destroy(ast->stringLiterals);
+	AST_parallelDone(ast);
+	List_destroy(ast->checking);
 	List_destroy(ast->children);
+	if (astGlobal == ast)
+		astGlobal = NULL;
 	free(ast);
 }
 
@@ -405,201 +804,11 @@ void AST_killSymbols(AST *ast) {
 
 }
 
-// TODO: fix with type checking
-void AST_statement(ASTNode *statement) {
-	ASTNode *temp = NULL;
-	ASTNode *temp2 = NULL;
-	switch (statement->token->type) {
-		// statement.children = List(comparison)
-		case PRINT:
-			temp = (ASTNode *) (List_pop(statement->children));
-
-			if (temp->subType == BOOL_VAR) {
-				Emitter_emit("printf((");
-				AST_comparison(temp);	
-				Emitter_emit(") == 0 ? \"FALSE\\n\" : \"TRUE\\n\");");
-				break;
-			}
-
-			Emitter_emit("printf(\"%");
-			if (temp->subType == INT_VAR)
-				Emitter_emit("d\\n\", (");
-			else if (temp->subType == STRING_VAR)
-				Emitter_emit("s\\n\", (");
-			else
-				Emitter_emit(".2f\\n\", (");
-			AST_comparison(temp);
-
-			Emitter_emitLine("));");
-			break;
-			
-		// statement.children = List(comparison, {statement}, [ELSEIF | ELSE])
-		// else	   ::= statement.children = {statement}
-		// overflow on purpose!
-		case IF:
-		case ELSEIF:
-			Emitter_emit("if(");
-			temp = (ASTNode *) (List_shift(statement->children));
-			AST_comparison(temp);
-			Emitter_emitLine("){");
-			ASTNode_kill(temp);
-
-			temp = (ASTNode *) List_shift(statement->children);
-			while (temp != NULL && temp->token->type != ELSEIF && temp->token->type != ELSE) {
-				AST_statement(temp);
-				ASTNode_kill(temp);
-				temp = List_shift(statement->children);
-			}
-			
-			if (temp != NULL && temp->token->type == ELSEIF) {
-				Emitter_emit("} else ");
-				AST_statement(temp); // ELSEIF == IF
-			} else if (temp != NULL && temp->token->type == ELSE){
-				Emitter_emitLine("} else {");
-				while (temp->children->first != NULL) {
-					temp2 = (ASTNode *) List_shift(temp->children);
-					AST_statement(temp2);
-					ASTNode_kill(temp2);
-					temp2 = NULL;
-				}
-				Emitter_emitLine("}");
-			} else {
-				Emitter_emitLine("}");
-			}
-
-			break;
-		
-		// statement.children = List(comparison, {statement})
-		case WHILE:
-			Emitter_emit("while (");
-			temp = (ASTNode *) List_shift(statement->children);
-			AST_comparison(temp);
-			Emitter_emitLine(") {");
-
-			while (statement->children->first != NULL) {
-				temp2 = (ASTNode *) List_shift(statement->children);
-				AST_statement(temp2);
-				ASTNode_kill(temp2);
-				temp2 = NULL;
-			}
-			Emitter_emitLine("}");
-			break;
-		
-		// statement.children = List(IDENT, expression, expression, {statement});
-		case FOR:
-			Emitter_emit("for (");
-			temp = (ASTNode *) List_shift(statement->children);
-			Emitter_emit(temp->token->text);
-			Emitter_emit(" = ");
-
-			temp2 = (ASTNode *) List_shift(statement->children);
-			AST_expression(temp2);
-			Emitter_emit("; ");
-			Emitter_emit(temp->token->text);
-			Emitter_emit(" <= ");
-			
-			ASTNode_kill(temp2);
-			temp2 = (ASTNode *) List_shift(statement->children);
-			AST_expression(temp2);
-
-			Emitter_emit("; ");
-			Emitter_emit(temp->token->text);
-			Emitter_emitLine("++) {");
-			ASTNode_kill(temp2);
-            temp2 = NULL;
-
-			while (statement->children->first != NULL) {
-				temp2 = (ASTNode *) List_shift(statement->children);
-				AST_statement(temp2);
-				ASTNode_kill(temp2);
-				temp2 = NULL;
-			}
-			Emitter_emitLine("}");
-
-
-			break;
-
-		// statement.children = List(IDENT)
-		case LABEL:
-			temp = (ASTNode *) List_shift(statement->children);
-			Emitter_emit(temp->token->text);
-			Emitter_emitLine(":");
-			break;
-
-		// statement.children = List(IDENT)
-		case GOTO:
-			Emitter_emit("goto ");
-			temp = (ASTNode *) List_shift(statement->children);
-			Emitter_emit(temp->token->text);
-			Emitter_emitLine(";");
-			break;
-
-		// statement.children = List(IDENT, comparison)
-		case LET:
-			temp = (ASTNode *) List_shift(statement->children);
-			Emitter_emit(temp->token->text);
-			Emitter_emit(" = ");
-
-			temp2 = (ASTNode *) List_shift(statement->children);
-			if (AST_getSymbolType(temp->token->text) == STRING_VAR) {
-				Emitter_emit("strdup(");
-				AST_comparison(temp2);
-				Emitter_emitLine(");");
-				break;
-			}
-
-			AST_comparison(temp2);
-			if (AST_getSymbolType(temp->token->text) == BOOL_VAR)
-				Emitter_emit(" == 0 ? 0 : 1");
-			Emitter_emitLine(";");
-			break;
-
-		// statement.children = List(IDENT)
-		case INPUT:
-			temp = (ASTNode *) List_shift(statement->children);
-			TokenType symType = AST_getSymbolType(temp->token->text); 
-			if (symType == STRING_VAR) {
-				Emitter_emitLine("while (getchar() != '\\n' && getchar() != EOF);");
-				Emitter_emit("getline(&");
-				Emitter_emit(temp->token->text);
-				Emitter_emitLine(", &len, stdin);");
-				break;
-			}
-
-			Emitter_emit("if(0 == scanf(\"%");
-			if (symType == INT_VAR || symType == BOOL_VAR)
-				Emitter_emit("d\", &");
-			else  // FLOAT_VAR
-				Emitter_emit("f\", &");
-
-			Emitter_emit(temp->token->text);
-			Emitter_emitLine(")) {");
-			Emitter_emit(temp->token->text);
-			Emitter_emitLine(" = 0;");
-			Emitter_emit("scanf(\"%");
-			Emitter_emitLine("*s\");");
-			Emitter_emitLine("}");
-			if (AST_getSymbolType(temp->token->text) == BOOL_VAR) {
-				Emitter_emit(temp->token->text);
-				Emitter_emit(" = ");
-				Emitter_emit(temp->token->text);
-				Emitter_emitLine(" == 0 ? 0 : 1;");
-			}
-			break;
-
-		default:
-			AST_abort("checkStatement how did I get here?");
-			break;
-	}
-	if (temp != NULL) {
-		ASTNode_kill(temp);
-        temp = NULL;
-	}
-	if (temp2 != NULL) {
-		ASTNode_kill(temp2);
-        temp2 = NULL;
-	}
-
+int AST_isConstantPrint(ASTNode *statement) {
+	if (statement->token->type != PRINT)
+		return 0;
+	ASTNode *printed = (ASTNode *) List_first(statement->children);
+	return printed->token->type == STRING;
 }
 
 int AST_isComparisonOperator(TokenType t) {
@@ -611,80 +820,78 @@ int AST_isComparisonOperator(TokenType t) {
 		|| t == GTEQ);
 }
 
-//  if comparison->token->text is a comparison operator:
-//		comparison ::= comparison.children = comparison | expression, comparison | expression
-// 	else:
-//  	comparison ::= comparison.children = ()
-void AST_comparison(ASTNode *comparison) {
-	if (!AST_isComparisonOperator(comparison->token->type)) {
-		// could be TRUE or FALSE
-		if (comparison->token->type == TRUE)
-			Emitter_emit("1");
-		else if (comparison->token->type == FALSE)
-			Emitter_emit("0");
-		else
-			AST_expression(comparison);
-		return;
+// the expression in the order it was written, NULL terminated
+ASTItem **AST_flatten(ASTNode *node) {
+	List *flat = List_create();
+	AST_flattenInto(node, flat);
+	ASTItem **items = malloc(sizeof(ASTItem *) * (List_count(flat) + 1));
+	int count = 0;
+	LIST_FOREACH(flat, first, next, cur) {
+		items[count++] = (ASTItem *) cur->value;
 	}
+	items[count] = NULL;
+	List_destroy(flat);
+	return items;
+}
 
-	ASTNode *child1 = (ASTNode *) List_shift(comparison->children);
-	ASTNode *child2 = (ASTNode *) List_shift(comparison->children);
-
-	if (child1->subType == STRING_VAR) {
-		// we're comparing two strings
-		Emitter_emit("strcmp(");
-		AST_comparison(child1);
-		Emitter_emit(", ");
-		AST_comparison(child2);
-		Emitter_emit(") ");
-		Emitter_emit(comparison->token->text);
-		Emitter_emit(" 0");
-	} else {
-		AST_comparison(child1);
-		Emitter_emit(comparison->token->text);
-		AST_comparison(child2);
-	}
-
-	ASTNode_kill(child1);
-	ASTNode_kill(child2);
-}
-
-//  if expression->token->text is an operator:
-// 		expression.children = List(["("], expression, expression)
-// 	else:
-// 		expression.children = List()
-void AST_expression(ASTNode *expression) {
-	if (expression->token->type == STRING) {
-		Emitter_emit("\"");
-		Emitter_emit(expression->token->text);
-		Emitter_emit("\"");
+static void AST_item(List *items, ASTItemKind kind, ASTNode *node) {
+	ASTItem *item = malloc(sizeof(ASTItem));
+	item->kind = kind;
+	item->node = node;
+	List_push(items, item);
+}
+
+void AST_flattenInto(ASTNode *node, List *items) {
+	TokenType type = node->token->type;
+	int arithmetic = type == PLUS || type == MINUS || type == ASTERISK || type == SLASH;
+	if (!(arithmetic || AST_isComparisonOperator(type))
+			|| (type == PLUS && node->subType == STRING_VAR)) {
+		AST_item(items, AST_ITEM_VALUE, node);
 		return;
-	} else if (!(expression->token->type == PLUS
-		|| expression->token->type == MINUS
-		|| expression->token->type == ASTERISK 
-		|| expression->token->type == SLASH)) {
-		Emitter_emit(expression->token->text);
+	}
+
+	ListNode *child = node->children->first;
+	if (AST_isComparisonOperator(type) && ((ASTNode *) child->value)->subType == STRING_VAR) {
+		// tt_str_eq(a, b) is a call, so it is a single value
+		AST_item(items, AST_ITEM_VALUE, node);
 		return;
 	}
-	ASTNode *child1 = (ASTNode *) List_shift(expression->children);
-	int paren = 0;
-	if (child1->token->type == LEFTPAREN) {
-		Emitter_emit("(");
-		paren = 1;
-		child1 = (ASTNode *) List_shift(expression->children);
+	int paren = ((ASTNode *) child->value)->token->type == LEFTPAREN;
+	if (paren) {
+		AST_item(items, AST_ITEM_OPEN, NULL);
+		child = child->next;
 	}
-	ASTNode *child2 = (ASTNode *) List_shift(expression->children);
+	AST_flattenInto((ASTNode *) child->value, items);
+	AST_item(items, AST_ITEM_OPERATOR, node);
+	AST_flattenInto((ASTNode *) child->next->value, items);
+	if (paren)
+		AST_item(items, AST_ITEM_CLOSE, NULL);
+}
 
-	AST_expression(child1);
-	Emitter_emit(expression->token->text);
-	AST_expression(child2);
+void AST_killItems(ASTItem **items) {
+	int i;
+	for (i = 0; items[i] != NULL; i++)
+		free(items[i]);
+	free(items);
+}
 
-	if (paren == 1) {
-		Emitter_emit(")");
+// C's binding strength of the operators a flattened expression can hold
+int AST_precedence(TokenType operation) {
+	switch (operation) {
+		case EQEQ:
+		case NOTEQ:
+			return 1;
+		case LT:
+		case LTEQ:
+		case GT:
+		case GTEQ:
+			return 2;
+		case PLUS:
+		case MINUS:
+			return 3;
+		default:
+			return 4;
 	}
-
-	ASTNode_kill(child1);
-	ASTNode_kill(child2);
 }
 
 int AST_seenSymbol(AST *ast, char *name) {
@@ -700,10 +907,19 @@ int AST_seenSymbol(AST *ast, char *name) {
 void AST_addSymbol(AST *ast, char *text, TokenType type) {
 	Symbol *s = malloc(sizeof(Symbol));
 	s->text = strdup(text);
+	Mem_add(MEM_SYMBOLS, s);
+	Mem_add(MEM_SYMBOLS, s->text);
 	s->type = type;
+	s->size = 0;
 	List_push(ast->symbols, s);
 }
 
+void AST_addArray(AST *ast, char *text, TokenType type, int size) {
+	AST_addSymbol(ast, text, type);
+	((Symbol *) List_last(ast->symbols))->size = size;
+	ast->seenArray = 1;
+}
+
 TokenType AST_getSymbolType(char *text) {
 	LIST_FOREACH(astGlobal->symbols, first, next, cur) {
 		Symbol *c = (Symbol *) cur->value;
@@ -717,6 +933,8 @@ TokenType AST_getSymbolType(char *text) {
 void Symbol_kill(Symbol *s) {
 	if (s == NULL)
 		return;
+	Mem_remove(MEM_SYMBOLS, s->text);
+	Mem_remove(MEM_SYMBOLS, s);
 	free(s->text);
 	free(s);
 }
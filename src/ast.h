@@ -13,6 +13,10 @@ typedef struct ASTNode {
 	List *children;
 	TokenType subType;
 	int lineNumber;
+	// every node of an AST is on its list, in the tree yet or not, so an
+	// error part way through a statement frees what was built of it
+	struct ASTNode *prevNode;
+	struct ASTNode *nextNode;
 } ASTNode;
 
 typedef struct AST {
@@ -20,61 +24,107 @@ typedef struct AST {
 	List *symbols;
 	List *labelsDeclared;
 	List *labelsGotoed;
+	List *stringLiterals;
 	Lexer *lex;
+	int seenInput;
 	int seenStrInput;
+	int seenString;
+	int seenArray;
+	int stringTemps;
 	int currentLineNumber;
+	// the lists checking a PARALLEL FOR holds, freed with the AST when an
+	// error ends the check
+	List *checking;
+	// the head of the list of every node
+	ASTNode nodes;
 } AST;
 
 
+// The parser does not give expressions C's precedence or associativity (a - b
+// - c is parsed as a - (b - c)), the first C backend printed them as text and
+// let the C compiler bind them. Every backend now flattens an expression back
+// into that text order and binds it with C's precedence.
+typedef enum ASTItemKind {
+	AST_ITEM_VALUE = 0,
+	AST_ITEM_OPERATOR = 1,
+	AST_ITEM_OPEN = 2,
+	AST_ITEM_CLOSE = 3
+} ASTItemKind;
+
+typedef struct ASTItem {
+	ASTItemKind kind;
+	ASTNode *node;
+} ASTItem;
+
 typedef struct Symbol {
 	char *text;
 	TokenType type;
+	// elements of an INT_ARRAY or FLOAT_ARRAY
+	int size;
 } Symbol;
 
 AST *AST_create(Lexer *lex);
 
 ASTNode *ASTNode_create(Token *t);
 
+ASTNode *AST_createNode(AST *ast, Token *t, int line);
+
 void AST_abort(const char *message);
 
 void ASTNode_add(ASTNode *parent, ASTNode *child);
 
 void AST_add(AST *parent, ASTNode *child);
 
-void AST_emitSymbolHeaders(List *symbols);
-
 void AST_emitSymbolFrees(List *symbols);
 
+void AST_emitStringLiterals(List *literals);
+
+int AST_internString(AST *ast, char *text);
+
+unsigned int AST_hashString(char *text);
+
 void ASTNode_kill(ASTNode *node);
 
 void AST_check(AST *ast);
 
 void AST_checkStatement(ASTNode *node);
 
+void AST_checkParallel(ASTNode *loop);
+
+void AST_parallelWrites(ASTNode *loop, List *scalars, List *arrays);
+
 TokenType AST_checkComparison(ASTNode *node);
 
 TokenType AST_checkExpression(ASTNode *node);
 
 TokenType AST_getSubType(TokenType type1, TokenType type2, TokenType operation);
 
-void AST_emit(AST *ast);
+TokenType AST_checkVariable(ASTNode *ident);
+
+int AST_isArray(TokenType type);
 
 void AST_kill(AST *ast);
 
 void AST_killSymbols(AST *ast);
 
-void AST_statement(ASTNode *statement);
+int AST_isConstantPrint(ASTNode *statement);
 
 int AST_isComparisonOperator(TokenType t);
 
-void AST_comparison(ASTNode *comparison);
+ASTItem **AST_flatten(ASTNode *node);
 
-void AST_expression(ASTNode *expression);
+void AST_flattenInto(ASTNode *node, List *items);
+
+void AST_killItems(ASTItem **items);
+
+int AST_precedence(TokenType operation);
 
 int AST_seenSymbol(AST *ast, char *name);
 
 void AST_addSymbol(AST *ast, char *text, TokenType type);
 
+void AST_addArray(AST *ast, char *text, TokenType type, int size);
+
 void Symbol_kill(Symbol *s);
 
 TokenType AST_getSymbolType(char *text);
@@ -0,0 +1,231 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "astfile.h"
+#include "diagnostic.h"
+
+// strings written so far, each only once
+typedef struct ASTFileStrings {
+	char *bytes;
+	uint32_t length;
+	uint32_t capacity;
+	uint32_t *slots;
+	uint32_t slotCount;
+} ASTFileStrings;
+
+static void ASTFile_fail(const char *format, char *path) {
+	char message[DIAGNOSTIC_LENGTH];
+	snprintf(message, sizeof(message), format, path);
+	Diagnostic_raise(0, message);
+}
+
+static void *ASTFile_allocate(size_t count, size_t size) {
+	void *memory = calloc(count + 1, size);
+	if (memory == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for the AST file.");
+	return memory;
+}
+
+// the string's offset, slots hold offsets + 1 so 0 is empty
+static uint32_t ASTFile_string(ASTFileStrings *strings, char *text) {
+	uint32_t slot = AST_hashString(text) & (strings->slotCount - 1);
+	while (strings->slots[slot] != 0) {
+		if (strcmp(strings->bytes + strings->slots[slot] - 1, text) == 0)
+			return strings->slots[slot] - 1;
+		slot = (slot + 1) & (strings->slotCount - 1);
+	}
+	uint32_t length = strlen(text) + 1;
+	if (strings->length + length > strings->capacity) {
+		while (strings->length + length > strings->capacity)
+			strings->capacity = strings->capacity == 0 ? 4096 : strings->capacity * 2;
+		strings->bytes = realloc(strings->bytes, strings->capacity);
+		if (strings->bytes == NULL)
+			Diagnostic_raise(0, "Unable to allocate memory for the AST file.");
+	}
+	uint32_t offset = strings->length;
+	memcpy(strings->bytes + offset, text, length);
+	strings->length += length;
+	strings->slots[slot] = offset + 1;
+	return offset;
+}
+
+static uint32_t ASTFile_count(List *nodes) {
+	uint32_t count = 0;
+	LIST_FOREACH(nodes, first, next, cur) {
+		count += 1 + ASTFile_count(((ASTNode *) cur->value)->children);
+	}
+	return count;
+}
+
+// appends nodes to order at placed, returns where the next one goes
+static uint32_t ASTFile_place(List *nodes, ASTNode **order, uint32_t placed) {
+	LIST_FOREACH(nodes, first, next, cur) {
+		order[placed++] = cur->value;
+	}
+	return placed;
+}
+
+static void ASTFile_symbols(List *symbols, ASTFileSymbol *written, ASTFileStrings *strings) {
+	uint32_t i = 0;
+	LIST_FOREACH(symbols, first, next, cur) {
+		Symbol *s = cur->value;
+		written[i].text = ASTFile_string(strings, s->text);
+		written[i].type = s->type;
+		written[i].size = s->size;
+		i++;
+	}
+}
+
+void ASTFile_write(AST *ast, char *source, char *path) {
+	ASTFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ASTFILE_MAGIC, sizeof(header.magic));
+	header.version = ASTFILE_VERSION;
+	header.seen = (ast->seenInput ? ASTFILE_SEEN_INPUT : 0) | (ast->seenStrInput ? ASTFILE_SEEN_STR_INPUT : 0)
+		| (ast->seenString ? ASTFILE_SEEN_STRING : 0) | (ast->seenArray ? ASTFILE_SEEN_ARRAY : 0);
+	header.statementCount = List_count(ast->children);
+	header.symbolCount = List_count(ast->symbols);
+	header.nodeCount = ASTFile_count(ast->children);
+
+	// at most every node and symbol has a string of its own
+	ASTFileStrings strings = { NULL, 0, 0, NULL, 16 };
+	while (strings.slotCount < (header.nodeCount + header.symbolCount + 1) * 2)
+		strings.slotCount *= 2;
+	strings.slots = ASTFile_allocate(strings.slotCount, sizeof(uint32_t));
+	header.source = ASTFile_string(&strings, source);
+
+	// breadth first, the children of every node are appended together
+	ASTNode **order = ASTFile_allocate(header.nodeCount, sizeof(ASTNode *));
+	ASTFileNode *nodes = ASTFile_allocate(header.nodeCount, sizeof(ASTFileNode));
+	uint32_t placed = ASTFile_place(ast->children, order, 0);
+	uint32_t i;
+	for (i = 0; i < header.nodeCount; i++) {
+		ASTNode *node = order[i];
+		nodes[i].text = ASTFile_string(&strings, node->token->text);
+		nodes[i].type = node->token->type;
+		nodes[i].subType = node->subType;
+		nodes[i].line = node->lineNumber;
+		nodes[i].childCount = List_count(node->children);
+		nodes[i].children = nodes[i].childCount == 0 ? 0 : placed - i;
+		placed = ASTFile_place(node->children, order, placed);
+	}
+	ASTFileSymbol *symbols = ASTFile_allocate(header.symbolCount, sizeof(ASTFileSymbol));
+	ASTFile_symbols(ast->symbols, symbols, &strings);
+	header.stringBytes = strings.length;
+
+	FILE *file = fopen(path, "wb");
+	int written = file != NULL
+		&& fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(nodes, sizeof(ASTFileNode), header.nodeCount, file) == header.nodeCount
+		&& fwrite(symbols, sizeof(ASTFileSymbol), header.symbolCount, file) == header.symbolCount
+		&& fwrite(strings.bytes, 1, strings.length, file) == strings.length;
+	if (file != NULL && fclose(file) != 0)
+		written = 0;
+	free(order);
+	free(nodes);
+	free(symbols);
+	free(strings.bytes);
+	free(strings.slots);
+	if (!written)
+		ASTFile_fail("Unable to write %s.", path);
+}
+
+static int ASTFile_validType(int32_t type) {
+	return (type >= eOF && type <= STRING) || (type >= LABEL && type <= ARRAY) || (type >= EQ && type <= RIGHTBRACKET);
+}
+
+static int ASTFile_validSubType(int32_t type) {
+	return type == eOF || (type >= NOT_VAR && type <= FLOAT_ARRAY);
+}
+
+// every offset in bounds, and the children of the nodes in order cover the
+// nodes after the statements exactly once, so it is a tree
+static int ASTFile_valid(ASTFileHeader *header, ASTFileNode *nodes, ASTFileSymbol *symbols, char *strings) {
+	if (header->stringBytes == 0 || strings[header->stringBytes - 1] != '\0' || header->source >= header->stringBytes)
+		return 0;
+	if (header->statementCount > header->nodeCount)
+		return 0;
+	uint32_t expected = header->statementCount;
+	uint32_t i;
+	for (i = 0; i < header->nodeCount; i++) {
+		ASTFileNode *node = &nodes[i];
+		if (node->text >= header->stringBytes || !ASTFile_validType(node->type))
+			return 0;
+		// only a FOR can be PARALLEL
+		if (node->subType == PARALLEL ? node->type != FOR : !ASTFile_validSubType(node->subType))
+			return 0;
+		if (node->childCount == 0)
+			continue;
+		// children are always after their parent, so there are no cycles
+		if (node->children == 0 || (uint64_t) i + node->children != expected || node->childCount > header->nodeCount - expected)
+			return 0;
+		expected += node->childCount;
+	}
+	for (i = 0; i < header->symbolCount; i++) {
+		if (symbols[i].text >= header->stringBytes || !ASTFile_validSubType(symbols[i].type))
+			return 0;
+	}
+	return expected == header->nodeCount;
+}
+
+AST *ASTFile_read(char *path, char **source) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		ASTFile_fail("%s could not be opened.", path);
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(ASTFileHeader)) {
+		close(fd);
+		ASTFile_fail("%s is not a teenytiny AST file.", path);
+	}
+	size_t size = info.st_size;
+	char *bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (bytes == MAP_FAILED)
+		ASTFile_fail("%s could not be mapped.", path);
+
+	ASTFileHeader *header = (ASTFileHeader *) bytes;
+	int valid = memcmp(header->magic, ASTFILE_MAGIC, sizeof(header->magic)) == 0
+		&& header->version == ASTFILE_VERSION
+		&& sizeof(ASTFileHeader) + (uint64_t) header->nodeCount * sizeof(ASTFileNode)
+			+ (uint64_t) header->symbolCount * sizeof(ASTFileSymbol) + header->stringBytes == size;
+	ASTFileNode *nodes = (ASTFileNode *) (bytes + sizeof(ASTFileHeader));
+	ASTFileSymbol *symbols = valid ? (ASTFileSymbol *) (nodes + header->nodeCount) : NULL;
+	char *strings = valid ? (char *) (symbols + header->symbolCount) : NULL;
+	if (!valid || !ASTFile_valid(header, nodes, symbols, strings)) {
+		munmap(bytes, size);
+		ASTFile_fail("%s is not a teenytiny AST file of this version.", path);
+	}
+
+	AST *ast = AST_create(NULL);
+	ast->seenInput = (header->seen & ASTFILE_SEEN_INPUT) != 0;
+	ast->seenStrInput = (header->seen & ASTFILE_SEEN_STR_INPUT) != 0;
+	ast->seenString = (header->seen & ASTFILE_SEEN_STRING) != 0;
+	ast->seenArray = (header->seen & ASTFILE_SEEN_ARRAY) != 0;
+	uint32_t i;
+	for (i = 0; i < header->symbolCount; i++) {
+		AST_addSymbol(ast, strings + symbols[i].text, symbols[i].type);
+		((Symbol *) List_last(ast->symbols))->size = symbols[i].size;
+	}
+	// made in file order, a node's parent always comes before it
+	ASTNode **made = ASTFile_allocate(header->nodeCount, sizeof(ASTNode *));
+	for (i = 0; i < header->nodeCount; i++) {
+		Token token = { strings + nodes[i].text, nodes[i].type };
+		made[i] = AST_createNode(ast, &token, nodes[i].line);
+		made[i]->subType = nodes[i].subType;
+		if (i < header->statementCount)
+			AST_add(ast, made[i]);
+	}
+	for (i = 0; i < header->nodeCount; i++) {
+		uint32_t child;
+		for (child = 0; child < nodes[i].childCount; child++)
+			ASTNode_add(made[i], made[i + nodes[i].children + child]);
+	}
+	*source = strdup(strings + header->source);
+	free(made);
+	munmap(bytes, size);
+	return ast;
+}
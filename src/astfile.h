@@ -0,0 +1,60 @@
+#ifndef ASTFILE_H
+#define ASTFILE_H
+
+#include <stdint.h>
+#include "ast.h"
+
+// --emit-ast=file.tta writes the checked AST, --from-ast reads one back in
+// place of lexing, parsing and checking the source. The file is a header,
+// the nodes, the symbols and a string table, in the byte order and integer
+// sizes of the machine that wrote it, and is mapped rather than read. Nodes
+// are laid out breadth first with the top level statements first, so the
+// children of a node are next to each other and a node only has to say how
+// far ahead they start. A file is checked to be a tree with every offset in
+// bounds, not to be a program the checker would pass, it is trusted like an
+// object file.
+
+#define ASTFILE_MAGIC "TEENYAST"
+// written files are refused by any other version, so change it with the AST
+#define ASTFILE_VERSION 1
+
+#define ASTFILE_SEEN_INPUT 1
+#define ASTFILE_SEEN_STR_INPUT 2
+#define ASTFILE_SEEN_STRING 4
+#define ASTFILE_SEEN_ARRAY 8
+
+typedef struct ASTFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t seen;
+	uint32_t nodeCount;
+	uint32_t statementCount;
+	uint32_t symbolCount;
+	uint32_t stringBytes;
+	// the source #line directives name
+	uint32_t source;
+} ASTFileHeader;
+
+typedef struct ASTFileNode {
+	// offsets into the string table
+	uint32_t text;
+	int32_t type;
+	int32_t subType;
+	int32_t line;
+	uint32_t childCount;
+	// nodes from this one to its first child, 0 without children
+	uint32_t children;
+} ASTFileNode;
+
+typedef struct ASTFileSymbol {
+	uint32_t text;
+	int32_t type;
+	int32_t size;
+} ASTFileSymbol;
+
+void ASTFile_write(AST *ast, char *source, char *path);
+
+// the AST and, for the caller to free, the source it was compiled from
+AST *ASTFile_read(char *path, char **source);
+
+#endif
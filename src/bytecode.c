@@ -0,0 +1,606 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+
+Bytecode *Bytecode_create(AST *ast) {
+	Bytecode *bc = calloc(1, sizeof(Bytecode));
+	if (bc == NULL) {
+		printf("Unable to allocate memory for bytecode.\n");
+		exit(1);
+	}
+	bc->ast = ast;
+	bc->freeRegisters = List_create();
+	bc->variables = List_create();
+	bc->constants = List_create();
+	bc->texts = List_create();
+	bc->slots = List_create();
+	bc->labels = List_create();
+	bc->gotos = List_create();
+
+	LIST_FOREACH(ast->symbols, first, next, cur) {
+		Symbol *s = (Symbol *) cur->value;
+		if (AST_isArray(s->type))
+			AST_abort("Arrays are only supported when compiling to C.");
+		BytecodeVariable *v = malloc(sizeof(BytecodeVariable));
+		v->name = strdup(s->text);
+		v->type = s->type;
+		if (s->type == STRING_VAR)
+			v->reg = Bytecode_slot(bc, NULL);
+		else
+			v->reg = Bytecode_register(bc);
+		List_push(bc->variables, v);
+	}
+	return bc;
+}
+
+// labels, variables, constants and texts all start with their own string
+static void Bytecode_killNamed(List *list) {
+	LIST_FOREACH(list, first, next, cur) {
+		free(*(char **) cur->value);
+	}
+	List_clear_destroy(list);
+}
+
+void Bytecode_kill(Bytecode *bc) {
+	if (bc == NULL)
+		return;
+	free(bc->code);
+	free(bc->registers);
+	List_clear_destroy(bc->freeRegisters);
+	Bytecode_killNamed(bc->variables);
+	Bytecode_killNamed(bc->constants);
+	Bytecode_killNamed(bc->texts);
+	Bytecode_killNamed(bc->labels);
+	Bytecode_killNamed(bc->gotos);
+	// literal slots borrow their text from the constants
+	List_destroy(bc->slots);
+	free(bc);
+}
+
+static void Bytecode_patchGotos(Bytecode *bc) {
+	LIST_FOREACH(bc->gotos, first, next, cur) {
+		BytecodeLabel *jump = (BytecodeLabel *) cur->value;
+		LIST_FOREACH(bc->labels, first, next, label) {
+			BytecodeLabel *l = (BytecodeLabel *) label->value;
+			if (strcmp(l->name, jump->name) == 0)
+				bc->code[jump->at].c = l->at;
+		}
+	}
+}
+
+void Bytecode_program(Bytecode *bc, AST *ast) {
+	Bytecode_block(bc, ast->children->first, NULL);
+	Bytecode_emit(bc, OP_HALT, 0, 0, 0);
+	Bytecode_patchGotos(bc);
+}
+
+// statements from current up to, not including, end
+void Bytecode_block(Bytecode *bc, ListNode *current, ListNode *end) {
+	while (current != end) {
+		ASTNode *statement = (ASTNode *) current->value;
+		if (AST_isConstantPrint(statement)) {
+			Bytecode_constantPrints(bc, &current);
+			if (current == end)
+				break;
+			continue;
+		}
+		Bytecode_statement(bc, statement);
+		current = current->next;
+	}
+}
+
+// a run of PRINT "literal" is a single OP_WRITE, like IR_constantPrints
+void Bytecode_constantPrints(Bytecode *bc, ListNode **current) {
+	BytecodeText *t = malloc(sizeof(BytecodeText));
+	size_t length = 0;
+	ListNode *node;
+	for (node = *current; node != NULL && AST_isConstantPrint((ASTNode *) node->value); node = node->next)
+		length += strlen(((ASTNode *) List_first(((ASTNode *) node->value)->children))->token->text) + 1;
+
+	t->text = malloc(length + 1);
+	t->length = 0;
+	while (*current != NULL && AST_isConstantPrint((ASTNode *) (*current)->value)) {
+		char *text = ((ASTNode *) List_first(((ASTNode *) (*current)->value)->children))->token->text;
+		size_t size = strlen(text);
+		memcpy(t->text + t->length, text, size);
+		t->length += size;
+		t->text[t->length++] = '\n';
+		*current = (*current)->next;
+	}
+	t->text[t->length] = '\0';
+	List_push(bc->texts, t);
+	Bytecode_emit(bc, OP_WRITE, 0, 0, List_count(bc->texts) - 1);
+}
+
+void Bytecode_statement(Bytecode *bc, ASTNode *statement) {
+	bc->ast->currentLineNumber = statement->lineNumber;
+	ASTNode *child = (ASTNode *) List_first(statement->children);
+	BytecodeVariable *variable = NULL;
+	Operand value;
+	int top;
+	int end;
+
+	switch (statement->token->type) {
+		case PRINT:
+			value = Bytecode_comparison(bc, child);
+			if (child->subType == BOOL_VAR)
+				Bytecode_emit(bc, OP_PRINTB, value.reg, 0, 0);
+			else if (value.type == BYTECODE_INT)
+				Bytecode_emit(bc, OP_PRINTI, value.reg, 0, 0);
+			else if (value.type == BYTECODE_FLOAT)
+				Bytecode_emit(bc, OP_PRINTF, value.reg, 0, 0);
+			else if (value.type == BYTECODE_DOUBLE)
+				Bytecode_emit(bc, OP_PRINTD, value.reg, 0, 0);
+			else
+				Bytecode_emit(bc, OP_PRINTS, value.reg, 0, 0);
+			Bytecode_release(bc, value);
+			break;
+
+		case IF:
+		case ELSEIF:
+			Bytecode_if(bc, statement);
+			break;
+
+		case WHILE:
+			top = bc->length;
+			end = Bytecode_jumpUnless(bc, Bytecode_comparison(bc, child));
+			Bytecode_block(bc, statement->children->first->next, NULL);
+			Bytecode_emit(bc, OP_JMP, 0, 0, top);
+			bc->code[end].c = bc->length;
+			break;
+
+		case FOR:
+			Bytecode_for(bc, statement);
+			break;
+
+		case LABEL:
+		case GOTO:
+			{
+				BytecodeLabel *l = malloc(sizeof(BytecodeLabel));
+				l->name = strdup(child->token->text);
+				if (statement->token->type == LABEL) {
+					l->at = bc->length;
+					List_push(bc->labels, l);
+				} else {
+					l->at = Bytecode_emit(bc, OP_JMP, 0, 0, 0);
+					List_push(bc->gotos, l);
+				}
+			}
+			break;
+
+		case LET:
+			variable = Bytecode_variable(bc, child->token->text);
+			child = (ASTNode *) List_last(statement->children);
+			if (variable->type == STRING_VAR && child->token->type == PLUS) {
+				Bytecode_concat(bc, child, variable->reg);
+			} else if (variable->type == STRING_VAR) {
+				value = Bytecode_comparison(bc, child);
+				Bytecode_emit(bc, OP_STRSET, variable->reg, value.reg, 0);
+			} else {
+				Bytecode_store(bc, variable, Bytecode_comparison(bc, child));
+			}
+			break;
+
+		case INPUT:
+			variable = Bytecode_variable(bc, child->token->text);
+			if (variable->type == STRING_VAR) {
+				Bytecode_emit(bc, OP_INPUTS, variable->reg, 0, 0);
+			} else if (variable->type == FLOAT_VAR) {
+				Bytecode_emit(bc, OP_INPUTF, variable->reg, 0, 0);
+			} else {
+				Bytecode_emit(bc, OP_INPUTI, variable->reg, 0, 0);
+			}
+			if (variable->type == BOOL_VAR)
+				Bytecode_emit(bc, OP_TRUTHI, variable->reg, variable->reg, 0);
+			break;
+
+		default:
+			AST_abort("Bytecode compiler does not know this statement.");
+			break;
+	}
+}
+
+// statement.children = List(comparison, {statement}, [ELSEIF | ELSE])
+void Bytecode_if(Bytecode *bc, ASTNode *statement) {
+	ListNode *first = statement->children->first;
+	ASTNode *tail = (ASTNode *) List_last(statement->children);
+	ListNode *end = NULL;
+	if (statement->children->last != first && (tail->token->type == ELSEIF || tail->token->type == ELSE))
+		end = statement->children->last;
+	else
+		tail = NULL;
+
+	int skip = Bytecode_jumpUnless(bc, Bytecode_comparison(bc, (ASTNode *) first->value));
+	Bytecode_block(bc, first->next, end);
+
+	if (tail == NULL) {
+		bc->code[skip].c = bc->length;
+		return;
+	}
+	int done = Bytecode_emit(bc, OP_JMP, 0, 0, 0);
+	bc->code[skip].c = bc->length;
+	if (tail->token->type == ELSEIF)
+		Bytecode_if(bc, tail);
+	else
+		Bytecode_block(bc, tail->children->first, NULL);
+	bc->code[done].c = bc->length;
+}
+
+// for (v = from; v <= to; v++). When to is a plain variable or constant of
+// the loop's own type the step and the test are one OP_FORI at the bottom.
+void Bytecode_for(Bytecode *bc, ASTNode *statement) {
+	ListNode *current = statement->children->first;
+	ASTNode *ident = (ASTNode *) current->value;
+	BytecodeVariable *variable = Bytecode_variable(bc, ident->token->text);
+	BytecodeType type = variable->type == INT_VAR ? BYTECODE_INT : BYTECODE_FLOAT;
+	Operand counter = { variable->reg, type, 0 };
+	current = current->next;
+	Bytecode_store(bc, variable, Bytecode_comparison(bc, (ASTNode *) current->value));
+	current = current->next;
+
+	int top = bc->length;
+	Operand bound = Bytecode_comparison(bc, (ASTNode *) current->value);
+	int fused = !bound.temp && bound.type == type;
+	int end = Bytecode_jumpUnless(bc, Bytecode_binary(bc, LTEQ, counter, bound));
+	int body = bc->length;
+
+	Bytecode_block(bc, current->next, NULL);
+
+	if (fused) {
+		Bytecode_emit(bc, type == BYTECODE_INT ? OP_FORI : OP_FORF, variable->reg, bound.reg, body);
+	} else {
+		if (type == BYTECODE_INT)
+			Bytecode_emit(bc, OP_ADDI, variable->reg, variable->reg, Bytecode_constant(bc, "1", BYTECODE_INT));
+		else
+			Bytecode_emit(bc, OP_ADDF, variable->reg, variable->reg, Bytecode_constant(bc, "1", BYTECODE_FLOAT));
+		Bytecode_emit(bc, OP_JMP, 0, 0, top);
+	}
+	bc->code[end].c = bc->length;
+}
+
+// the last instruction computed value, make it write to reg instead
+static int Bytecode_retarget(Bytecode *bc, Operand value, int reg) {
+	if (!value.temp || bc->length == 0)
+		return 0;
+	Instruction *last = &bc->code[bc->length - 1];
+	if (last->op < OP_MOV || last->op > OP_STRNE || last->a != value.reg)
+		return 0;
+	last->a = reg;
+	Bytecode_release(bc, value);
+	return 1;
+}
+
+// converts the value to the variable's type, like a C assignment
+void Bytecode_store(Bytecode *bc, BytecodeVariable *variable, Operand value) {
+	if (variable->type == BOOL_VAR) {
+		// LET BOOL b = x is b = x == 0 ? 0 : 1
+		if (value.type == BYTECODE_INT)
+			Bytecode_emit(bc, OP_TRUTHI, variable->reg, value.reg, 0);
+		else if (value.type == BYTECODE_FLOAT)
+			Bytecode_emit(bc, OP_TRUTHF, variable->reg, value.reg, 0);
+		else
+			Bytecode_emit(bc, OP_TRUTHD, variable->reg, value.reg, 0);
+		Bytecode_release(bc, value);
+		return;
+	}
+	value = Bytecode_convert(bc, value, variable->type == INT_VAR ? BYTECODE_INT : BYTECODE_FLOAT);
+	if (!Bytecode_retarget(bc, value, variable->reg)) {
+		Bytecode_emit(bc, OP_MOV, variable->reg, value.reg, 0);
+		Bytecode_release(bc, value);
+	}
+}
+
+// returns the jump to patch with where to go when the condition is false
+int Bytecode_jumpUnless(Bytecode *bc, Operand condition) {
+	if (condition.type == BYTECODE_STRING)
+		AST_abort("A string can not be used as a condition.");
+	Instruction *last = bc->length > 0 ? &bc->code[bc->length - 1] : NULL;
+	if (condition.temp && last != NULL && last->op >= OP_LTI && last->op <= OP_NED && last->a == condition.reg) {
+		// compare and branch in one instruction
+		last->op = OP_JLTI + (last->op - OP_LTI);
+		last->a = last->b;
+		last->b = (unsigned short) last->c;
+		last->c = 0;
+		Bytecode_release(bc, condition);
+		return bc->length - 1;
+	}
+	if (condition.type != BYTECODE_INT) {
+		Operand truth = { Bytecode_temp(bc), BYTECODE_INT, 1 };
+		Bytecode_emit(bc, condition.type == BYTECODE_FLOAT ? OP_TRUTHF : OP_TRUTHD, truth.reg, condition.reg, 0);
+		Bytecode_release(bc, condition);
+		condition = truth;
+	}
+	Bytecode_release(bc, condition);
+	return Bytecode_emit(bc, OP_JZ, condition.reg, 0, 0);
+}
+
+Operand Bytecode_comparison(Bytecode *bc, ASTNode *comparison) {
+	ASTItem **items = AST_flatten(comparison);
+	int at = 0;
+	Operand value = Bytecode_climb(bc, items, &at, 1);
+	AST_killItems(items);
+	return value;
+}
+
+// precedence climbing over the flattened items, binding like C does
+Operand Bytecode_climb(Bytecode *bc, ASTItem **items, int *at, int precedence) {
+	ASTItem *item = items[(*at)++];
+	Operand value;
+	if (item->kind == AST_ITEM_OPEN) {
+		value = Bytecode_climb(bc, items, at, 1);
+		(*at)++;
+	} else {
+		value = Bytecode_value(bc, item->node);
+	}
+
+	while (items[*at] != NULL && items[*at]->kind == AST_ITEM_OPERATOR) {
+		TokenType operation = items[*at]->node->token->type;
+		int level = AST_precedence(operation);
+		if (level < precedence)
+			break;
+		(*at)++;
+		Operand right = Bytecode_climb(bc, items, at, level + 1);
+		value = Bytecode_binary(bc, operation, value, right);
+	}
+	return value;
+}
+
+Operand Bytecode_value(Bytecode *bc, ASTNode *value) {
+	Operand result = { 0, BYTECODE_INT, 0 };
+	BytecodeVariable *variable;
+
+	if (value->subType == STRING_VAR && value->token->type == PLUS) {
+		// PRINT and comparisons concatenate into a string of their own
+		result.reg = Bytecode_slot(bc, NULL);
+		result.type = BYTECODE_STRING;
+		Bytecode_concat(bc, value, result.reg);
+		return result;
+	}
+
+	switch (value->token->type) {
+		case IDENT:
+			variable = Bytecode_variable(bc, value->token->text);
+			result.reg = variable->reg;
+			if (variable->type == STRING_VAR)
+				result.type = BYTECODE_STRING;
+			else if (variable->type == FLOAT_VAR)
+				result.type = BYTECODE_FLOAT;
+			return result;
+
+		case TRUE:
+		case FALSE:
+			result.reg = Bytecode_constant(bc, value->token->type == TRUE ? "1" : "0", BYTECODE_INT);
+			return result;
+
+		case NUMBERINT:
+			result.reg = Bytecode_constant(bc, value->token->text, BYTECODE_INT);
+			return result;
+
+		case NUMBERFLOAT:
+			// a C literal like 4.5 is a double
+			result.type = BYTECODE_DOUBLE;
+			result.reg = Bytecode_constant(bc, value->token->text, BYTECODE_DOUBLE);
+			return result;
+
+		case STRING:
+			result.type = BYTECODE_STRING;
+			result.reg = Bytecode_constant(bc, value->token->text, BYTECODE_STRING);
+			return result;
+
+		default:
+			break;
+	}
+
+	if (!AST_isComparisonOperator(value->token->type))
+		AST_abort("Bytecode compiler does not know this expression.");
+	// a string comparison, tt_str_eq in the C backend
+	Operand left = Bytecode_comparison(bc, (ASTNode *) List_first(value->children));
+	Operand right = Bytecode_comparison(bc, (ASTNode *) List_last(value->children));
+	return Bytecode_binary(bc, value->token->type, left, right);
+}
+
+Operand Bytecode_binary(Bytecode *bc, TokenType operation, Operand left, Operand right) {
+	Operand result = { 0, BYTECODE_INT, 1 };
+
+	if (left.type == BYTECODE_STRING) {
+		Bytecode_release(bc, left);
+		Bytecode_release(bc, right);
+		result.reg = Bytecode_temp(bc);
+		Bytecode_emit(bc, operation == NOTEQ ? OP_STRNE : OP_STREQ, result.reg, left.reg, right.reg);
+		return result;
+	}
+
+	BytecodeType common = left.type > right.type ? left.type : right.type;
+	left = Bytecode_convert(bc, left, common);
+	right = Bytecode_convert(bc, right, common);
+	Bytecode_release(bc, left);
+	Bytecode_release(bc, right);
+	result.reg = Bytecode_temp(bc);
+	// the int, float and double forms of an operation are four opcodes apart
+	int shift = 4 * (common - BYTECODE_INT);
+
+	switch (operation) {
+		case PLUS:
+		case MINUS:
+		case ASTERISK:
+		case SLASH:
+			result.type = common;
+			int arithmetic = operation == PLUS ? OP_ADDI : operation == MINUS ? OP_SUBI : operation == ASTERISK ? OP_MULI : OP_DIVI;
+			Bytecode_emit(bc, arithmetic + shift, result.reg, left.reg, right.reg);
+			break;
+		case LT:
+			Bytecode_emit(bc, OP_LTI + shift, result.reg, left.reg, right.reg);
+			break;
+		case LTEQ:
+			Bytecode_emit(bc, OP_LEI + shift, result.reg, left.reg, right.reg);
+			break;
+		case GT:
+			Bytecode_emit(bc, OP_LTI + shift, result.reg, right.reg, left.reg);
+			break;
+		case GTEQ:
+			Bytecode_emit(bc, OP_LEI + shift, result.reg, right.reg, left.reg);
+			break;
+		case EQEQ:
+			Bytecode_emit(bc, OP_EQI + shift, result.reg, left.reg, right.reg);
+			break;
+		case NOTEQ:
+			Bytecode_emit(bc, OP_NEI + shift, result.reg, left.reg, right.reg);
+			break;
+		default:
+			AST_abort("Invalid operator.");
+			break;
+	}
+	return result;
+}
+
+Operand Bytecode_convert(Bytecode *bc, Operand value, BytecodeType type) {
+	if (value.type == type)
+		return value;
+	int op = OP_MOV;
+	if (value.type == BYTECODE_INT)
+		op = type == BYTECODE_FLOAT ? OP_ITOF : OP_ITOD;
+	else if (value.type == BYTECODE_FLOAT)
+		op = type == BYTECODE_INT ? OP_FTOI : OP_FTOD;
+	else if (value.type == BYTECODE_DOUBLE)
+		op = type == BYTECODE_INT ? OP_DTOI : OP_DTOF;
+	else
+		AST_abort("Invalid types in expression.");
+	Bytecode_release(bc, value);
+	Operand result = { Bytecode_temp(bc), type, 1 };
+	Bytecode_emit(bc, op, result.reg, value.reg, 0);
+	return result;
+}
+
+static void Bytecode_stringParts(ASTNode *expression, List *parts) {
+	if (expression->token->type != PLUS) {
+		List_push(parts, expression);
+		return;
+	}
+	ListNode *child = expression->children->first;
+	if (((ASTNode *) child->value)->token->type == LEFTPAREN)
+		child = child->next;
+	Bytecode_stringParts((ASTNode *) child->value, parts);
+	Bytecode_stringParts((ASTNode *) child->next->value, parts);
+}
+
+// one OP_STRCAT over every operand of the + chain, their registers follow
+// three to an OP_ARGS
+void Bytecode_concat(Bytecode *bc, ASTNode *expression, int destination) {
+	List *parts = List_create();
+	Bytecode_stringParts(expression, parts);
+	int *regs = malloc(sizeof(int) * (List_count(parts) + 2));
+	int count = 0;
+	LIST_FOREACH(parts, first, next, cur) {
+		regs[count++] = Bytecode_value(bc, (ASTNode *) cur->value).reg;
+	}
+	regs[count] = regs[count + 1] = 0;
+
+	Bytecode_emit(bc, OP_STRCAT, destination, 0, count);
+	int i;
+	for (i = 0; i < count; i += 3)
+		Bytecode_emit(bc, OP_ARGS, regs[i], regs[i + 1], i + 2 < count ? regs[i + 2] : 0);
+	free(regs);
+	List_destroy(parts);
+}
+
+BytecodeVariable *Bytecode_variable(Bytecode *bc, char *name) {
+	LIST_FOREACH(bc->variables, first, next, cur) {
+		BytecodeVariable *v = (BytecodeVariable *) cur->value;
+		if (strcmp(v->name, name) == 0)
+			return v;
+	}
+	AST_abort("Bytecode compiler could not find a variable.");
+	return NULL;
+}
+
+// the register that holds a constant, made the first time it is needed
+int Bytecode_constant(Bytecode *bc, char *text, BytecodeType type) {
+	LIST_FOREACH(bc->constants, first, next, cur) {
+		BytecodeConstant *c = (BytecodeConstant *) cur->value;
+		if (c->type == type && c->text != NULL && strcmp(c->text, text) == 0)
+			return c->reg;
+	}
+	if (type == BYTECODE_STRING)
+		return Bytecode_slot(bc, text);
+
+	BytecodeConstant *c = malloc(sizeof(BytecodeConstant));
+	c->text = strdup(text);
+	c->type = type;
+	c->slot = -1;
+	c->reg = Bytecode_register(bc);
+	if (type == BYTECODE_INT)
+		bc->registers[c->reg].i = (int) strtol(text, NULL, 10);
+	else if (type == BYTECODE_FLOAT)
+		bc->registers[c->reg].f = strtof(text, NULL);
+	else
+		bc->registers[c->reg].d = strtod(text, NULL);
+	List_push(bc->constants, c);
+	return c->reg;
+}
+
+// a string slot and the register pointing at it, literal is NULL for
+// variables and temporaries, which start out as ""
+int Bytecode_slot(Bytecode *bc, char *literal) {
+	BytecodeConstant *c = malloc(sizeof(BytecodeConstant));
+	c->text = literal == NULL ? NULL : strdup(literal);
+	c->type = BYTECODE_STRING;
+	c->slot = List_count(bc->slots);
+	c->reg = Bytecode_register(bc);
+	List_push(bc->slots, c->text);
+	if (literal != NULL)
+		List_push(bc->constants, c);
+	else
+		List_unshift(bc->constants, c);
+	return c->reg;
+}
+
+int Bytecode_register(Bytecode *bc) {
+	if (bc->registerCount == BYTECODE_MAX_REGISTERS)
+		AST_abort("Program needs too many registers for the VM.");
+	if (bc->registerCount == bc->registerCapacity) {
+		bc->registerCapacity = bc->registerCapacity == 0 ? 256 : bc->registerCapacity * 2;
+		bc->registers = realloc(bc->registers, sizeof(Value) * bc->registerCapacity);
+		if (bc->registers == NULL) {
+			printf("Unable to allocate memory for bytecode.\n");
+			exit(1);
+		}
+	}
+	memset(&bc->registers[bc->registerCount], 0, sizeof(Value));
+	return bc->registerCount++;
+}
+
+int Bytecode_temp(Bytecode *bc) {
+	int *reg = (int *) List_pop(bc->freeRegisters);
+	if (reg == NULL)
+		return Bytecode_register(bc);
+	int temp = *reg;
+	free(reg);
+	return temp;
+}
+
+void Bytecode_release(Bytecode *bc, Operand value) {
+	if (!value.temp)
+		return;
+	int *reg = malloc(sizeof(int));
+	*reg = value.reg;
+	List_push(bc->freeRegisters, reg);
+}
+
+// returns where the instruction went
+int Bytecode_emit(Bytecode *bc, int op, int a, int b, int c) {
+	if (bc->length == bc->capacity) {
+		bc->capacity = bc->capacity == 0 ? 1024 : bc->capacity * 2;
+		bc->code = realloc(bc->code, sizeof(Instruction) * bc->capacity);
+		if (bc->code == NULL) {
+			printf("Unable to allocate memory for bytecode.\n");
+			exit(1);
+		}
+	}
+	Instruction *i = &bc->code[bc->length];
+	i->op = op;
+	i->a = (unsigned short) a;
+	i->b = (unsigned short) b;
+	i->c = c;
+	return bc->length++;
+}
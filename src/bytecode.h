@@ -0,0 +1,167 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "ast.h"
+#include "list.h"
+#include "x64rt.h"
+
+// Register bytecode for `teenytiny run`. Variables, constants and
+// temporaries all live in one register file, so an instruction names its
+// operands directly and nothing is ever pushed or popped. Every operation is
+// typed the way the C backend's C would be, so the VM prints the same thing.
+
+#define BYTECODE_MAX_REGISTERS 65535
+
+typedef enum Opcode {
+	OP_HALT = 0,
+	OP_MOV,
+	// a = b op c
+	OP_ADDI, OP_SUBI, OP_MULI, OP_DIVI,
+	OP_ADDF, OP_SUBF, OP_MULF, OP_DIVF,
+	OP_ADDD, OP_SUBD, OP_MULD, OP_DIVD,
+	// a = (type) b
+	OP_ITOF, OP_ITOD, OP_FTOD, OP_FTOI, OP_DTOI, OP_DTOF,
+	// a = b != 0
+	OP_TRUTHI, OP_TRUTHF, OP_TRUTHD,
+	// a = b cmp c, greater than is done with the operands swapped
+	OP_LTI, OP_LEI, OP_EQI, OP_NEI,
+	OP_LTF, OP_LEF, OP_EQF, OP_NEF,
+	OP_LTD, OP_LED, OP_EQD, OP_NED,
+	OP_STREQ, OP_STRNE,
+	// goto c, or goto c unless a
+	OP_JMP, OP_JZ,
+	// superinstructions: goto c unless a cmp b
+	OP_JLTI, OP_JLEI, OP_JEQI, OP_JNEI,
+	OP_JLTF, OP_JLEF, OP_JEQF, OP_JNEF,
+	OP_JLTD, OP_JLED, OP_JEQD, OP_JNED,
+	// superinstructions: ++a, then goto c if a <= b
+	OP_FORI, OP_FORF,
+	OP_PRINTI, OP_PRINTF, OP_PRINTD, OP_PRINTB, OP_PRINTS,
+	// write text c
+	OP_WRITE,
+	OP_INPUTI, OP_INPUTF, OP_INPUTS,
+	// string a = b
+	OP_STRSET,
+	// string a = the c registers listed in the OP_ARGS that follow
+	OP_STRCAT, OP_ARGS,
+	OP_COUNT
+} Opcode;
+
+typedef struct Instruction {
+	int op;
+	unsigned short a;
+	unsigned short b;
+	int c;
+} Instruction;
+
+typedef union Value {
+	int i;
+	float f;
+	double d;
+	X64String *s;
+} Value;
+
+typedef enum BytecodeType {
+	BYTECODE_INT = 1,
+	BYTECODE_FLOAT = 2,
+	BYTECODE_DOUBLE = 3,
+	BYTECODE_STRING = 4
+} BytecodeType;
+
+// where a value is, temporaries go back to the free list once read
+typedef struct Operand {
+	int reg;
+	BytecodeType type;
+	int temp;
+} Operand;
+
+typedef struct BytecodeVariable {
+	char *name;
+	TokenType type;
+	int reg;
+} BytecodeVariable;
+
+// a register that holds a number, or that points at a string slot
+typedef struct BytecodeConstant {
+	char *text;
+	BytecodeType type;
+	int reg;
+	int slot;
+} BytecodeConstant;
+
+typedef struct BytecodeText {
+	char *text;
+	int length;
+} BytecodeText;
+
+typedef struct BytecodeLabel {
+	char *name;
+	int at;
+} BytecodeLabel;
+
+typedef struct Bytecode {
+	AST *ast;
+	Instruction *code;
+	int length;
+	int capacity;
+	// initial contents of every register
+	Value *registers;
+	int registerCount;
+	int registerCapacity;
+	List *freeRegisters;
+	List *variables;
+	List *constants;
+	List *texts;
+	// string slots, the literals among them point at their text
+	List *slots;
+	List *labels;
+	List *gotos;
+} Bytecode;
+
+Bytecode *Bytecode_create(AST *ast);
+
+void Bytecode_kill(Bytecode *bc);
+
+void Bytecode_program(Bytecode *bc, AST *ast);
+
+void Bytecode_block(Bytecode *bc, ListNode *current, ListNode *end);
+
+void Bytecode_statement(Bytecode *bc, ASTNode *statement);
+
+void Bytecode_constantPrints(Bytecode *bc, ListNode **current);
+
+void Bytecode_if(Bytecode *bc, ASTNode *statement);
+
+void Bytecode_for(Bytecode *bc, ASTNode *statement);
+
+void Bytecode_store(Bytecode *bc, BytecodeVariable *variable, Operand value);
+
+int Bytecode_jumpUnless(Bytecode *bc, Operand condition);
+
+Operand Bytecode_comparison(Bytecode *bc, ASTNode *comparison);
+
+Operand Bytecode_climb(Bytecode *bc, ASTItem **items, int *at, int precedence);
+
+Operand Bytecode_value(Bytecode *bc, ASTNode *value);
+
+Operand Bytecode_binary(Bytecode *bc, TokenType operation, Operand left, Operand right);
+
+Operand Bytecode_convert(Bytecode *bc, Operand value, BytecodeType type);
+
+void Bytecode_concat(Bytecode *bc, ASTNode *expression, int destination);
+
+BytecodeVariable *Bytecode_variable(Bytecode *bc, char *name);
+
+int Bytecode_constant(Bytecode *bc, char *text, BytecodeType type);
+
+int Bytecode_slot(Bytecode *bc, char *literal);
+
+int Bytecode_register(Bytecode *bc);
+
+int Bytecode_temp(Bytecode *bc);
+
+void Bytecode_release(Bytecode *bc, Operand value);
+
+int Bytecode_emit(Bytecode *bc, int op, int a, int b, int c);
+
+#endif
@@ -0,0 +1,273 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "cache.h"
+
+Cache *Cache_create(char *directory, long long size) {
+	if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+		printf("Cache directory %s could not be created.\n", directory);
+		exit(1);
+	}
+	Cache *cache = calloc(1, sizeof(Cache));
+	if (cache == NULL) {
+		printf("Unable to allocate memory for the cache.\n");
+		exit(1);
+	}
+	cache->directory = strdup(directory);
+	cache->size = size;
+	struct stat binary;
+	if (stat("/proc/self/exe", &binary) == 0) {
+		char version[96];
+		snprintf(version, sizeof(version), "%lld %llu %lld.%09ld", (long long) binary.st_size,
+			(unsigned long long) binary.st_ino, (long long) binary.st_mtim.tv_sec, binary.st_mtim.tv_nsec);
+		cache->version = strdup(version);
+	}
+	return cache;
+}
+
+void Cache_kill(Cache *cache) {
+	if (cache == NULL)
+		return;
+	free(cache->directory);
+	free(cache->version);
+	free(cache);
+}
+
+// what an entry starts with, everything but the source it also holds
+static char *Cache_header(Cache *cache, size_t length, char *flags) {
+	size_t size = strlen(cache->version) + strlen(flags) + 64;
+	char *header = malloc(size);
+	if (header == NULL) {
+		printf("Unable to allocate memory for the cache.\n");
+		exit(1);
+	}
+	snprintf(header, size, "teenytiny cache\n%s\n%s\n%zu\n", cache->version, flags, length);
+	return header;
+}
+
+static unsigned long long Cache_hash(unsigned long long hash, char *bytes, size_t length) {
+	size_t i;
+	for (i = 0; i < length; i++) {
+		hash ^= (unsigned char) bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// dir/0123456789abcdef.c, by FNV-1a of the header and the source
+static char *Cache_path(Cache *cache, char *header, char *source, size_t length) {
+	unsigned long long hash = Cache_hash(14695981039346656037ULL, header, strlen(header));
+	hash = Cache_hash(hash, source, length);
+	size_t size = strlen(cache->directory) + 24;
+	char *path = malloc(size);
+	if (path == NULL) {
+		printf("Unable to allocate memory for the cache.\n");
+		exit(1);
+	}
+	snprintf(path, size, "%s/%016llx.c", cache->directory, hash);
+	return path;
+}
+
+static int Cache_write(char *path, char *bytes, size_t length) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		return 0;
+	size_t written = fwrite(bytes, 1, length, file);
+	return fclose(file) == 0 && written == length;
+}
+
+// the whole file, NULL when it cannot be read
+static char *Cache_read(char *path, size_t *length) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return NULL;
+	struct stat info;
+	char *bytes = NULL;
+	if (fstat(fileno(file), &info) == 0 && (bytes = malloc(info.st_size + 1)) != NULL) {
+		*length = fread(bytes, 1, info.st_size, file);
+		if (*length != (size_t) info.st_size) {
+			free(bytes);
+			bytes = NULL;
+		}
+	}
+	fclose(file);
+	return bytes;
+}
+
+int Cache_fetch(Cache *cache, char *source, size_t length, char *flags, char *output) {
+	if (cache->version == NULL)
+		return 0;
+	char *header = Cache_header(cache, length, flags);
+	char *path = Cache_path(cache, header, source, length);
+	size_t headerLength = strlen(header);
+	size_t entryLength;
+	char *entry = Cache_read(path, &entryLength);
+	int hit = entry != NULL && entryLength >= headerLength + length
+		&& memcmp(entry, header, headerLength) == 0
+		&& memcmp(entry + headerLength, source, length) == 0
+		&& Cache_write(output, entry + headerLength + length, entryLength - headerLength - length);
+	// touched, so it is the most recently used
+	if (hit)
+		utimensat(AT_FDCWD, path, NULL, 0);
+	__atomic_fetch_add(hit ? &cache->hits : &cache->misses, 1, __ATOMIC_RELAXED);
+	free(entry);
+	free(path);
+	free(header);
+	return hit;
+}
+
+void Cache_store(Cache *cache, char *source, size_t length, char *flags, char *output) {
+	if (cache->version == NULL)
+		return;
+	size_t codeLength;
+	char *code = Cache_read(output, &codeLength);
+	if (code == NULL)
+		return;
+	char *header = Cache_header(cache, length, flags);
+	char *path = Cache_path(cache, header, source, length);
+	// written aside and renamed, so no one ever reads half an entry
+	char *temporary = malloc(strlen(cache->directory) + 16);
+	if (temporary == NULL) {
+		printf("Unable to allocate memory for the cache.\n");
+		exit(1);
+	}
+	sprintf(temporary, "%s/tmp.XXXXXX", cache->directory);
+	int fd = mkstemp(temporary);
+	FILE *file = fd < 0 ? NULL : fdopen(fd, "w");
+	if (file != NULL) {
+		size_t headerLength = strlen(header);
+		int written = fwrite(header, 1, headerLength, file) == headerLength
+			&& fwrite(source, 1, length, file) == length
+			&& fwrite(code, 1, codeLength, file) == codeLength;
+		if (fclose(file) == 0 && written && rename(temporary, path) == 0)
+			__atomic_fetch_add(&cache->stores, 1, __ATOMIC_RELAXED);
+		else
+			unlink(temporary);
+	} else if (fd >= 0) {
+		close(fd);
+		unlink(temporary);
+	}
+	free(temporary);
+	free(path);
+	free(header);
+	free(code);
+}
+
+typedef struct CacheFile {
+	char *name;
+	long long size;
+	struct timespec used;
+} CacheFile;
+
+static int Cache_older(const void *a, const void *b) {
+	const CacheFile *x = a;
+	const CacheFile *y = b;
+	if (x->used.tv_sec != y->used.tv_sec)
+		return x->used.tv_sec < y->used.tv_sec ? -1 : 1;
+	return x->used.tv_nsec < y->used.tv_nsec ? -1 : x->used.tv_nsec > y->used.tv_nsec;
+}
+
+// whether the first count characters of text are lowercase hex
+static int Cache_hex(const char *text, int count) {
+	int i;
+	for (i = 0; i < count; i++) {
+		if (!((text[i] >= '0' && text[i] <= '9') || (text[i] >= 'a' && text[i] <= 'f')))
+			return 0;
+	}
+	return 1;
+}
+
+// what the cache and teeny.sh write there: 0123456789abcdef.c and the
+// sha256.bin executables are entries, tmp.XXXXXX and sha256.bin.pid are
+// stores written aside before they are renamed
+typedef enum CacheName {
+	CACHE_OTHER,
+	CACHE_ENTRY,
+	CACHE_TEMPORARY
+} CacheName;
+
+// a temporary this old was left by a store that died
+#define CACHE_STALE 3600
+
+static CacheName Cache_name(const char *name) {
+	size_t length = strlen(name);
+	if (length == 18 && Cache_hex(name, 16) && strcmp(name + 16, ".c") == 0)
+		return CACHE_ENTRY;
+	if (length == 68 && Cache_hex(name, 64) && strcmp(name + 64, ".bin") == 0)
+		return CACHE_ENTRY;
+	if (length > 69 && Cache_hex(name, 64) && strncmp(name + 64, ".bin.", 5) == 0 && strspn(name + 69, "0123456789") == length - 69)
+		return CACHE_TEMPORARY;
+	if (length == 10 && strncmp(name, "tmp.", 4) == 0)
+		return CACHE_TEMPORARY;
+	return CACHE_OTHER;
+}
+
+void Cache_evict(Cache *cache) {
+	DIR *directory = opendir(cache->directory);
+	if (directory == NULL)
+		return;
+	int fd = dirfd(directory);
+	CacheFile *files = NULL;
+	int count = 0;
+	int capacity = 0;
+	long long total = 0;
+	time_t now = time(NULL);
+	struct dirent *found;
+	while ((found = readdir(directory)) != NULL) {
+		struct stat info;
+		// no other file is ever counted or removed
+		CacheName name = Cache_name(found->d_name);
+		if (name == CACHE_OTHER)
+			continue;
+		if (fstatat(fd, found->d_name, &info, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(info.st_mode))
+			continue;
+		// a store may still be writing a fresh temporary, a stale one goes
+		// whatever the size and is no entry to count
+		if (name == CACHE_TEMPORARY) {
+			if (info.st_mtim.tv_sec <= now - CACHE_STALE && unlinkat(fd, found->d_name, 0) == 0)
+				cache->evicted++;
+			continue;
+		}
+		if (count == capacity) {
+			capacity = capacity == 0 ? 64 : capacity * 2;
+			CacheFile *grown = realloc(files, sizeof(CacheFile) * capacity);
+			if (grown == NULL) {
+				printf("Unable to allocate memory for the cache.\n");
+				exit(1);
+			}
+			files = grown;
+		}
+		files[count].name = strdup(found->d_name);
+		files[count].size = info.st_size;
+		files[count].used = info.st_mtim;
+		total += info.st_size;
+		count++;
+	}
+	qsort(files, count, sizeof(CacheFile), Cache_older);
+	int removed = 0;
+	int i;
+	for (i = 0; i < count; i++) {
+		if (total > cache->size && unlinkat(fd, files[i].name, 0) == 0) {
+			total -= files[i].size;
+			removed++;
+		}
+		free(files[i].name);
+	}
+	cache->evicted += removed;
+	cache->files = count - removed;
+	cache->bytes = total;
+	free(files);
+	closedir(directory);
+}
+
+void Cache_report(Cache *cache, FILE *out) {
+	fprintf(out, "cache %s: %lld hits, %lld misses, %lld stored, %lld evicted, %d files, %lld of %lld kB\n",
+		cache->directory, cache->hits, cache->misses, cache->stores, cache->evicted, cache->files,
+		cache->bytes >> 10, cache->size >> 10);
+}
@@ -0,0 +1,48 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+
+// --cache=dir: generated C kept by what it was generated from. The key is a
+// hash of the source, the compiler binary (its size, inode and modification
+// time, so every build is a new version) and the flags the output depends
+// on. Entries hold all of that as well, so a hash collision is a miss and
+// never wrong code. A hit touches its entry, which keeps modification times
+// in least recently used order, and when the entries grow past its size the
+// oldest go first, the executables teeny.sh keeps there included. Other
+// files in the directory are neither counted nor removed.
+
+#define CACHE_DEFAULT_SIZE (100LL << 20)
+
+typedef struct Cache {
+	char *directory;
+	long long size;
+	// the compiler binary, NULL when it could not be told, then nothing is
+	// cached as a rebuilt compiler would look the same
+	char *version;
+	// counted by every thread compiling
+	long long hits;
+	long long misses;
+	long long stores;
+	long long evicted;
+	// what the directory held after the last eviction
+	int files;
+	long long bytes;
+} Cache;
+
+Cache *Cache_create(char *directory, long long size);
+
+void Cache_kill(Cache *cache);
+
+// writes the C cached for source to output and returns 1, or returns 0
+int Cache_fetch(Cache *cache, char *source, size_t length, char *flags, char *output);
+
+// keeps output as the C for source
+void Cache_store(Cache *cache, char *source, size_t length, char *flags, char *output);
+
+// drops the least recently used entries until they fit the cache's size
+void Cache_evict(Cache *cache);
+
+void Cache_report(Cache *cache, FILE *out);
+
+#endif
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compile.h"
+#include "diagnostic.h"
+#include "emit.h"
+#include "executable.h"
+#include "jit.h"
+#include "timer.h"
+#include "vm.h"
+
+Compilation *Compilation_create(char *path, char *output, CompileOptions *options) {
+	Compilation *comp = calloc(1, sizeof(Compilation));
+	if (comp == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for the compilation.");
+	comp->path = path;
+	comp->output = output;
+	comp->options = options;
+	return comp;
+}
+
+void Compilation_kill(Compilation *comp) {
+	if (comp == NULL)
+		return;
+	Lexer_kill(comp->lex);
+	AST_kill(comp->ast);
+	Parser_kill(comp->par);
+	Emitter_kill();
+	X64_kill(comp->native);
+	Bytecode_kill(comp->bytecode);
+	IR_kill(comp->ir);
+	Profile_kill(comp->guide);
+	free(comp);
+}
+
+// examples/fibonacci.teeny or fibonacci.tta -> fibonacci, like teeny.sh names
+// its binaries
+char *Compilation_name(char *path) {
+	char *name = strrchr(path, '/');
+	name = strdup(name == NULL ? path : name + 1);
+	char *extension = strrchr(name, '.');
+	if (extension != NULL && (strcmp(extension, ".teeny") == 0 || strcmp(extension, ".tta") == 0))
+		*extension = '\0';
+	return name;
+}
+
+// lexes, parses and checks what comp->lex reads
+void Compilation_check(Compilation *comp) {
+	comp->ast = AST_create(comp->lex);
+	Timer_begin("Parser_program", NULL, TIMER_PHASE);
+	comp->par = Parser_create(comp->lex, comp->ast);
+	Parser_start(comp->par);
+	Parser_program(comp->par);
+	Timer_end();
+
+	Timer_begin("AST_check", NULL, TIMER_PHASE);
+	AST_check(comp->ast);
+	Timer_end();
+}
+
+// the checked program as C, to the current emitter, with #line directives
+// naming source unless it is NULL
+void Compilation_emitC(Compilation *comp, char *source) {
+	CompileOptions *options = comp->options;
+	if (source != NULL)
+		Emitter_source(source);
+	IR *ir = comp->ir = IR_create(comp->ast);
+	ir->profile = options->profile;
+	if (options->guidePath != NULL)
+		ir->guide = comp->guide = Profile_read(options->guidePath);
+	Timer_begin("IR_lower", NULL, TIMER_PHASE);
+	IR_lower(ir, comp->ast);
+	Timer_end();
+	Timer_begin("IR_optimize", NULL, TIMER_PHASE);
+	IR_optimize(ir);
+	Timer_end();
+	if (options->dumpIR)
+		IR_print(ir, stdout);
+	// a program that never reads input is run now and only its output kept
+	char *output;
+	size_t length;
+	int status;
+	Timer_begin("IR_evaluate", NULL, TIMER_PHASE);
+	int evaluated = options->evaluate && !options->profile && IR_evaluate(ir, &output, &length, &status);
+	Timer_end();
+	Timer_begin("IR_emit", NULL, TIMER_PHASE);
+	if (evaluated) {
+		IR_emitOutput(output, length, status);
+		if (length > 0)
+			free(output);
+	} else {
+		IR_emit(ir);
+	}
+	Timer_end();
+}
+
+// the whole file, read from the start again after
+static char *Compilation_source(FILE *file, size_t *length) {
+	char *source = NULL;
+	size_t capacity = 0;
+	*length = 0;
+	do {
+		capacity = capacity == 0 ? 4096 : capacity * 2;
+		source = realloc(source, capacity);
+		if (source == NULL)
+			Diagnostic_raise(0, "Unable to allocate memory for the source.");
+		*length += fread(source + *length, 1, capacity - *length, file);
+	} while (*length == capacity);
+	rewind(file);
+	return source;
+}
+
+// the options the generated C depends on, for the cache key
+static char *Compilation_flags(Compilation *comp, char *source) {
+	size_t size = strlen(source) + 64;
+	char *flags = malloc(size);
+	if (flags == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for the cache key.");
+	snprintf(flags, size, "evaluate %d profile %d source %s", comp->options->evaluate, comp->options->profile, source);
+	return flags;
+}
+
+// returns 1 when the file could not be opened, errors in the program itself
+// still end the process
+int Compilation_run(Compilation *comp) {
+	CompileOptions *options = comp->options;
+	// run and --jit are for scripts, so only the program itself gets to print
+	if (!options->run && !options->jit)
+		printf("Compiling %s...\n", comp->path);
+
+	// the .teeny file's absolute path, which #line directives name
+	char *source = NULL;
+	char *flags = NULL;
+	char *text = NULL;
+	size_t length = 0;
+	if (options->fromAST) {
+		Timer_begin("ASTFile_read", NULL, TIMER_PHASE);
+		comp->ast = ASTFile_read(comp->path, &source);
+		Timer_end();
+		if (comp->output != NULL)
+			Emitter_create(comp->output);
+	} else {
+		FILE *teenytinyFile = fopen(comp->path, "r");
+		if (teenytinyFile == NULL) {
+			printf("%s could not be opened.\n", comp->path);
+			return 1;
+		}
+		// a guided build also depends on the profile, --dump-ir wants the IR
+		// and --emit-ast the AST
+		if (comp->output != NULL && options->cache != NULL && options->guidePath == NULL && !options->dumpIR && options->emitAST == NULL) {
+			source = realpath(comp->path, NULL);
+			flags = Compilation_flags(comp, source == NULL ? comp->path : source);
+			text = Compilation_source(teenytinyFile, &length);
+			if (Cache_fetch(options->cache, text, length, flags, comp->output)) {
+				fclose(teenytinyFile);
+				free(source);
+				free(flags);
+				free(text);
+				printf("Compiling completed.\n\n");
+				return 0;
+			}
+		}
+		comp->lex = Lexer_create(teenytinyFile);
+
+		if (comp->output != NULL)
+			Emitter_create(comp->output);
+
+		Compilation_check(comp);
+		if (source == NULL)
+			source = realpath(comp->path, NULL);
+	}
+	if (options->emitAST != NULL) {
+		Timer_begin("ASTFile_write", NULL, TIMER_PHASE);
+		ASTFile_write(comp->ast, source == NULL ? comp->path : source, options->emitAST);
+		Timer_end();
+	}
+
+	if (options->run) {
+		Timer_begin("Bytecode_program", NULL, TIMER_PHASE);
+		comp->bytecode = Bytecode_create(comp->ast);
+		Bytecode_program(comp->bytecode, comp->ast);
+		Timer_end();
+		VM_run(comp->bytecode);
+	} else if (options->jit) {
+		Timer_begin("X64_program", NULL, TIMER_PHASE);
+		comp->native = X64_create(comp->ast);
+		comp->native->returns = 1;
+		X64_program(comp->native, comp->ast);
+		Timer_end();
+		Jit_run(comp->native);
+	} else if (options->useNative) {
+		// straight to an executable, no C compiler involved
+		char *name = Compilation_name(comp->path);
+		Timer_begin("X64_program", NULL, TIMER_PHASE);
+		comp->native = X64_create(comp->ast);
+		X64_program(comp->native, comp->ast);
+		Timer_end();
+		Timer_begin("Executable_write", NULL, TIMER_PHASE);
+		Executable_write(name, comp->native);
+		Timer_end();
+		free(name);
+	} else {
+		// gcc, gdb, perf and the sanitizers report .teeny lines, by absolute
+		// path so the C file can be built from anywhere
+		Compilation_emitC(comp, source == NULL ? comp->path : source);
+		Timer_begin("Emitter_writeFile", NULL, TIMER_PHASE);
+		Emitter_writeFile();
+		Timer_end();
+		if (text != NULL)
+			Cache_store(options->cache, text, length, flags, comp->output);
+	}
+	free(source);
+	free(flags);
+	free(text);
+	if (!options->run && !options->jit)
+		printf("Compiling completed.\n\n");
+
+	return 0;
+}
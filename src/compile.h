@@ -0,0 +1,60 @@
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include "ast.h"
+#include "astfile.h"
+#include "cache.h"
+#include "bytecode.h"
+#include "ir.h"
+#include "lex.h"
+#include "parse.h"
+#include "profile.h"
+#include "x64.h"
+
+// Everything one .teeny file is compiled with. The AST and emitter a
+// compilation is working on are also its thread's current ones, so several
+// compilations may run at once as long as each has a thread to itself.
+
+typedef struct CompileOptions {
+	int useNative;
+	int run;
+	int jit;
+	int dumpIR;
+	int evaluate;
+	int profile;
+	char *guidePath;
+	// generated C is looked up here first, or NULL
+	Cache *cache;
+	// where to write the checked AST, or NULL
+	char *emitAST;
+	// the path is an AST file to start from, not a .teeny file
+	int fromAST;
+} CompileOptions;
+
+typedef struct Compilation {
+	char *path;
+	// the C file written, or NULL when not compiling to C
+	char *output;
+	CompileOptions *options;
+	Lexer *lex;
+	AST *ast;
+	Parser *par;
+	X64 *native;
+	Bytecode *bytecode;
+	IR *ir;
+	Profile *guide;
+} Compilation;
+
+Compilation *Compilation_create(char *path, char *output, CompileOptions *options);
+
+void Compilation_check(Compilation *comp);
+
+void Compilation_emitC(Compilation *comp, char *source);
+
+int Compilation_run(Compilation *comp);
+
+void Compilation_kill(Compilation *comp);
+
+char *Compilation_name(char *path);
+
+#endif
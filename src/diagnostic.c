@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "diagnostic.h"
+
+static _Thread_local DiagnosticTrap *trap = NULL;
+
+void Diagnostic_trap(DiagnosticTrap *next) {
+	next->outer = trap;
+	trap = next;
+}
+
+void Diagnostic_release(DiagnosticTrap *released) {
+	trap = released->outer;
+}
+
+void Diagnostic_raise(int line, const char *message) {
+	if (trap == NULL) {
+		if (line > 0)
+			printf("ERROR AT LINE #%d:\n", line);
+		printf("%s\n", message);
+		exit(1);
+	}
+	trap->diagnostic.line = line;
+	snprintf(trap->diagnostic.message, DIAGNOSTIC_LENGTH, "%s", message);
+	// some messages end in a newline for the printed form
+	size_t length = strlen(trap->diagnostic.message);
+	while (length > 0 && trap->diagnostic.message[length - 1] == '\n')
+		trap->diagnostic.message[--length] = '\0';
+	longjmp(trap->jump, 1);
+}
+
+void Diagnostic_print(Diagnostic *diagnostic) {
+	if (diagnostic->line > 0)
+		printf("ERROR AT LINE #%d:\n", diagnostic->line);
+	printf("%s\n", diagnostic->message);
+}
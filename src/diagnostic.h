@@ -0,0 +1,36 @@
+#ifndef DIAGNOSTIC_H
+#define DIAGNOSTIC_H
+
+#include <setjmp.h>
+
+// An error in the program being compiled, or running out of memory while
+// compiling it. Raised on its own the message is printed and the process
+// exits, as the command line always did. Raised inside a trap it is kept
+// and the trap's setjmp returns instead, which is how the library gets its
+// errors back without exiting.
+
+#define DIAGNOSTIC_LENGTH 256
+
+typedef struct Diagnostic {
+	// 0 when it is not about a line, like running out of memory
+	int line;
+	char message[DIAGNOSTIC_LENGTH];
+} Diagnostic;
+
+typedef struct DiagnosticTrap {
+	jmp_buf jump;
+	Diagnostic diagnostic;
+	struct DiagnosticTrap *outer;
+} DiagnosticTrap;
+
+// traps are per thread and nest, the last one set is released first
+void Diagnostic_trap(DiagnosticTrap *trap);
+
+void Diagnostic_release(DiagnosticTrap *trap);
+
+void Diagnostic_raise(int line, const char *message) __attribute__((noreturn));
+
+// as the command line prints it
+void Diagnostic_print(Diagnostic *diagnostic);
+
+#endif
@@ -2,39 +2,122 @@
 #include <stdlib.h>
 #include <string.h>
 #include "emit.h"
+#include "mem.h"
+#include "diagnostic.h"
 
-Emitter *emit;
+_Thread_local Emitter *emit;
 
 void Emitter_create(char *path) {
-	Emitter *emitter = malloc(sizeof(Emitter));
-	emitter->fullPath = strdup(path);
-	
-	// this is to make sure it exists for makefile
-	FILE *outputFile = fopen(emitter->fullPath, "w");
-	fclose(outputFile);
+	Emitter *emitter = calloc(1, sizeof(Emitter));
+	if (emitter == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the emitter.");
+	}
+	Mem_add(MEM_EMITTER, emitter);
+	// set first, so Emitter_kill frees it after an error below
+	emit = emitter;
+	if (path != NULL) {
+		emitter->fullPath = strdup(path);
+		Mem_add(MEM_EMITTER, emitter->fullPath);
 
-	emitter->header = fopen(HEADER_NAME, "w");
-	emitter->code = fopen(CODE_NAME, "w");
+		// this is to make sure it exists for makefile
+		FILE *outputFile = fopen(emitter->fullPath, "w");
+		if (outputFile == NULL) {
+			char message[DIAGNOSTIC_LENGTH];
+			snprintf(message, sizeof(message), "%s could not be opened.", emitter->fullPath);
+			Diagnostic_raise(0, message);
+		}
+		fclose(outputFile);
+	}
 
-	emit = emitter;
+	emitter->header = open_memstream(&emitter->headerText, &emitter->headerSize);
+	emitter->code = open_memstream(&emitter->codeText, &emitter->codeSize);
+	if (emitter->header == NULL || emitter->code == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the emitter.");
+	}
+	emitter->lineStart = 1;
 }
 
 void Emitter_kill() {
 	if (emit == NULL)
 		return;
-	fclose(emit->header);
-	fclose(emit->code);
+	if (emit->header != NULL)
+		fclose(emit->header);
+	if (emit->code != NULL)
+		fclose(emit->code);
+	Mem_remove(MEM_EMITTER, emit->headerText);
+	Mem_remove(MEM_EMITTER, emit->codeText);
+	Mem_remove(MEM_EMITTER, emit->fullPath);
+	Mem_remove(MEM_EMITTER, emit->source);
+	Mem_remove(MEM_EMITTER, emit);
+	free(emit->headerText);
+	free(emit->codeText);
 	free(emit->fullPath);
+	free(emit->source);
 	free(emit);
+	emit = NULL;
+}
+
+// code from one source line is kept on one line of C, a #line starts every
+// line that would map to the wrong source line, so gcc's errors, gdb, perf
+// and the sanitizers point at the .teeny file
+static int Emitter_mapping() {
+	return emit->source != NULL && emit->sourceLine > 0;
+}
+
+static void Emitter_mapLine() {
+	if (emit->lineOpen) {
+		emit->lineOpen = 0;
+		if (emit->sourceLine == emit->mappedLine) {
+			fputs(" ", emit->code);
+			return;
+		}
+		fputs("\n", emit->code);
+		emit->lineStart = 1;
+		emit->mappedLine++;
+	}
+	if (!emit->lineStart || !Emitter_mapping() || emit->mappedLine == emit->sourceLine)
+		return;
+	fprintf(emit->code, "#line %d \"%s\"\n", emit->sourceLine, emit->source);
+	emit->mappedLine = emit->sourceLine;
 }
 
 void Emitter_emit(char *code) {
+	if (*code == '\0')
+		return;
+	Emitter_mapLine();
 	fputs(code, emit->code);
+	emit->lineStart = 0;
 }
 
 void Emitter_emitLine(char *code) {
+	Emitter_mapLine();
 	fputs(code, emit->code);
+	if (Emitter_mapping()) {
+		emit->lineOpen = 1;
+		emit->lineStart = 0;
+		return;
+	}
 	fputs("\n", emit->code);
+	emit->lineStart = 1;
+	if (emit->mappedLine > 0)
+		emit->mappedLine++;
+}
+
+// from now on code is marked as coming from this file
+void Emitter_source(char *path) {
+	emit->source = malloc(strlen(path) * 2 + 1);
+	char *to = emit->source;
+	while (*path != '\0') {
+		if (*path == '"' || *path == '\\')
+			*to++ = '\\';
+		*to++ = *path++;
+	}
+	*to = '\0';
+	Mem_add(MEM_EMITTER, emit->source);
+}
+
+void Emitter_sourceLine(int line) {
+	emit->sourceLine = line;
 }
 
 void Emitter_header(char *code) {
@@ -46,20 +129,40 @@ void Emitter_headerLine(char *code) {
 	fputs("\n", emit->header);
 }
 
-void Emitter_writeFile() {
-	FILE *outputFile = fopen(emit->fullPath, "w");
+static void Emitter_close() {
+	if (emit->lineOpen)
+		fputs("\n", emit->code);
 	fclose(emit->header);
 	fclose(emit->code);
-	emit->header = fopen(HEADER_NAME, "r");
-	emit->code = fopen(CODE_NAME, "r");
-	
-	int c;
+	emit->header = NULL;
+	emit->code = NULL;
+	Mem_add(MEM_EMITTER, emit->headerText);
+	Mem_add(MEM_EMITTER, emit->codeText);
+}
 
-	while ((c = fgetc(emit->header)) != EOF) {
-		fputc(c, outputFile);
-	}
-	while ((c = fgetc(emit->code)) != EOF) {
-		fputc(c, outputFile);
+// the whole C file, for the caller to free
+char *Emitter_text(size_t *length) {
+	Emitter_close();
+	char *text = malloc(emit->headerSize + emit->codeSize + 1);
+	if (text == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for the emitter.");
+	memcpy(text, emit->headerText, emit->headerSize);
+	memcpy(text + emit->headerSize, emit->codeText, emit->codeSize);
+	text[emit->headerSize + emit->codeSize] = '\0';
+	*length = emit->headerSize + emit->codeSize;
+	return text;
+}
+
+void Emitter_writeFile() {
+	Emitter_close();
+
+	FILE *outputFile = fopen(emit->fullPath, "w");
+	if (outputFile == NULL) {
+		char message[DIAGNOSTIC_LENGTH];
+		snprintf(message, sizeof(message), "%s could not be opened.", emit->fullPath);
+		Diagnostic_raise(0, message);
 	}
+	fwrite(emit->headerText, 1, emit->headerSize, outputFile);
+	fwrite(emit->codeText, 1, emit->codeSize, outputFile);
 	fclose(outputFile);
 }
@@ -1,17 +1,32 @@
 #ifndef EMIT_H
 #define EMIT_H
 
-#define HEADER_NAME ".header"
-#define CODE_NAME ".code"
-
 #include <stdio.h>
 
+// Generated C is collected in memory, declarations in header and code in
+// code, and only written out together. Every thread has its own emitter, so
+// compilations running at the same time do not share one.
+
 typedef struct Emitter {
 	char *fullPath;
 	FILE *header;
 	FILE *code;
+	// what header and code collected, once they were closed for the output
+	char *headerText;
+	size_t headerSize;
+	char *codeText;
+	size_t codeSize;
+	// the .teeny file #line directives name, already escaped, or NULL
+	char *source;
+	// the source line the code being emitted belongs to, and the one the
+	// next line of code maps to without a new directive, 0 for none
+	int sourceLine;
+	int mappedLine;
+	int lineStart;
+	int lineOpen;
 } Emitter;
 
+// with a NULL path nothing is written, the code is only had from Emitter_text
 void Emitter_create(char *path);
 
 void Emitter_kill();
@@ -24,6 +39,12 @@ void Emitter_header(char *code);
 
 void Emitter_headerLine(char *code);
 
+void Emitter_source(char *path);
+
+void Emitter_sourceLine(int line);
+
+char *Emitter_text(size_t *length);
+
 void Emitter_writeFile();
 
 #endif
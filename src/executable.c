@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include <sys/stat.h>
+#include "executable.h"
+#include "diagnostic.h"
+
+// built from x64rt.c by the Makefile
+static const unsigned char runtimeBlob[] = {
+#include "x64rt.inc"
+};
+
+static unsigned long Executable_align(unsigned long value, unsigned long alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void Executable_segment(Elf64_Phdr *p, Elf64_Word type, Elf64_Word flags, unsigned long offset, unsigned long address, unsigned long fileSize, unsigned long memorySize) {
+	p->p_type = type;
+	p->p_flags = flags;
+	p->p_offset = offset;
+	p->p_vaddr = address;
+	p->p_paddr = address;
+	p->p_filesz = fileSize;
+	p->p_memsz = memorySize;
+	p->p_align = type == PT_LOAD ? EXECUTABLE_PAGE : 16;
+}
+
+void Executable_write(char *path, X64 *x) {
+	unsigned long headers = sizeof(Elf64_Ehdr) + 3 * sizeof(Elf64_Phdr);
+	unsigned long offsets[X64_SECTIONS];
+	offsets[X64_CODE] = Executable_align(headers, 16);
+	offsets[X64_RODATA] = Executable_align(offsets[X64_CODE] + x->code.length, 16);
+	offsets[X64_RUNTIME] = Executable_align(offsets[X64_RODATA] + x->rodata.length, 64);
+	unsigned long fileSize = offsets[X64_RUNTIME] + sizeof(runtimeBlob);
+	offsets[X64_BSS] = Executable_align(fileSize, EXECUTABLE_PAGE);
+
+	unsigned long addresses[X64_SECTIONS];
+	int i;
+	for (i = 0; i < X64_SECTIONS; i++)
+		addresses[i] = EXECUTABLE_BASE + offsets[i];
+	X64_resolve(x, addresses);
+
+	unsigned char *image = calloc(1, fileSize);
+	if (image == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the executable.");
+	}
+
+	Elf64_Ehdr *header = (Elf64_Ehdr *) image;
+	memcpy(header->e_ident, ELFMAG, SELFMAG);
+	header->e_ident[EI_CLASS] = ELFCLASS64;
+	header->e_ident[EI_DATA] = ELFDATA2LSB;
+	header->e_ident[EI_VERSION] = EV_CURRENT;
+	header->e_ident[EI_OSABI] = ELFOSABI_SYSV;
+	header->e_type = ET_EXEC;
+	header->e_machine = EM_X86_64;
+	header->e_version = EV_CURRENT;
+	header->e_entry = addresses[X64_CODE];
+	header->e_phoff = sizeof(Elf64_Ehdr);
+	header->e_ehsize = sizeof(Elf64_Ehdr);
+	header->e_phentsize = sizeof(Elf64_Phdr);
+	header->e_phnum = 3;
+
+	Elf64_Phdr *segments = (Elf64_Phdr *) (image + sizeof(Elf64_Ehdr));
+	Executable_segment(&segments[0], PT_LOAD, PF_R | PF_X, 0, EXECUTABLE_BASE, fileSize, fileSize);
+	Executable_segment(&segments[1], PT_LOAD, PF_R | PF_W, 0, addresses[X64_BSS], 0, x->bssSize);
+	Executable_segment(&segments[2], PT_GNU_STACK, PF_R | PF_W, 0, 0, 0, 0);
+
+	memcpy(image + offsets[X64_CODE], x->code.bytes, x->code.length);
+	memcpy(image + offsets[X64_RODATA], x->rodata.bytes, x->rodata.length);
+	memcpy(image + offsets[X64_RUNTIME], runtimeBlob, sizeof(runtimeBlob));
+
+	FILE *file = fopen(path, "wb");
+	int written = file != NULL && fwrite(image, 1, fileSize, file) == fileSize;
+	if (file != NULL)
+		fclose(file);
+	free(image);
+	if (!written) {
+		char message[DIAGNOSTIC_LENGTH];
+		snprintf(message, sizeof(message), file == NULL ? "Unable to open %s for writing." : "Unable to write %s.", path);
+		Diagnostic_raise(0, message);
+	}
+	chmod(path, 0755);
+}
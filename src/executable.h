@@ -0,0 +1,16 @@
+#ifndef EXECUTABLE_H
+#define EXECUTABLE_H
+
+#include "x64.h"
+
+// Writes a static x86-64 Linux executable around the native backend's code,
+// with no libc and no dynamic loader. Text, constants and the runtime blob
+// share one read only segment, variables and runtime state live in a zero
+// filled one.
+
+#define EXECUTABLE_BASE 0x400000UL
+#define EXECUTABLE_PAGE 4096UL
+
+void Executable_write(char *path, X64 *x);
+
+#endif
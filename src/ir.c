@@ -0,0 +1,1473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "timer.h"
+#include "mem.h"
+#include "diagnostic.h"
+
+static const char *IR_opNames[] = {
+	[IR_CONST] = "const", [IR_UNDEF] = "undef",
+	[IR_STRVAR] = "strvar", [IR_STRLIT] = "strlit", [IR_STRTMP] = "strtmp",
+	[IR_PHI] = "phi",
+	[IR_ADD] = "add", [IR_SUB] = "sub", [IR_MUL] = "mul", [IR_DIV] = "div",
+	[IR_LT] = "lt", [IR_LE] = "le", [IR_GT] = "gt", [IR_GE] = "ge", [IR_EQ] = "eq", [IR_NE] = "ne",
+	[IR_CONVERT] = "convert",
+	[IR_STREQ] = "streq", [IR_STRNE] = "strne", [IR_LOAD] = "load", [IR_ENV] = "env",
+	[IR_PRINT_INT] = "print_int", [IR_PRINT_FLOAT] = "print_float",
+	[IR_PRINT_BOOL] = "print_bool", [IR_PRINT_STR] = "print_str",
+	[IR_WRITE] = "write", [IR_INPUT] = "input", [IR_STRINPUT] = "strinput",
+	[IR_STRSET] = "strset", [IR_STRCAT] = "strcat",
+	[IR_STORE] = "store", [IR_ENV_SET] = "env_set", [IR_ENV_ADD] = "env_add",
+	[IR_PARALLEL] = "parallel", [IR_BOUNDS] = "bounds",
+	[IR_PROF_HIT] = "prof_hit", [IR_PROF_TIME] = "prof_time", [IR_PROF_TRIP] = "prof_trip",
+	[IR_JUMP] = "jump", [IR_BRANCH] = "branch", [IR_RETURN] = "return"
+};
+
+static const char *IR_typeNames[] = {
+	[IR_VOID] = "void", [IR_INT] = "int", [IR_FLOAT] = "float",
+	[IR_DOUBLE] = "double", [IR_STRING] = "string"
+};
+
+IR *IR_create(AST *ast) {
+	IR *ir = calloc(1, sizeof(IR));
+	if (ir == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	ir->ast = ast;
+	ir->blocks = List_create();
+	ir->values = List_create();
+	ir->labels = List_create();
+	ir->profiled = List_create();
+	ir->parallels = List_create();
+	ir->captures = List_create();
+	ir->fields = List_create();
+	ir->variableCount = List_count(ast->symbols);
+	ir->variables = malloc(sizeof(Symbol *) * (ir->variableCount + 1));
+	if (ir->variables == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	int count = 0;
+	LIST_FOREACH(ast->symbols, first, next, cur) {
+		ir->variables[count++] = (Symbol *) cur->value;
+	}
+	ir->writes = calloc(ir->variableCount + 1, sizeof(IRWrites));
+	if (ir->writes == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	Mem_add(MEM_IR, ir->writes);
+	return ir;
+}
+
+static void IR_killValues(List *values) {
+	LIST_FOREACH(values, first, next, cur) {
+		IRValue *v = (IRValue *) cur->value;
+		Mem_remove(MEM_IR, v->operands);
+		Mem_remove(MEM_IR, v);
+		free(v->operands);
+		List_destroy(v->users);
+		free(v->text);
+		free(v);
+	}
+	List_destroy(values);
+}
+
+static void IR_killBlocks(List *blocks) {
+	LIST_FOREACH(blocks, first, next, cur) {
+		IRBlock *b = (IRBlock *) cur->value;
+		List_destroy(b->values);
+		List_destroy(b->preds);
+		List_destroy(b->incomplete);
+		Mem_remove(MEM_IR, b->defs);
+		Mem_remove(MEM_IR, b);
+		free(b->defs);
+		free(b);
+	}
+	List_destroy(blocks);
+}
+
+static void IR_killLabels(List *labels) {
+	LIST_FOREACH(labels, first, next, cur) {
+		free(((IRLabel *) cur->value)->name);
+	}
+	List_clear_destroy(labels);
+}
+
+void IR_kill(IR *ir) {
+	if (ir == NULL)
+		return;
+	LIST_FOREACH(ir->parallels, first, next, cur) {
+		IR_kill((IR *) cur->value);
+	}
+	List_destroy(ir->parallels);
+	List_destroy(ir->captures);
+	List_destroy(ir->fields);
+	IR_killValues(ir->values);
+	IR_killBlocks(ir->blocks);
+	IR_killLabels(ir->labels);
+	List_destroy(ir->profiled);
+	int i;
+	for (i = 0; i < ir->variableCount; i++) {
+		Mem_remove(MEM_IR, ir->writes[i].times);
+		free(ir->writes[i].times);
+	}
+	Mem_remove(MEM_IR, ir->writes);
+	free(ir->writes);
+	free(ir->variables);
+	free(ir);
+}
+
+// the type of a variable, or of one element of an array
+static IRType IR_variableType(IR *ir, int variable) {
+	switch (ir->variables[variable]->type) {
+		case FLOAT_VAR:
+		case FLOAT_ARRAY:
+			return IR_FLOAT;
+		case STRING_VAR:
+			return IR_STRING;
+		default:
+			return IR_INT;
+	}
+}
+
+void IR_lower(IR *ir, AST *ast) {
+	IRBlock *entry = IR_block(ir);
+	entry->sealed = 1;
+	IR_start(ir, entry);
+	IR_statements(ir, ast->children->first, NULL);
+	IR_append(ir, IR_RETURN, IR_VOID);
+	// any GOTO can jump to a label, so only now are all of their predecessors known
+	LIST_FOREACH(ir->labels, first, next, cur) {
+		IR_sealBlock(ir, ((IRLabel *) cur->value)->block);
+	}
+}
+
+// statements from current up to, not including, end
+void IR_statements(IR *ir, ListNode *current, ListNode *end) {
+	while (current != end) {
+		ASTNode *statement = (ASTNode *) current->value;
+		// a profile keeps every PRINT on its own line
+		if (!ir->profile && AST_isConstantPrint(statement)) {
+			Timer_begin("IR_statement", statement->token->text, TIMER_STATEMENT);
+			IR_constantPrints(ir, &current);
+			Timer_end();
+			if (current == end)
+				break;
+			continue;
+		}
+		Timer_begin("IR_statement", statement->token->text, TIMER_STATEMENT);
+		IR_statement(ir, statement);
+		Timer_end();
+		current = current->next;
+	}
+}
+
+// PRINT "a" followed by PRINT "b" becomes a single write of "a\nb\n"
+void IR_constantPrints(IR *ir, ListNode **current) {
+	size_t length = 0;
+	ListNode *node;
+	for (node = *current; node != NULL && AST_isConstantPrint((ASTNode *) node->value); node = node->next)
+		length += strlen(((ASTNode *) List_first(((ASTNode *) node->value)->children))->token->text) + 1;
+
+	IRValue *write = IR_append(ir, IR_WRITE, IR_VOID);
+	write->text = malloc(length + 1);
+	length = 0;
+	while (*current != NULL && AST_isConstantPrint((ASTNode *) (*current)->value)) {
+		char *text = ((ASTNode *) List_first(((ASTNode *) (*current)->value)->children))->token->text;
+		size_t size = strlen(text);
+		memcpy(write->text + length, text, size);
+		length += size;
+		write->text[length++] = '\n';
+		*current = (*current)->next;
+	}
+	write->text[length] = '\0';
+}
+
+// a string variable, literal or temporary, by name
+static IRValue *IR_string(IR *ir, IROp op, int index) {
+	IRValue *value = IR_new(ir, op, IR_STRING);
+	value->variable = index;
+	return value;
+}
+
+void IR_statement(IR *ir, ASTNode *statement) {
+	ir->ast->currentLineNumber = statement->lineNumber;
+	ir->line = statement->lineNumber;
+	ASTNode *child = (ASTNode *) List_first(statement->children);
+	IRValue *value;
+	IRValue *instruction;
+	IRBlock *top;
+	IRBlock *body;
+	IRBlock *done;
+	int variable;
+	IRType type;
+	ProfileLine *counts;
+	int slot = -1;
+	// a label has to start its block, and there is nothing to time in it
+	if (ir->profile && statement->token->type != LABEL && statement->token->type != ARRAY)
+		slot = IR_profile(ir, statement);
+
+	switch (statement->token->type) {
+		case PRINT:
+			value = IR_comparison(ir, child);
+			// the value is passed the way the runtime's print takes it
+			if (child->subType == BOOL_VAR || child->subType == INT_VAR) {
+				value = IR_convert(ir, value, IR_INT);
+				instruction = IR_append(ir, child->subType == BOOL_VAR ? IR_PRINT_BOOL : IR_PRINT_INT, IR_VOID);
+			} else if (child->subType == STRING_VAR) {
+				instruction = IR_append(ir, IR_PRINT_STR, IR_VOID);
+			} else {
+				value = IR_convert(ir, value, IR_DOUBLE);
+				instruction = IR_append(ir, IR_PRINT_FLOAT, IR_VOID);
+			}
+			IR_addOperand(instruction, value);
+			break;
+
+		case IF:
+		case ELSEIF:
+			done = IR_block(ir);
+			IR_joinFrom(ir, done);
+			if (!IR_ifChain(ir, statement, done))
+				IR_if(ir, statement, done, slot);
+			IR_joinEnd(ir, done);
+			IR_sealBlock(ir, done);
+			IR_start(ir, done);
+			break;
+
+		case WHILE:
+			top = IR_block(ir);
+			IR_joinFrom(ir, top);
+			IR_jump(ir, top);
+			IR_start(ir, top);
+			body = IR_block(ir);
+			done = IR_block(ir);
+			instruction = IR_branch(ir, IR_comparison(ir, child), body, done);
+			counts = Profile_line(ir->guide, statement);
+			if (counts != NULL) {
+				// the condition is tested once more than the body runs
+				instruction->expect = IR_expectation(counts->trips, counts->hits + counts->trips);
+				body->cold |= counts->trips == 0;
+			}
+			IR_sealBlock(ir, body);
+			IR_sealBlock(ir, done);
+			IR_start(ir, body);
+			if (slot >= 0)
+				IR_profilePoint(ir, IR_PROF_TRIP, slot);
+			IR_statements(ir, statement->children->first->next, NULL);
+			IR_jump(ir, top);
+			IR_joinEnd(ir, top);
+			IR_sealBlock(ir, top);
+			IR_start(ir, done);
+			break;
+
+		case FOR:
+			if (statement->subType == PARALLEL)
+				IR_parallel(ir, statement);
+			else
+				IR_for(ir, statement, slot);
+			break;
+
+		case LABEL:
+			ir->labelsPlaced++;
+			top = IR_label(ir, child->token->text)->block;
+			IR_jump(ir, top);
+			IR_start(ir, top);
+			break;
+
+		case GOTO:
+			IR_jump(ir, IR_label(ir, child->token->text)->block);
+			// whatever follows is only reachable through a label of its own
+			body = IR_block(ir);
+			body->sealed = 1;
+			IR_start(ir, body);
+			break;
+
+		case LET:
+			variable = IR_variable(ir, child->token->text);
+			if (AST_isArray(ir->variables[variable]->type)) {
+				value = IR_index(ir, variable, child);
+				IR_storeElement(ir, variable, value, IR_comparison(ir, (ASTNode *) List_last(statement->children)));
+				break;
+			}
+			child = (ASTNode *) List_last(statement->children);
+			if (IR_variableType(ir, variable) != IR_STRING) {
+				IR_store(ir, variable, IR_comparison(ir, child));
+			} else if (child->token->type == PLUS) {
+				IR_concat(ir, child, IR_string(ir, IR_STRVAR, variable));
+			} else {
+				value = IR_comparison(ir, child);
+				instruction = IR_append(ir, IR_STRSET, IR_VOID);
+				IR_addOperand(instruction, IR_string(ir, IR_STRVAR, variable));
+				IR_addOperand(instruction, value);
+			}
+			break;
+
+		case INPUT:
+			variable = IR_variable(ir, child->token->text);
+			type = IR_variableType(ir, variable);
+			if (type == IR_STRING) {
+				instruction = IR_append(ir, IR_STRINPUT, IR_VOID);
+				IR_addOperand(instruction, IR_string(ir, IR_STRVAR, variable));
+				break;
+			}
+			// the runtime leaves the variable alone at the end of input
+			if (AST_isArray(ir->variables[variable]->type)) {
+				IRValue *index = IR_index(ir, variable, child);
+				value = IR_load(ir, variable, index);
+				instruction = IR_append(ir, IR_INPUT, type);
+				IR_addOperand(instruction, value);
+				IR_storeElement(ir, variable, index, instruction);
+				break;
+			}
+			value = IR_append(ir, IR_INPUT, type);
+			IR_addOperand(value, IR_readVariable(ir, variable, ir->current));
+			if (ir->variables[variable]->type == BOOL_VAR)
+				value = IR_binary(ir, NOTEQ, value, IR_constant(ir, IR_INT, "0"));
+			IR_writeVariable(ir, variable, ir->current, value);
+			break;
+
+		case ARRAY:
+			// arrays are static and start out zeroed, there is nothing to run
+			break;
+
+		default:
+			AST_abort("IR does not know this statement.");
+			break;
+	}
+	// after a GOTO this lands in a block nothing reaches and is dropped
+	if (slot >= 0)
+		IR_profilePoint(ir, IR_PROF_TIME, slot);
+}
+
+// gives the statement the next profile slot and counts a hit on it
+int IR_profile(IR *ir, ASTNode *statement) {
+	List_push(ir->profiled, statement);
+	int slot = List_count(ir->profiled) - 1;
+	IR_profilePoint(ir, IR_PROF_HIT, slot);
+	return slot;
+}
+
+void IR_profilePoint(IR *ir, IROp op, int slot) {
+	IR_append(ir, op, IR_VOID)->variable = slot;
+}
+
+// statement.children = List(comparison, {statement}, [ELSEIF | ELSE]),
+// every branch ends in a jump to done. An ELSEIF only counts how often it is
+// tested and taken, its time is part of the IF's.
+void IR_if(IR *ir, ASTNode *statement, IRBlock *done, int slot) {
+	ListNode *first = statement->children->first;
+	ASTNode *tail = (ASTNode *) List_last(statement->children);
+	ListNode *end = NULL;
+	if (statement->children->last != first && (tail->token->type == ELSEIF || tail->token->type == ELSE))
+		end = statement->children->last;
+	else
+		tail = NULL;
+
+	IRBlock *then = IR_block(ir);
+	IRBlock *otherwise = tail == NULL ? done : IR_block(ir);
+	IRValue *branch = IR_branch(ir, IR_comparison(ir, (ASTNode *) first->value), then, otherwise);
+	ProfileLine *counts = Profile_line(ir->guide, statement);
+	if (counts != NULL) {
+		branch->expect = IR_expectation(counts->trips, counts->hits);
+		then->cold |= counts->trips == 0;
+		if (tail != NULL)
+			otherwise->cold |= counts->hits == counts->trips;
+	}
+	IR_sealBlock(ir, then);
+	IR_start(ir, then);
+	if (slot >= 0)
+		IR_profilePoint(ir, IR_PROF_TRIP, slot);
+	IR_statements(ir, first->next, end);
+	IR_jump(ir, done);
+	if (tail == NULL)
+		return;
+
+	IR_sealBlock(ir, otherwise);
+	IR_start(ir, otherwise);
+	if (tail->token->type == ELSEIF) {
+		IR_if(ir, tail, done, ir->profile ? IR_profile(ir, tail) : -1);
+	} else {
+		IR_statements(ir, tail->children->first, NULL);
+		IR_jump(ir, done);
+	}
+}
+
+// With a profile, an IF/ELSEIF chain whose conditions all compare the same
+// INT variable to numbers is tested most taken arm first. Each arm is cut
+// down to the values no earlier arm takes, which makes the arms disjoint
+// and so free to reorder. Returns 0 and lowers nothing when that fails.
+int IR_ifChain(IR *ir, ASTNode *statement, IRBlock *done) {
+	ProfileLine *counts = Profile_line(ir->guide, statement);
+	if (counts == NULL || ir->profile)
+		return 0;
+	int count = 0;
+	ASTNode *node = statement;
+	while (node != NULL && node->token->type != ELSE) {
+		count++;
+		ASTNode *tail = (ASTNode *) List_last(node->children);
+		node = node->children->last != node->children->first && (tail->token->type == ELSEIF || tail->token->type == ELSE) ? tail : NULL;
+	}
+	if (count < 2)
+		return 0;
+
+	// one more for an ELSE, whose values are whatever no arm takes
+	IRArm *arms = calloc(count + 1, sizeof(IRArm));
+	IRArm **order = malloc(sizeof(IRArm *) * (count + 1));
+	// the values earlier arms take, sorted and merged
+	long long *coveredLow = malloc(sizeof(long long) * (count + 1));
+	long long *coveredHigh = malloc(sizeof(long long) * (count + 1));
+	if (arms == NULL || order == NULL || coveredLow == NULL || coveredHigh == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	int covered = 0;
+	char *name = NULL;
+	ASTNode *otherwise = NULL;
+	int ok = 1;
+	int moved = 0;
+	int i;
+	node = statement;
+	for (i = 0; ok && i < count; i++) {
+		IRArm *arm = &arms[i];
+		arm->node = node;
+		arm->body = node->children->first->next;
+		ASTNode *tail = (ASTNode *) List_last(node->children);
+		if (node->children->last != node->children->first && (tail->token->type == ELSEIF || tail->token->type == ELSE))
+			arm->end = node->children->last;
+		if (arm->end != NULL && tail->token->type == ELSE)
+			otherwise = tail;
+
+		char *variable;
+		long long low;
+		long long high;
+		ProfileLine *armCounts = Profile_line(ir->guide, node);
+		ok = armCounts != NULL && IR_armRange((ASTNode *) List_first(node->children), &variable, &low, &high)
+			&& (name == NULL || strcmp(name, variable) == 0)
+			&& IR_armPieces(arm, low, high, coveredLow, coveredHigh, covered);
+		if (!ok)
+			break;
+		name = variable;
+		covered = IR_cover(coveredLow, coveredHigh, covered, low, high);
+		arm->trips = armCounts->trips;
+
+		// stable, most taken first
+		int at = i;
+		while (at > 0 && order[at - 1]->trips < arm->trips) {
+			order[at] = order[at - 1];
+			at--;
+			moved = 1;
+		}
+		order[at] = arm;
+		node = tail;
+	}
+
+	int total = count;
+	if (ok && otherwise != NULL) {
+		IRArm *arm = &arms[total++];
+		arm->node = otherwise;
+		arm->body = otherwise->children->first;
+		unsigned long long taken = 0;
+		for (i = 0; i < count; i++)
+			taken += arms[i].trips;
+		arm->trips = counts->hits > taken ? counts->hits - taken : 0;
+		// it can only move up if its values fit in a few ranges
+		int at = count;
+		if (IR_armPieces(arm, INT_MIN, INT_MAX, coveredLow, coveredHigh, covered)) {
+			while (at > 0 && order[at - 1]->trips < arm->trips) {
+				order[at] = order[at - 1];
+				at--;
+				moved = 1;
+			}
+		}
+		order[at] = arm;
+	}
+
+	if (ok && moved) {
+		IRValue *value = IR_readVariable(ir, IR_variable(ir, name), ir->current);
+		unsigned long long reaching = counts->hits;
+		for (i = 0; i < total; i++) {
+			if (i == total - 1 && otherwise != NULL) {
+				// every other value went elsewhere, so the last arm needs no test
+				ir->current->cold |= order[i]->trips == 0;
+				IR_statements(ir, order[i]->body, order[i]->end);
+				IR_jump(ir, done);
+				break;
+			}
+			IRBlock *then = IR_block(ir);
+			IRBlock *next = i < total - 1 ? IR_block(ir) : done;
+			ir->line = order[i]->node->lineNumber;
+			IR_armTest(ir, value, order[i], then, next, IR_expectation(order[i]->trips, reaching));
+			then->cold |= order[i]->trips == 0;
+			reaching = reaching > order[i]->trips ? reaching - order[i]->trips : 0;
+			IR_sealBlock(ir, then);
+			IR_start(ir, then);
+			IR_statements(ir, order[i]->body, order[i]->end);
+			IR_jump(ir, done);
+			if (next == done)
+				break;
+			IR_sealBlock(ir, next);
+			IR_start(ir, next);
+		}
+	}
+	free(coveredHigh);
+	free(coveredLow);
+	free(order);
+	free(arms);
+	return ok && moved;
+}
+
+// "x OP number" or "number OP x" as the values of x it holds for, 0 when
+// the condition is anything else
+int IR_armRange(ASTNode *condition, char **variable, long long *low, long long *high) {
+	ASTItem **items = AST_flatten(condition);
+	int ok = items[0] != NULL && items[1] != NULL && items[2] != NULL && items[3] == NULL
+		&& items[0]->kind == AST_ITEM_VALUE && items[1]->kind == AST_ITEM_OPERATOR && items[2]->kind == AST_ITEM_VALUE;
+	if (!ok) {
+		AST_killItems(items);
+		return 0;
+	}
+	ASTNode *ident = items[0]->node;
+	ASTNode *number = items[2]->node;
+	TokenType op = items[1]->node->token->type;
+	if (ident->token->type == NUMBERINT) {
+		ident = items[2]->node;
+		number = items[0]->node;
+		op = op == LT ? GT : op == GT ? LT : op == LTEQ ? GTEQ : op == GTEQ ? LTEQ : op;
+	}
+	AST_killItems(items);
+	if (ident->token->type != IDENT || AST_getSymbolType(ident->token->text) != INT_VAR || number->token->type != NUMBERINT)
+		return 0;
+	long long c = strtoll(number->token->text, NULL, 10);
+	if (c > INT_MAX)
+		return 0;
+	*variable = ident->token->text;
+	*low = INT_MIN;
+	*high = INT_MAX;
+	switch (op) {
+		case EQEQ:
+			*low = *high = c;
+			return 1;
+		case LT:
+			*high = c - 1;
+			return 1;
+		case LTEQ:
+			*high = c;
+			return 1;
+		case GT:
+			*low = c + 1;
+			return 1;
+		case GTEQ:
+			*low = c;
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+// low to high minus the covered ranges, 0 when nothing or too much is left
+int IR_armPieces(IRArm *arm, long long low, long long high, long long *coveredLow, long long *coveredHigh, int covered) {
+	long long from = low;
+	int i;
+	arm->pieces = 0;
+	for (i = 0; i < covered && from <= high && coveredLow[i] <= high; i++) {
+		if (coveredHigh[i] < from)
+			continue;
+		if (coveredLow[i] > from) {
+			if (arm->pieces == IR_ARM_PIECES)
+				return 0;
+			arm->low[arm->pieces] = from;
+			arm->high[arm->pieces++] = coveredLow[i] - 1;
+		}
+		from = coveredHigh[i] + 1;
+	}
+	if (from <= high) {
+		if (arm->pieces == IR_ARM_PIECES)
+			return 0;
+		arm->low[arm->pieces] = from;
+		arm->high[arm->pieces++] = high;
+	}
+	return arm->pieces > 0;
+}
+
+// adds low to high to the sorted ranges and merges them, returns their count
+int IR_cover(long long *lows, long long *highs, int count, long long low, long long high) {
+	int at = count++;
+	while (at > 0 && lows[at - 1] > low) {
+		lows[at] = lows[at - 1];
+		highs[at] = highs[at - 1];
+		at--;
+	}
+	lows[at] = low;
+	highs[at] = high;
+	int merged = 0;
+	int i;
+	for (i = 0; i < count; i++) {
+		if (merged > 0 && lows[i] <= highs[merged - 1] + 1) {
+			if (highs[i] > highs[merged - 1])
+				highs[merged - 1] = highs[i];
+			continue;
+		}
+		lows[merged] = lows[i];
+		highs[merged++] = highs[i];
+	}
+	return merged;
+}
+
+static IRValue *IR_compareTo(IR *ir, IRValue *value, TokenType op, long long number, IRBlock *then, IRBlock *otherwise) {
+	char text[32];
+	sprintf(text, "%lld", number);
+	return IR_branch(ir, IR_binary(ir, op, value, IR_constant(ir, IR_INT, text)), then, otherwise);
+}
+
+// goes to then when value is in one of the arm's ranges, ending the current
+// block. Only a single range gets the hint, with two compares only when
+// both have to be likely.
+void IR_armTest(IR *ir, IRValue *value, IRArm *arm, IRBlock *then, IRBlock *otherwise, int expect) {
+	int i;
+	for (i = 0; i < arm->pieces; i++) {
+		IRBlock *miss = i == arm->pieces - 1 ? otherwise : IR_block(ir);
+		long long low = arm->low[i];
+		long long high = arm->high[i];
+		IRValue *lower = NULL;
+		IRValue *branch;
+		if (low == high) {
+			branch = IR_compareTo(ir, value, EQEQ, low, then, miss);
+		} else if (low > INT_MIN && high < INT_MAX) {
+			IRBlock *upper = IR_block(ir);
+			lower = IR_compareTo(ir, value, GTEQ, low, upper, miss);
+			IR_sealBlock(ir, upper);
+			IR_start(ir, upper);
+			branch = IR_compareTo(ir, value, LTEQ, high, then, miss);
+		} else if (high < INT_MAX) {
+			branch = IR_compareTo(ir, value, LTEQ, high, then, miss);
+		} else {
+			branch = IR_compareTo(ir, value, GTEQ, low, then, miss);
+		}
+		if (arm->pieces == 1 && (lower == NULL || expect > 0)) {
+			branch->expect = expect;
+			if (lower != NULL)
+				lower->expect = expect;
+		}
+		if (miss != otherwise) {
+			IR_sealBlock(ir, miss);
+			IR_start(ir, miss);
+		}
+	}
+}
+
+// 1 when a branch went its first way at least 80% of the time, -1 when at
+// most 20%, 0 when it is not known or not lopsided enough to say
+int IR_expectation(unsigned long long taken, unsigned long long total) {
+	if (total == 0)
+		return 0;
+	if (taken * 5 >= total * 4)
+		return 1;
+	if (taken * 5 <= total)
+		return -1;
+	return 0;
+}
+
+// for (v = from; v <= to; v++), to is worked out again every time round
+void IR_for(IR *ir, ASTNode *statement, int slot) {
+	ListNode *current = statement->children->first;
+	int variable = IR_variable(ir, ((ASTNode *) current->value)->token->text);
+	IRType type = IR_variableType(ir, variable);
+	current = current->next;
+	IR_store(ir, variable, IR_comparison(ir, (ASTNode *) current->value));
+	current = current->next;
+
+	IRBlock *top = IR_block(ir);
+	IR_joinFrom(ir, top);
+	IR_jump(ir, top);
+	IR_start(ir, top);
+	IRBlock *body = IR_block(ir);
+	IRBlock *done = IR_block(ir);
+	IRValue *bound = IR_comparison(ir, (ASTNode *) current->value);
+	IRValue *counter = IR_readVariable(ir, variable, top);
+	IR_branch(ir, IR_binary(ir, LTEQ, counter, bound), body, done);
+	IR_sealBlock(ir, body);
+	IR_sealBlock(ir, done);
+
+	IR_start(ir, body);
+	if (slot >= 0)
+		IR_profilePoint(ir, IR_PROF_TRIP, slot);
+	IR_statements(ir, current->next, NULL);
+	counter = IR_readVariable(ir, variable, ir->current);
+	IRValue *one = IR_constant(ir, type, type == IR_INT ? "1" : "1.0f");
+	IR_writeVariable(ir, variable, ir->current, IR_binary(ir, PLUS, counter, one));
+	IR_jump(ir, top);
+	IR_joinEnd(ir, top);
+	IR_sealBlock(ir, top);
+	IR_start(ir, done);
+}
+
+// PARALLEL FOR: the body is lowered into an IR of its own, emitted as a
+// function that runs the iterations from tt_lo to tt_hi, and main hands the
+// whole range to tt_par_run. Main first leaves in the loop's tt_env whatever
+// the body reads of its variables. A REDUCE variable starts every range from
+// 0 and adds what it got to the total, and the range with the last iteration
+// leaves there what the body set, so main carries on as if the loop had run
+// in order.
+void IR_parallel(IR *ir, ASTNode *statement) {
+	ListNode *current = statement->children->first;
+	ASTNode *ident = (ASTNode *) current->value;
+	int counter = IR_variable(ir, ident->token->text);
+	IR_store(ir, counter, IR_comparison(ir, (ASTNode *) current->next->value));
+	IRValue *start = IR_readVariable(ir, counter, ir->current);
+	IRValue *bound = IR_convert(ir, IR_comparison(ir, (ASTNode *) current->next->next->value), IR_INT);
+
+	// the variables main takes back, the loop variable first
+	List *scalars = List_create();
+	List *arrays = List_create();
+	AST_parallelWrites(statement, scalars, arrays);
+	int keptCount = List_count(scalars) + 1;
+	int reducedCount = List_count(ident->children);
+	int *kept = malloc(sizeof(int) * (keptCount + reducedCount));
+	if (kept == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	int *reduced = kept + keptCount;
+	int i = 0;
+	kept[i++] = counter;
+	ListNode *node;
+	for (node = scalars->first; node != NULL; node = node->next)
+		kept[i++] = IR_variable(ir, (char *) node->value);
+	List_destroy(scalars);
+	List_destroy(arrays);
+	i = 0;
+	for (node = ident->children->first; node != NULL; node = node->next)
+		reduced[i++] = IR_variable(ir, ((ASTNode *) node->value)->token->text);
+
+	IR *body = IR_create(ir->ast);
+	body->outer = ir;
+	body->number = List_count(ir->parallels);
+	body->guide = ir->guide;
+	List_push(ir->parallels, body);
+	IR_parallelBody(body, statement, kept, keptCount, reduced, reducedCount);
+	ir->ast->currentLineNumber = statement->lineNumber;
+	ir->line = statement->lineNumber;
+
+	char field[48];
+	sprintf(field, "tt_env%d.last", body->number);
+	List_push(body->fields, IR_envSet(ir, IR_ENV_SET, field, bound));
+	for (node = body->captures->first; node != NULL; node = node->next) {
+		IRValue *capture = (IRValue *) node->value;
+		List_push(body->fields, IR_envSet(ir, IR_ENV_SET, capture->text, IR_readVariable(ir, capture->variable, ir->current)));
+	}
+	for (i = 0; i < keptCount; i++) {
+		sprintf(field, "tt_env%d.l%d", body->number, kept[i]);
+		List_push(body->fields, IR_envSet(ir, IR_ENV_SET, field, IR_readVariable(ir, kept[i], ir->current)));
+	}
+	for (i = 0; i < reducedCount; i++) {
+		IRType type = IR_variableType(ir, reduced[i]);
+		sprintf(field, "tt_env%d.r%d", body->number, reduced[i]);
+		List_push(body->fields, IR_envSet(ir, IR_ENV_SET, field, IR_constant(ir, type, type == IR_INT ? "0" : "0.0f")));
+	}
+
+	IRValue *run = IR_append(ir, IR_PARALLEL, IR_VOID);
+	run->variable = body->number;
+	IR_addOperand(run, start);
+	IR_addOperand(run, bound);
+
+	for (i = 0; i < keptCount; i++) {
+		sprintf(field, "tt_env%d.l%d", body->number, kept[i]);
+		IR_writeVariable(ir, kept[i], ir->current, IR_env(ir, IR_variableType(ir, kept[i]), field));
+	}
+	for (i = 0; i < reducedCount; i++) {
+		sprintf(field, "tt_env%d.r%d", body->number, reduced[i]);
+		IRValue *total = IR_env(ir, IR_variableType(ir, reduced[i]), field);
+		IR_writeVariable(ir, reduced[i], ir->current, IR_binary(ir, PLUS, IR_readVariable(ir, reduced[i], ir->current), total));
+	}
+	free(kept);
+}
+
+// the loop over one range, with the REDUCE variables added to the totals
+// and the kept variables handed back by the range that ends the loop
+void IR_parallelBody(IR *body, ASTNode *statement, int *kept, int keptCount, int *reduced, int reducedCount) {
+	char field[48];
+	int counter = kept[0];
+	int i;
+	IRBlock *entry = IR_block(body);
+	entry->sealed = 1;
+	IR_start(body, entry);
+	IR_writeVariable(body, counter, entry, IR_env(body, IR_INT, "tt_lo"));
+	IRValue *high = IR_env(body, IR_INT, "tt_hi");
+	for (i = 0; i < reducedCount; i++) {
+		IRType type = IR_variableType(body, reduced[i]);
+		IR_writeVariable(body, reduced[i], entry, IR_constant(body, type, type == IR_INT ? "0" : "0.0f"));
+	}
+
+	IRBlock *top = IR_block(body);
+	IR_jump(body, top);
+	IR_start(body, top);
+	IRBlock *loop = IR_block(body);
+	IRBlock *done = IR_block(body);
+	IR_branch(body, IR_binary(body, LTEQ, IR_readVariable(body, counter, top), high), loop, done);
+	IR_sealBlock(body, loop);
+	IR_sealBlock(body, done);
+
+	IR_start(body, loop);
+	IR_statements(body, statement->children->first->next->next->next, NULL);
+	IRValue *next = IR_binary(body, PLUS, IR_readVariable(body, counter, body->current), IR_constant(body, IR_INT, "1"));
+	IR_writeVariable(body, counter, body->current, next);
+	IR_jump(body, top);
+	IR_sealBlock(body, top);
+
+	IR_start(body, done);
+	for (i = 0; i < reducedCount; i++) {
+		sprintf(field, "tt_env%d.r%d", body->number, reduced[i]);
+		IR_envSet(body, IR_ENV_ADD, field, IR_readVariable(body, reduced[i], done));
+	}
+	IRBlock *last = IR_block(body);
+	IRBlock *end = IR_block(body);
+	sprintf(field, "tt_env%d.last", body->number);
+	IR_branch(body, IR_binary(body, EQEQ, high, IR_env(body, IR_INT, field)), last, end);
+	IR_sealBlock(body, last);
+	IR_start(body, last);
+	for (i = 0; i < keptCount; i++) {
+		sprintf(field, "tt_env%d.l%d", body->number, kept[i]);
+		IR_envSet(body, IR_ENV_SET, field, IR_readVariable(body, kept[i], last));
+	}
+	IR_jump(body, end);
+	IR_sealBlock(body, end);
+	IR_start(body, end);
+	IR_append(body, IR_RETURN, IR_VOID);
+}
+
+IRValue *IR_env(IR *ir, IRType type, char *field) {
+	IRValue *value = IR_append(ir, IR_ENV, type);
+	value->text = strdup(field);
+	value->variable = -1;
+	return value;
+}
+
+IRValue *IR_envSet(IR *ir, IROp op, char *field, IRValue *value) {
+	IRValue *set = IR_append(ir, op, IR_VOID);
+	set->text = strdup(field);
+	IR_addOperand(set, value);
+	return set;
+}
+
+// a variable a PARALLEL FOR body reads before it sets it, which main leaves
+// in tt_env, read at the start of the body
+static IRValue *IR_capture(IR *ir, int variable) {
+	char field[48];
+	IRBlock *entry = (IRBlock *) List_first(ir->blocks);
+	IRValue *value = IR_new(ir, IR_ENV, IR_variableType(ir, variable));
+	sprintf(field, "tt_env%d.c%d", ir->number, variable);
+	value->text = strdup(field);
+	value->variable = variable;
+	value->block = entry;
+	List_unshift(entry->values, value);
+	List_push(ir->captures, value);
+	return value;
+}
+
+// converts the value to the variable's type, like a C assignment
+void IR_store(IR *ir, int variable, IRValue *value) {
+	if (ir->variables[variable]->type == BOOL_VAR) {
+		// LET BOOL b = x is b = x == 0 ? 0 : 1
+		value = IR_binary(ir, NOTEQ, value, IR_constant(ir, IR_INT, "0"));
+	} else {
+		value = IR_convert(ir, value, IR_variableType(ir, variable));
+	}
+	IR_writeVariable(ir, variable, ir->current, value);
+}
+
+// ends the current block, anything but an int is tested against 0 first
+IRValue *IR_branch(IR *ir, IRValue *condition, IRBlock *then, IRBlock *otherwise) {
+	if (condition->type == IR_STRING)
+		AST_abort("A string can not be used as a condition.");
+	if (condition->type != IR_INT)
+		condition = IR_binary(ir, NOTEQ, condition, IR_constant(ir, IR_INT, "0"));
+	IRValue *branch = IR_append(ir, IR_BRANCH, IR_VOID);
+	IR_addOperand(branch, condition);
+	branch->targets[0] = then;
+	branch->targets[1] = otherwise;
+	IR_addPred(then, ir->current);
+	IR_addPred(otherwise, ir->current);
+	return branch;
+}
+
+IRValue *IR_comparison(IR *ir, ASTNode *comparison) {
+	ASTItem **items = AST_flatten(comparison);
+	int at = 0;
+	IRValue *value = IR_climb(ir, items, &at, 1);
+	AST_killItems(items);
+	return value;
+}
+
+// precedence climbing over the flattened items, binding like C does
+IRValue *IR_climb(IR *ir, ASTItem **items, int *at, int precedence) {
+	ASTItem *item = items[(*at)++];
+	IRValue *value;
+	if (item->kind == AST_ITEM_OPEN) {
+		value = IR_climb(ir, items, at, 1);
+		(*at)++;
+	} else {
+		value = IR_value(ir, item->node);
+	}
+
+	while (items[*at] != NULL && items[*at]->kind == AST_ITEM_OPERATOR) {
+		TokenType operation = items[*at]->node->token->type;
+		int level = AST_precedence(operation);
+		if (level < precedence)
+			break;
+		(*at)++;
+		IRValue *right = IR_climb(ir, items, at, level + 1);
+		value = IR_binary(ir, operation, value, right);
+	}
+	return value;
+}
+
+IRValue *IR_value(IR *ir, ASTNode *value) {
+	int variable;
+
+	if (value->subType == STRING_VAR && value->token->type == PLUS) {
+		// PRINT and comparisons concatenate into a temporary of their own
+		IRValue *temp = IR_string(ir, IR_STRTMP, ir->ast->stringTemps++);
+		IR_concat(ir, value, temp);
+		return temp;
+	}
+
+	switch (value->token->type) {
+		case IDENT:
+			variable = IR_variable(ir, value->token->text);
+			if (AST_isArray(ir->variables[variable]->type))
+				return IR_load(ir, variable, IR_index(ir, variable, value));
+			if (IR_variableType(ir, variable) == IR_STRING)
+				return IR_string(ir, IR_STRVAR, variable);
+			return IR_readVariable(ir, variable, ir->current);
+
+		case TRUE:
+		case FALSE:
+			return IR_constant(ir, IR_INT, value->token->type == TRUE ? "1" : "0");
+
+		case NUMBERINT:
+			return IR_constant(ir, IR_INT, value->token->text);
+
+		case NUMBERFLOAT:
+			// a C literal like 4.5 is a double
+			return IR_constant(ir, IR_DOUBLE, value->token->text);
+
+		case STRING:
+			return IR_string(ir, IR_STRLIT, AST_internString(ir->ast, value->token->text));
+
+		default:
+			break;
+	}
+
+	if (!AST_isComparisonOperator(value->token->type))
+		AST_abort("IR does not know this expression.");
+	IRValue *left = IR_comparison(ir, (ASTNode *) List_first(value->children));
+	IRValue *right = IR_comparison(ir, (ASTNode *) List_last(value->children));
+	return IR_binary(ir, value->token->type, left, right);
+}
+
+IRValue *IR_binary(IR *ir, TokenType operation, IRValue *left, IRValue *right) {
+	IRValue *result;
+
+	if (left->type == IR_STRING) {
+		result = IR_append(ir, operation == NOTEQ ? IR_STRNE : IR_STREQ, IR_INT);
+		IR_addOperand(result, left);
+		IR_addOperand(result, right);
+		return result;
+	}
+
+	IRType common = left->type > right->type ? left->type : right->type;
+	left = IR_convert(ir, left, common);
+	right = IR_convert(ir, right, common);
+
+	switch (operation) {
+		case PLUS:
+			result = IR_append(ir, IR_ADD, common);
+			break;
+		case MINUS:
+			result = IR_append(ir, IR_SUB, common);
+			break;
+		case ASTERISK:
+			result = IR_append(ir, IR_MUL, common);
+			break;
+		case SLASH:
+			result = IR_append(ir, IR_DIV, common);
+			break;
+		case LT:
+			result = IR_append(ir, IR_LT, IR_INT);
+			break;
+		case LTEQ:
+			result = IR_append(ir, IR_LE, IR_INT);
+			break;
+		case GT:
+			result = IR_append(ir, IR_GT, IR_INT);
+			break;
+		case GTEQ:
+			result = IR_append(ir, IR_GE, IR_INT);
+			break;
+		case EQEQ:
+			result = IR_append(ir, IR_EQ, IR_INT);
+			break;
+		case NOTEQ:
+			result = IR_append(ir, IR_NE, IR_INT);
+			break;
+		default:
+			AST_abort("Invalid operator.");
+			return NULL;
+	}
+	IR_addOperand(result, left);
+	IR_addOperand(result, right);
+	return result;
+}
+
+// an int constant becomes a constant of the new type, C converts those exactly
+IRValue *IR_convert(IR *ir, IRValue *value, IRType type) {
+	if (value->type == type)
+		return value;
+	if (value->type == IR_STRING || type == IR_STRING)
+		AST_abort("Invalid types in expression.");
+	if (value->op == IR_CONST && value->type == IR_INT) {
+		char *text = malloc(strlen(value->text) + 4);
+		sprintf(text, type == IR_FLOAT ? "%s.0f" : "%s.0", value->text);
+		IRValue *constant = IR_constant(ir, type, text);
+		free(text);
+		return constant;
+	}
+	IRValue *result = IR_append(ir, IR_CONVERT, type);
+	IR_addOperand(result, value);
+	return result;
+}
+
+static void IR_stringParts(ASTNode *expression, List *parts) {
+	if (expression->token->type != PLUS) {
+		List_push(parts, expression);
+		return;
+	}
+	ListNode *child = expression->children->first;
+	if (((ASTNode *) child->value)->token->type == LEFTPAREN)
+		child = child->next;
+	IR_stringParts((ASTNode *) child->value, parts);
+	IR_stringParts((ASTNode *) child->next->value, parts);
+}
+
+// one IR_STRCAT over every operand of the + chain, so the result is sized once
+void IR_concat(IR *ir, ASTNode *expression, IRValue *destination) {
+	List *parts = List_create();
+	IR_stringParts(expression, parts);
+	List *values = List_create();
+	LIST_FOREACH(parts, first, next, cur) {
+		List_push(values, IR_value(ir, (ASTNode *) cur->value));
+	}
+	IRValue *concat = IR_append(ir, IR_STRCAT, IR_VOID);
+	IR_addOperand(concat, destination);
+	while (List_count(values) > 0)
+		IR_addOperand(concat, (IRValue *) List_shift(values));
+	List_destroy(values);
+	List_destroy(parts);
+}
+
+// works out ident's index and checks it against the size of the array
+IRValue *IR_index(IR *ir, int array, ASTNode *ident) {
+	IRValue *index = IR_comparison(ir, (ASTNode *) List_first(ident->children));
+	IRValue *bounds = IR_append(ir, IR_BOUNDS, IR_VOID);
+	bounds->variable = array;
+	IR_addOperand(bounds, index);
+	return index;
+}
+
+IRValue *IR_load(IR *ir, int array, IRValue *index) {
+	IRValue *load = IR_append(ir, IR_LOAD, IR_variableType(ir, array));
+	load->variable = array;
+	IR_addOperand(load, index);
+	return load;
+}
+
+// converts the value to the element type, like a C assignment
+void IR_storeElement(IR *ir, int array, IRValue *index, IRValue *value) {
+	value = IR_convert(ir, value, IR_variableType(ir, array));
+	IRValue *store = IR_append(ir, IR_STORE, IR_VOID);
+	store->variable = array;
+	IR_addOperand(store, index);
+	IR_addOperand(store, value);
+}
+
+int IR_variable(IR *ir, char *name) {
+	int i;
+	for (i = 0; i < ir->variableCount; i++) {
+		if (strcmp(ir->variables[i]->text, name) == 0)
+			return i;
+	}
+	AST_abort("IR could not find a variable.");
+	return -1;
+}
+
+// the block a label starts, made the first time the label is seen
+IRLabel *IR_label(IR *ir, char *name) {
+	LIST_FOREACH(ir->labels, first, next, cur) {
+		IRLabel *l = (IRLabel *) cur->value;
+		if (strcmp(l->name, name) == 0)
+			return l;
+	}
+	IRLabel *l = malloc(sizeof(IRLabel));
+	if (l == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	l->name = strdup(name);
+	l->block = IR_block(ir);
+	// a GOTO in a cold block says nothing about the label
+	l->block->cold = 0;
+	List_push(ir->labels, l);
+	return l;
+}
+
+IRBlock *IR_block(IR *ir) {
+	IRBlock *block = calloc(1, sizeof(IRBlock));
+	if (block == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	block->id = ir->nextBlock++;
+	block->values = List_create();
+	block->preds = List_create();
+	block->incomplete = List_create();
+	Mem_add(MEM_IR, block);
+	// whatever a cold block leads into is as cold
+	block->cold = ir->current != NULL && ir->current->cold;
+	return block;
+}
+
+// instructions go to block from now on, it is emitted after every block so far
+void IR_start(IR *ir, IRBlock *block) {
+	List_push(ir->blocks, block);
+	ir->current = block;
+}
+
+IRValue *IR_new(IR *ir, IROp op, IRType type) {
+	IRValue *value = calloc(1, sizeof(IRValue));
+	if (value == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	Mem_add(MEM_IR, value);
+	value->id = ir->nextValue++;
+	value->op = op;
+	value->type = type;
+	value->users = List_create();
+	value->line = ir->line;
+	List_push(ir->values, value);
+	return value;
+}
+
+IRValue *IR_constant(IR *ir, IRType type, char *text) {
+	IRValue *value = IR_new(ir, IR_CONST, type);
+	value->text = strdup(text);
+	return value;
+}
+
+IRValue *IR_append(IR *ir, IROp op, IRType type) {
+	IRValue *value = IR_new(ir, op, type);
+	value->block = ir->current;
+	List_push(ir->current->values, value);
+	return value;
+}
+
+void IR_addOperand(IRValue *value, IRValue *operand) {
+	if (value->operandCount == value->operandCapacity) {
+		value->operandCapacity = value->operandCapacity == 0 ? 2 : value->operandCapacity * 2;
+		Mem_remove(MEM_IR, value->operands);
+		value->operands = realloc(value->operands, sizeof(IRValue *) * value->operandCapacity);
+		if (value->operands == NULL) {
+			Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+		}
+		Mem_add(MEM_IR, value->operands);
+	}
+	value->operands[value->operandCount++] = operand;
+	List_push(operand->users, value);
+}
+
+IRValue *IR_resolve(IRValue *value) {
+	while (value->replacement != NULL)
+		value = value->replacement;
+	return value;
+}
+
+void IR_jump(IR *ir, IRBlock *target) {
+	IRValue *jump = IR_append(ir, IR_JUMP, IR_VOID);
+	jump->targets[0] = target;
+	IR_addPred(target, ir->current);
+}
+
+void IR_addPred(IRBlock *block, IRBlock *pred) {
+	List_push(block->preds, pred);
+}
+
+// the rest is Braun et al., "Simple and Efficient Construction of Static
+// Single Assignment Form": a variable is looked up through the predecessors
+// the first time a block reads it, and a block only gets phis once every
+// predecessor is known, which is when it is sealed
+
+// the slot of variable in block's defs, or the free one it would go in
+static IRDef *IR_def(IRBlock *block, int variable) {
+	unsigned int mask = (unsigned int) block->defCapacity - 1;
+	unsigned int i = ((unsigned int) variable * 2654435761u) & mask;
+	while (block->defs[i].value != NULL && block->defs[i].variable != variable) {
+		i = (i + 1) & mask;
+	}
+	return &block->defs[i];
+}
+
+// what variable is in block from now on, as a statement set it or as found
+static void IR_define(IRBlock *block, int variable, IRValue *value) {
+	if ((block->defCount + 1) * 2 > block->defCapacity) {
+		IRDef *old = block->defs;
+		int oldCapacity = block->defCapacity;
+		int i;
+		block->defCapacity = oldCapacity == 0 ? 8 : oldCapacity * 2;
+		block->defs = calloc(block->defCapacity, sizeof(IRDef));
+		if (block->defs == NULL) {
+			Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+		}
+		Mem_add(MEM_IR, block->defs);
+		for (i = 0; i < oldCapacity; i++) {
+			if (old[i].value != NULL)
+				*IR_def(block, old[i].variable) = old[i];
+		}
+		Mem_remove(MEM_IR, old);
+		free(old);
+	}
+	IRDef *def = IR_def(block, variable);
+	if (def->value == NULL)
+		block->defCount++;
+	def->variable = variable;
+	def->value = value;
+}
+
+void IR_writeVariable(IR *ir, int variable, IRBlock *block, IRValue *value) {
+	IRWrites *writes = &ir->writes[variable];
+	if (writes->count == writes->capacity) {
+		Mem_remove(MEM_IR, writes->times);
+		writes->capacity = writes->capacity == 0 ? 4 : writes->capacity * 2;
+		int *times = realloc(writes->times, sizeof(int) * writes->capacity);
+		if (times == NULL) {
+			Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+		}
+		writes->times = times;
+		Mem_add(MEM_IR, writes->times);
+	}
+	writes->times[writes->count++] = ir->writeCount++;
+	IR_define(block, variable, value);
+}
+
+// whether a statement set variable in the writes from since up to until
+static int IR_setBetween(IR *ir, int variable, int since, int until) {
+	IRWrites *writes = &ir->writes[variable];
+	int low = 0;
+	int high = writes->count;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (writes->times[middle] < since)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low < writes->count && writes->times[low] < until;
+}
+
+// join ends the construct that starts in the current block
+void IR_joinFrom(IR *ir, IRBlock *join) {
+	join->from = ir->current;
+	join->since = ir->writeCount;
+	join->labels = ir->labelsPlaced;
+}
+
+// called once every predecessor of join is known, before it is sealed
+void IR_joinEnd(IR *ir, IRBlock *join) {
+	join->until = ir->writeCount;
+	if (ir->labelsPlaced != join->labels)
+		join->from = NULL;
+}
+
+IRValue *IR_readVariable(IR *ir, int variable, IRBlock *block) {
+	if (block->defCount != 0) {
+		IRDef *def = IR_def(block, variable);
+		if (def->value != NULL)
+			return IR_resolve(def->value);
+	}
+	return IR_readVariableRecursive(ir, variable, block);
+}
+
+static IRValue *IR_phi(IR *ir, IRBlock *block, int variable) {
+	IRValue *phi = IR_new(ir, IR_PHI, IR_variableType(ir, variable));
+	phi->variable = variable;
+	phi->block = block;
+	List_unshift(block->values, phi);
+	return phi;
+}
+
+IRValue *IR_readVariableRecursive(IR *ir, int variable, IRBlock *block) {
+	IRValue *value;
+	if (!block->sealed) {
+		value = IR_phi(ir, block, variable);
+		List_push(block->incomplete, value);
+	} else if (List_count(block->preds) == 0 && ir->outer != NULL && block == List_first(ir->blocks)) {
+		value = IR_capture(ir, variable);
+	} else if (List_count(block->preds) == 0) {
+		// read before it was ever set, the C backend's locals start out as 0
+		value = IR_new(ir, IR_UNDEF, IR_variableType(ir, variable));
+	} else if (List_count(block->preds) == 1) {
+		value = IR_readVariable(ir, variable, (IRBlock *) List_first(block->preds));
+	} else if (block->from != NULL && !IR_setBetween(ir, variable, block->since, block->until)) {
+		// nothing in between set it, so there is no phi to make or look for
+		// in every block in between
+		value = IR_readVariable(ir, variable, block->from);
+	} else {
+		// breaks cycles through loops
+		value = IR_phi(ir, block, variable);
+		IR_define(block, variable, value);
+		value = IR_addPhiOperands(ir, variable, value);
+	}
+	IR_define(block, variable, value);
+	return value;
+}
+
+IRValue *IR_addPhiOperands(IR *ir, int variable, IRValue *phi) {
+	LIST_FOREACH(phi->block->preds, first, next, cur) {
+		IR_addOperand(phi, IR_readVariable(ir, variable, (IRBlock *) cur->value));
+	}
+	return IR_tryRemoveTrivialPhi(ir, phi);
+}
+
+static void IR_removeValue(IRBlock *block, IRValue *value) {
+	ListNode *node;
+	for (node = block->values->first; node != NULL; node = node->next) {
+		if (node->value == value) {
+			List_remove(block->values, node);
+			return;
+		}
+	}
+}
+
+// a phi whose operands are all one value, or itself, is that value
+IRValue *IR_tryRemoveTrivialPhi(IR *ir, IRValue *phi) {
+	IRValue *same = NULL;
+	int i;
+	for (i = 0; i < phi->operandCount; i++) {
+		IRValue *operand = IR_resolve(phi->operands[i]);
+		if (operand == same || operand == phi)
+			continue;
+		if (same != NULL)
+			return phi;
+		same = operand;
+	}
+	if (same == NULL) {
+		// only reachable from itself, or not at all
+		same = IR_new(ir, IR_UNDEF, phi->type);
+	}
+	phi->replacement = same;
+	IR_removeValue(phi->block, phi);
+
+	ListNode *node;
+	for (node = phi->users->first; node != NULL; node = node->next) {
+		IRValue *user = (IRValue *) node->value;
+		for (i = 0; i < user->operandCount; i++) {
+			if (user->operands[i] == phi) {
+				user->operands[i] = same;
+				List_push(same->users, user);
+			}
+		}
+	}
+	// phis that used this one may now be trivial too, unless they are still
+	// waiting on some of their operands
+	for (node = phi->users->first; node != NULL; node = node->next) {
+		IRValue *user = (IRValue *) node->value;
+		if (user != phi && user->op == IR_PHI && user->replacement == NULL
+				&& user->operandCount == List_count(user->block->preds))
+			IR_tryRemoveTrivialPhi(ir, user);
+	}
+	return IR_resolve(same);
+}
+
+void IR_sealBlock(IR *ir, IRBlock *block) {
+	if (block->sealed)
+		return;
+	IRValue *phi;
+	while ((phi = (IRValue *) List_shift(block->incomplete)) != NULL)
+		IR_addPhiOperands(ir, phi->variable, phi);
+	block->sealed = 1;
+}
+
+int IR_isTerminator(IROp op) {
+	return op == IR_JUMP || op == IR_BRANCH || op == IR_RETURN;
+}
+
+int IR_hasSideEffects(IROp op) {
+	return op >= IR_PRINT_INT;
+}
+
+static void IR_printOperand(IR *ir, IRValue *value, FILE *out) {
+	value = IR_resolve(value);
+	switch (value->op) {
+		case IR_CONST:
+			fprintf(out, "%s", value->text);
+			break;
+		case IR_UNDEF:
+			fprintf(out, "undef");
+			break;
+		case IR_STRVAR:
+			fprintf(out, "%s", ir->variables[value->variable]->text);
+			break;
+		case IR_STRLIT:
+			fprintf(out, "lit%d", value->variable);
+			break;
+		case IR_STRTMP:
+			fprintf(out, "tmp%d", value->variable);
+			break;
+		default:
+			fprintf(out, "v%d", value->id);
+			break;
+	}
+}
+
+// a readable dump, one instruction per line under its block
+void IR_print(IR *ir, FILE *out) {
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (!block->reachable)
+			continue;
+		fprintf(out, "b%d:%s", block->id, block->cold ? " cold" : "");
+		ListNode *pred;
+		for (pred = block->preds->first; pred != NULL; pred = pred->next)
+			fprintf(out, "%s b%d", pred == block->preds->first ? " ; from" : ",", ((IRBlock *) pred->value)->id);
+		fprintf(out, "\n");
+		ListNode *node;
+		for (node = block->values->first; node != NULL; node = node->next) {
+			IRValue *value = (IRValue *) node->value;
+			fprintf(out, "\t");
+			if (value->type != IR_VOID)
+				fprintf(out, "v%d = ", value->id);
+			fprintf(out, "%s %s", IR_opNames[value->op], IR_typeNames[value->type]);
+			int i;
+			if (value->op == IR_LOAD || value->op == IR_STORE || value->op == IR_BOUNDS)
+				fprintf(out, " %s[%d]", ir->variables[value->variable]->text, ir->variables[value->variable]->size);
+			for (i = 0; i < value->operandCount; i++) {
+				fprintf(out, i == 0 && value->op != IR_LOAD && value->op != IR_STORE && value->op != IR_BOUNDS ? " " : ", ");
+				IR_printOperand(ir, value->operands[i], out);
+			}
+			if (value->op == IR_WRITE)
+				fprintf(out, " %zu", strlen(value->text));
+			if (value->op == IR_ENV || value->op == IR_ENV_SET || value->op == IR_ENV_ADD)
+				fprintf(out, " %s", value->text);
+			if (value->op == IR_PARALLEL)
+				fprintf(out, " tt_par%d", value->variable);
+			if (value->op >= IR_PROF_HIT && value->op <= IR_PROF_TRIP)
+				fprintf(out, " slot%d", value->variable);
+			for (i = 0; i < 2; i++) {
+				if (value->targets[i] != NULL)
+					fprintf(out, "%sb%d", value->operandCount > 0 || i > 0 ? ", " : " ", value->targets[i]->id);
+			}
+			if (value->expect != 0)
+				fprintf(out, " %s", value->expect > 0 ? "likely" : "unlikely");
+			fprintf(out, " ; line %d\n", value->line);
+		}
+	}
+	ListNode *body;
+	for (body = ir->parallels->first; body != NULL; body = body->next) {
+		fprintf(out, "tt_par%d:\n", ((IR *) body->value)->number);
+		IR_print((IR *) body->value, out);
+	}
+}
@@ -0,0 +1,329 @@
+#ifndef IR_H
+#define IR_H
+
+#include <limits.h>
+#include "ast.h"
+#include "list.h"
+#include "profile.h"
+
+// Typed three address code in SSA form, lowered from the checked AST.
+// INT, BOOL and FLOAT variables become SSA values, built on the fly with
+// Braun et al.'s algorithm, so a variable never exists past lowering. STRING
+// variables stay in memory: string values only name a variable, literal or
+// temporary, and every instruction that reads or writes one keeps its place.
+// Control flow is explicit, every block ends in exactly one terminator.
+
+typedef enum IRType {
+	IR_VOID = 0,
+	IR_INT = 1,
+	IR_FLOAT = 2,
+	IR_DOUBLE = 3,
+	IR_STRING = 4
+} IRType;
+
+typedef enum IROp {
+	// operands, these are never placed in a block
+	IR_CONST,
+	IR_UNDEF,
+	IR_STRVAR,
+	IR_STRLIT,
+	IR_STRTMP,
+	// pure
+	IR_PHI,
+	IR_ADD,
+	IR_SUB,
+	IR_MUL,
+	IR_DIV,
+	IR_LT,
+	IR_LE,
+	IR_GT,
+	IR_GE,
+	IR_EQ,
+	IR_NE,
+	IR_CONVERT,
+	// read string or array memory
+	IR_STREQ,
+	IR_STRNE,
+	IR_LOAD,
+	// PARALLEL FOR: a field of the loop's tt_env, or in its body a bound of
+	// the range being run
+	IR_ENV,
+	// side effects
+	IR_PRINT_INT,
+	IR_PRINT_FLOAT,
+	IR_PRINT_BOOL,
+	IR_PRINT_STR,
+	IR_WRITE,
+	IR_INPUT,
+	IR_STRINPUT,
+	IR_STRSET,
+	IR_STRCAT,
+	IR_STORE,
+	// PARALLEL FOR: sets a field of tt_env, adds to one at once with other
+	// threads, and runs the body over a range of iterations
+	IR_ENV_SET,
+	IR_ENV_ADD,
+	IR_PARALLEL,
+	// stops the program unless the index is inside the array
+	IR_BOUNDS,
+	// --profile counters of the statement in variable: a hit that starts
+	// its timer, the end of the statement and an entry into its body
+	IR_PROF_HIT,
+	IR_PROF_TIME,
+	IR_PROF_TRIP,
+	// terminators
+	IR_JUMP,
+	IR_BRANCH,
+	IR_RETURN
+} IROp;
+
+struct IRBlock;
+struct IRValue;
+
+// a variable's current SSA value in a block, the value is NULL in a free slot
+typedef struct IRDef {
+	int variable;
+	struct IRValue *value;
+} IRDef;
+
+typedef struct IRValue {
+	int id;
+	IROp op;
+	IRType type;
+	struct IRBlock *block;
+	struct IRValue **operands;
+	int operandCount;
+	int operandCapacity;
+	// every instruction that has this value as an operand, maybe twice
+	List *users;
+	// IR_CONST, IR_STRLIT and IR_WRITE, and the C an IR_ENV* reads or sets
+	char *text;
+	// the variable of an IR_PHI, IR_STRVAR or IR_ENV, the array of an
+	// IR_LOAD, IR_STORE or IR_BOUNDS, the temporary of an IR_STRTMP, the
+	// statement of an IR_PROF_*, the body an IR_PARALLEL runs
+	int variable;
+	// IR_JUMP and IR_BRANCH, taken first
+	struct IRBlock *targets[2];
+	// a phi that turned out trivial forwards to what it was equal to
+	struct IRValue *replacement;
+	// IR_BRANCH: 1 when a profile says it mostly goes to targets[0], -1
+	// when it mostly does not
+	int expect;
+	int live;
+	int line;
+} IRValue;
+
+typedef struct IRBlock {
+	int id;
+	// phis first, then instructions, then one terminator
+	List *values;
+	List *preds;
+	// Braun et al.: the current SSA value of the variables this block set or
+	// looked up, an open addressing table at most half full so a block costs
+	// what it touches and not every variable, and the phis made before every
+	// predecessor was known
+	IRDef *defs;
+	int defCount;
+	int defCapacity;
+	List *incomplete;
+	// the join an IF, WHILE or FOR ends in: the block it started from, and
+	// the writes and labels made in between. A variable none of those writes
+	// set has the value it had there, unless a label let a GOTO in
+	struct IRBlock *from;
+	int since;
+	int until;
+	int labels;
+	int sealed;
+	int reachable;
+	// a profile never saw it run, emitted last and marked cold
+	int cold;
+	// reverse postorder and immediate dominator, set by IR_dominators
+	int order;
+	struct IRBlock *idom;
+} IRBlock;
+
+// when statements set a variable, counted in writes of any variable
+typedef struct IRWrites {
+	int *times;
+	int count;
+	int capacity;
+} IRWrites;
+
+typedef struct IRLabel {
+	char *name;
+	IRBlock *block;
+} IRLabel;
+
+typedef struct IR {
+	AST *ast;
+	// in the order they are placed, the entry first
+	List *blocks;
+	// every value made, for IR_kill
+	List *values;
+	IRBlock *current;
+	Symbol **variables;
+	int variableCount;
+	// every write a statement made, for the joins to skip what they end
+	IRWrites *writes;
+	int writeCount;
+	int labelsPlaced;
+	List *labels;
+	int nextValue;
+	int nextBlock;
+	int line;
+	// --profile, the statements that have counters in the order of their slots
+	int profile;
+	List *profiled;
+	// --use-profile, counts from an earlier --profile run
+	Profile *guide;
+	// the bodies of PARALLEL FOR loops, each lowered into an IR of its own
+	List *parallels;
+	// in such a body: the IR it is part of, its number, the IR_ENV values it
+	// reads variables of main through and the IR_ENV_SETs main fills its
+	// tt_env with
+	struct IR *outer;
+	int number;
+	List *captures;
+	List *fields;
+} IR;
+
+#define IR_ARM_PIECES 4
+
+// an arm of an IF chain that tests one INT variable against numbers
+typedef struct IRArm {
+	ASTNode *node;
+	ListNode *body;
+	ListNode *end;
+	// the values the arm is taken for once earlier arms had their pick, as
+	// disjoint ranges
+	long long low[IR_ARM_PIECES];
+	long long high[IR_ARM_PIECES];
+	int pieces;
+	unsigned long long trips;
+} IRArm;
+
+IR *IR_create(AST *ast);
+
+void IR_kill(IR *ir);
+
+void IR_lower(IR *ir, AST *ast);
+
+void IR_optimize(IR *ir);
+
+void IR_statements(IR *ir, ListNode *current, ListNode *end);
+
+void IR_statement(IR *ir, ASTNode *statement);
+
+void IR_constantPrints(IR *ir, ListNode **current);
+
+void IR_if(IR *ir, ASTNode *statement, IRBlock *done, int slot);
+
+int IR_ifChain(IR *ir, ASTNode *statement, IRBlock *done);
+
+int IR_armRange(ASTNode *condition, char **variable, long long *low, long long *high);
+
+int IR_armPieces(IRArm *arm, long long low, long long high, long long *coveredLow, long long *coveredHigh, int covered);
+
+int IR_cover(long long *lows, long long *highs, int count, long long low, long long high);
+
+void IR_armTest(IR *ir, IRValue *value, IRArm *arm, IRBlock *then, IRBlock *otherwise, int expect);
+
+int IR_expectation(unsigned long long taken, unsigned long long total);
+
+void IR_for(IR *ir, ASTNode *statement, int slot);
+
+void IR_parallel(IR *ir, ASTNode *statement);
+
+void IR_parallelBody(IR *body, ASTNode *statement, int *kept, int keptCount, int *reduced, int reducedCount);
+
+IRValue *IR_env(IR *ir, IRType type, char *field);
+
+IRValue *IR_envSet(IR *ir, IROp op, char *field, IRValue *value);
+
+int IR_profile(IR *ir, ASTNode *statement);
+
+void IR_profilePoint(IR *ir, IROp op, int slot);
+
+void IR_store(IR *ir, int variable, IRValue *value);
+
+IRValue *IR_branch(IR *ir, IRValue *condition, IRBlock *then, IRBlock *otherwise);
+
+IRValue *IR_comparison(IR *ir, ASTNode *comparison);
+
+IRValue *IR_climb(IR *ir, ASTItem **items, int *at, int precedence);
+
+IRValue *IR_value(IR *ir, ASTNode *value);
+
+IRValue *IR_binary(IR *ir, TokenType operation, IRValue *left, IRValue *right);
+
+IRValue *IR_convert(IR *ir, IRValue *value, IRType type);
+
+void IR_concat(IR *ir, ASTNode *expression, IRValue *destination);
+
+IRValue *IR_index(IR *ir, int array, ASTNode *ident);
+
+IRValue *IR_load(IR *ir, int array, IRValue *index);
+
+void IR_storeElement(IR *ir, int array, IRValue *index, IRValue *value);
+
+int IR_variable(IR *ir, char *name);
+
+IRLabel *IR_label(IR *ir, char *name);
+
+IRBlock *IR_block(IR *ir);
+
+void IR_start(IR *ir, IRBlock *block);
+
+IRValue *IR_new(IR *ir, IROp op, IRType type);
+
+IRValue *IR_constant(IR *ir, IRType type, char *text);
+
+IRValue *IR_append(IR *ir, IROp op, IRType type);
+
+void IR_addOperand(IRValue *value, IRValue *operand);
+
+IRValue *IR_resolve(IRValue *value);
+
+void IR_jump(IR *ir, IRBlock *target);
+
+void IR_addPred(IRBlock *block, IRBlock *pred);
+
+void IR_writeVariable(IR *ir, int variable, IRBlock *block, IRValue *value);
+
+IRValue *IR_readVariable(IR *ir, int variable, IRBlock *block);
+
+IRValue *IR_readVariableRecursive(IR *ir, int variable, IRBlock *block);
+
+IRValue *IR_addPhiOperands(IR *ir, int variable, IRValue *phi);
+
+IRValue *IR_tryRemoveTrivialPhi(IR *ir, IRValue *phi);
+
+void IR_sealBlock(IR *ir, IRBlock *block);
+
+void IR_joinFrom(IR *ir, IRBlock *join);
+
+void IR_joinEnd(IR *ir, IRBlock *join);
+
+int IR_isTerminator(IROp op);
+
+int IR_hasSideEffects(IROp op);
+
+void IR_dominators(IR *ir);
+
+int IR_dominates(IRBlock *a, IRBlock *b);
+
+void IR_removeBoundsChecks(IR *ir);
+
+int IR_evaluate(IR *ir, char **output, size_t *length, int *status);
+
+void IR_print(IR *ir, FILE *out);
+
+void IR_emit(IR *ir);
+
+void IR_emitOutput(char *output, size_t length, int status);
+
+void IR_emitValue(IR *ir, IRValue *value);
+
+void IR_emitOperand(IR *ir, IRValue *value);
+
+#endif
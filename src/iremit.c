@@ -0,0 +1,533 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "emit.h"
+#include "runtime.h"
+
+// Prints the IR as C. Every SSA value is a local of main, or of the function
+// the body of a PARALLEL FOR becomes, and every block a label, so the C
+// compiler sees plain gotos. A phi gets a second local that each predecessor
+// copies its operand into just before leaving, which keeps phis that read
+// each other from seeing half updated values.
+
+static const char *IR_cTypes[] = {
+	[IR_INT] = "int", [IR_FLOAT] = "float", [IR_DOUBLE] = "double"
+};
+
+static const char *IR_cOperators[] = {
+	[IR_ADD] = " + ", [IR_SUB] = " - ", [IR_MUL] = " * ", [IR_DIV] = " / ",
+	[IR_LT] = " < ", [IR_LE] = " <= ", [IR_GT] = " > ", [IR_GE] = " >= ",
+	[IR_EQ] = " == ", [IR_NE] = " != "
+};
+
+static void IR_emitDeclarations(IR *ir) {
+	char temp[64];
+	int i;
+	// a PARALLEL FOR body has no strings
+	for (i = 0; i < ir->variableCount && ir->outer == NULL; i++) {
+		if (ir->variables[i]->type != STRING_VAR)
+			continue;
+		Emitter_emit("tt_str ");
+		Emitter_emit(ir->variables[i]->text);
+		Emitter_emitLine(" = TT_STR_INIT;");
+	}
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (!block->reachable)
+			continue;
+		ListNode *node;
+		for (node = block->values->first; node != NULL; node = node->next) {
+			IRValue *value = (IRValue *) node->value;
+			if (value->type == IR_VOID)
+				continue;
+			if (value->op == IR_PHI)
+				sprintf(temp, "%s v%d, p%d;", IR_cTypes[value->type], value->id, value->id);
+			else
+				sprintf(temp, "%s v%d;", IR_cTypes[value->type], value->id);
+			Emitter_emitLine(temp);
+		}
+	}
+}
+
+// arrays are zeroed statics, aligned so that vector loads and stores of a
+// whole loop never straddle a cache line
+static void IR_emitArrays(IR *ir) {
+	char temp[64];
+	int i;
+	for (i = 0; i < ir->variableCount; i++) {
+		Symbol *s = ir->variables[i];
+		if (!AST_isArray(s->type))
+			continue;
+		Emitter_header(s->type == INT_ARRAY ? "static _Alignas(64) int tt_arr_" : "static _Alignas(64) float tt_arr_");
+		Emitter_header(s->text);
+		sprintf(temp, "[%d];", s->size);
+		Emitter_headerLine(temp);
+	}
+}
+
+// the line and keyword of every profiled statement, for the report
+static void IR_emitProfile(IR *ir) {
+	char temp[64];
+	sprintf(temp, "#define TT_PROF_SLOTS %d", List_count(ir->profiled) > 0 ? List_count(ir->profiled) : 1);
+	Emitter_headerLine(temp);
+	Emitter_headerLine("static const int tt_prof_lines[TT_PROF_SLOTS] = {");
+	LIST_FOREACH(ir->profiled, first, next, cur) {
+		sprintf(temp, "\t%d,", ((ASTNode *) cur->value)->lineNumber);
+		Emitter_headerLine(temp);
+	}
+	Emitter_headerLine("};");
+	Emitter_headerLine("static const char *const tt_prof_kinds[TT_PROF_SLOTS] = {");
+	ListNode *node;
+	for (node = ir->profiled->first; node != NULL; node = node->next) {
+		Emitter_header("\t\"");
+		Emitter_header(((ASTNode *) node->value)->token->text);
+		Emitter_headerLine("\",");
+	}
+	Emitter_headerLine("};");
+	Runtime_emitProfile();
+}
+
+// pN = operand for every phi of the blocks this one goes to
+static void IR_emitPhiCopies(IR *ir, IRBlock *block, IRValue *terminator) {
+	char temp[32];
+	int i;
+	for (i = 0; i < 2; i++) {
+		IRBlock *target = terminator->targets[i];
+		if (target == NULL || (i == 1 && target == terminator->targets[0]))
+			continue;
+		int index = 0;
+		ListNode *pred;
+		for (pred = target->preds->first; pred->value != block; pred = pred->next)
+			index++;
+		ListNode *node;
+		for (node = target->values->first; node != NULL; node = node->next) {
+			IRValue *phi = (IRValue *) node->value;
+			if (phi->op != IR_PHI)
+				break;
+			sprintf(temp, "p%d = ", phi->id);
+			Emitter_emit(temp);
+			IR_emitOperand(ir, phi->operands[index]);
+			Emitter_emitLine(";");
+		}
+	}
+}
+
+static void IR_emitBlock(IR *ir, IRBlock *block) {
+	char temp[80];
+	if (List_count(block->preds) > 0) {
+		// gcc moves what follows a cold label out of the hot code
+		sprintf(temp, block->cold ? "b%d: __attribute__((cold));" : "b%d:", block->id);
+		Emitter_emitLine(temp);
+	}
+	ListNode *node;
+	for (node = block->values->first; node != NULL; node = node->next) {
+		IRValue *value = (IRValue *) node->value;
+		IRValue *following = node->next != NULL ? (IRValue *) node->next->value : NULL;
+		if (value->op == IR_PROF_TIME && following != NULL && following->op == IR_PROF_HIT) {
+			// one statement ends where the next starts, one clock read does both
+			Emitter_emitLine("tt_prof_now = tt_prof_clock();");
+			sprintf(temp, "tt_prof_cycles[%d] += tt_prof_now - tt_prof_start[%d];", value->variable, value->variable);
+			Emitter_emitLine(temp);
+			sprintf(temp, "tt_prof_hits[%d]++;", following->variable);
+			Emitter_emitLine(temp);
+			sprintf(temp, "tt_prof_start[%d] = tt_prof_now;", following->variable);
+			Emitter_emitLine(temp);
+			node = node->next;
+			continue;
+		}
+		// a phi takes the line of whichever read made it, not of its block
+		if (value->op != IR_PHI)
+			Emitter_sourceLine(value->line);
+		if (IR_isTerminator(value->op))
+			IR_emitPhiCopies(ir, block, value);
+		IR_emitValue(ir, value);
+	}
+}
+
+// blocks a profile never saw run go last, every block ends in a goto
+static void IR_emitBlocks(IR *ir) {
+	int cold;
+	for (cold = 0; cold < 2; cold++) {
+		ListNode *node;
+		for (node = ir->blocks->first; node != NULL; node = node->next) {
+			IRBlock *block = (IRBlock *) node->value;
+			if (block->reachable && block->cold == cold)
+				IR_emitBlock(ir, block);
+		}
+	}
+}
+
+// the tt_env of a PARALLEL FOR, with a field for every IR_ENV_SET main fills
+// it with, and the function the workers run its ranges in
+static void IR_emitParallel(IR *body) {
+	char temp[96];
+	Emitter_headerLine("static struct {");
+	LIST_FOREACH(body->fields, first, next, cur) {
+		IRValue *set = (IRValue *) cur->value;
+		sprintf(temp, "\t%s %s;", IR_cTypes[IR_resolve(set->operands[0])->type], strchr(set->text, '.') + 1);
+		Emitter_headerLine(temp);
+	}
+	sprintf(temp, "} tt_env%d;", body->number);
+	Emitter_headerLine(temp);
+
+	sprintf(temp, "static void tt_par%d (int tt_lo, int tt_hi) {", body->number);
+	Emitter_emitLine(temp);
+	IR_emitDeclarations(body);
+	IR_emitBlocks(body);
+	Emitter_emitLine("}");
+}
+
+void IR_emit(IR *ir) {
+	AST *ast = ir->ast;
+	char temp[64];
+	int i;
+
+	Runtime_emitIncludes();
+	Runtime_emitOutput();
+	if (ast->seenInput)
+		Runtime_emitInput();
+	if (ast->seenString || ast->seenStrInput)
+		Runtime_emitStrings();
+	if (ast->seenStrInput)
+		Runtime_emitStringInput();
+	if (ast->seenArray)
+		Runtime_emitArrays();
+	IR_emitArrays(ir);
+	if (ir->profile)
+		IR_emitProfile(ir);
+	for (i = 0; i < ast->stringTemps; i++) {
+		sprintf(temp, "static tt_str tt_tmp%d = TT_STR_INIT;", i);
+		Emitter_headerLine(temp);
+	}
+	if (List_count(ir->parallels) > 0)
+		Runtime_emitParallel();
+	LIST_FOREACH(ir->parallels, first, next, cur) {
+		IR_emitParallel((IR *) cur->value);
+	}
+
+	Emitter_emitLine("int main (void) {");
+	IR_emitDeclarations(ir);
+	if (ir->profile) {
+		Emitter_emitLine("unsigned long long tt_prof_now;");
+		Emitter_emitLine("tt_prof_begin = tt_prof_clock();");
+		Emitter_emitLine("atexit(tt_prof_write);");
+	}
+	IR_emitBlocks(ir);
+
+	Emitter_emitLine("tt_done:");
+	AST_emitSymbolFrees(ast->symbols);
+	for (i = 0; i < ast->stringTemps; i++) {
+		sprintf(temp, "free(tt_tmp%d.buf);", i);
+		Emitter_emitLine(temp);
+	}
+	Emitter_emitLine("tt_flush();");
+	Emitter_emitLine("return 0;");
+	Emitter_emitLine("}");
+
+	AST_emitStringLiterals(ast->stringLiterals);
+}
+
+// a program worked out at compile time, its whole output as one string
+void IR_emitOutput(char *output, size_t length, int status) {
+	char line[96];
+	size_t at = 0;
+	size_t i;
+
+	Emitter_headerLine("#include <unistd.h>");
+	Emitter_headerLine("");
+	Emitter_headerLine("static const char tt_output[] =");
+	if (length == 0)
+		Emitter_headerLine("\"\"");
+	for (i = 0; i < length; i++) {
+		unsigned char c = (unsigned char) output[i];
+		if (at == 0)
+			line[at++] = '"';
+		if (c == '\n') {
+			line[at++] = '\\';
+			line[at++] = 'n';
+		} else if (c == '"' || c == '\\') {
+			line[at++] = '\\';
+			line[at++] = (char) c;
+		} else if (c < ' ' || c > '~') {
+			at += (size_t) sprintf(line + at, "\\%03o", c);
+		} else {
+			line[at++] = (char) c;
+		}
+		// a line per line of output, long ones split
+		if (c == '\n' || at > 72 || i == length - 1) {
+			line[at++] = '"';
+			line[at] = '\0';
+			Emitter_headerLine(line);
+			at = 0;
+		}
+	}
+	Emitter_headerLine(";");
+	Emitter_headerLine("");
+
+	Emitter_emitLine("int main (void) {");
+	Emitter_emitLine("const char *p = tt_output;");
+	Emitter_emitLine("size_t n = sizeof(tt_output) - 1;");
+	Emitter_emitLine("while (n > 0) {");
+	Emitter_emitLine("ssize_t written = write(1, p, n);");
+	Emitter_emitLine("if (written <= 0)");
+	Emitter_emitLine("return 1;");
+	Emitter_emitLine("p += written;");
+	Emitter_emitLine("n -= (size_t) written;");
+	Emitter_emitLine("}");
+	sprintf(line, "return %d;", status);
+	Emitter_emitLine(line);
+	Emitter_emitLine("}");
+}
+
+// the text of a PRINT "literal" run, with its newlines escaped
+static void IR_emitWrite(IRValue *value) {
+	size_t length = strlen(value->text);
+	char *text = malloc(length * 2 + 1);
+	size_t at = 0;
+	size_t i;
+	for (i = 0; i < length; i++) {
+		if (value->text[i] == '\n') {
+			text[at++] = '\\';
+			text[at++] = 'n';
+		} else {
+			text[at++] = value->text[i];
+		}
+	}
+	text[at] = '\0';
+
+	char count[32];
+	sprintf(count, "\", %zu);", length);
+	Emitter_emit("tt_write(\"");
+	Emitter_emit(text);
+	Emitter_emitLine(count);
+	free(text);
+}
+
+void IR_emitValue(IR *ir, IRValue *value) {
+	char temp[96];
+	int i;
+
+	if (value->type != IR_VOID && value->op != IR_INPUT) {
+		sprintf(temp, "v%d = ", value->id);
+		Emitter_emit(temp);
+	}
+
+	switch (value->op) {
+		case IR_PHI:
+			sprintf(temp, "p%d;", value->id);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_ADD:
+		case IR_SUB:
+		case IR_MUL:
+		case IR_DIV:
+		case IR_LT:
+		case IR_LE:
+		case IR_GT:
+		case IR_GE:
+		case IR_EQ:
+		case IR_NE:
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit((char *) IR_cOperators[value->op]);
+			IR_emitOperand(ir, value->operands[1]);
+			Emitter_emitLine(";");
+			break;
+
+		case IR_CONVERT:
+			sprintf(temp, "(%s) ", IR_cTypes[value->type]);
+			Emitter_emit(temp);
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(";");
+			break;
+
+		case IR_STREQ:
+		case IR_STRNE:
+			Emitter_emit(value->op == IR_STRNE ? "!tt_str_eq(" : "tt_str_eq(");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit(", ");
+			IR_emitOperand(ir, value->operands[1]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_PRINT_INT:
+		case IR_PRINT_FLOAT:
+		case IR_PRINT_BOOL:
+		case IR_PRINT_STR:
+			if (value->op == IR_PRINT_INT)
+				Emitter_emit("tt_print_int(");
+			else if (value->op == IR_PRINT_FLOAT)
+				Emitter_emit("tt_print_float(");
+			else if (value->op == IR_PRINT_BOOL)
+				Emitter_emit("tt_print_bool(");
+			else
+				Emitter_emit("tt_print_str(");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_WRITE:
+			IR_emitWrite(value);
+			break;
+
+		case IR_INPUT:
+			// starts from the old value, which is kept at the end of input
+			sprintf(temp, "v%d = ", value->id);
+			Emitter_emit(temp);
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(";");
+			sprintf(temp, "%s(&v%d);", value->type == IR_INT ? "tt_input_int" : "tt_input_float", value->id);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_STRINPUT:
+			Emitter_emit("tt_str_input(&");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_STRSET:
+			// the runtime reuses the variable's buffer or points it at the literal
+			Emitter_emit("tt_str_set(&");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit(", ");
+			IR_emitOperand(ir, value->operands[1]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_STRCAT:
+			Emitter_emit("tt_str_cat(&");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit(", (tt_str[]){ ");
+			for (i = 1; i < value->operandCount; i++) {
+				if (i > 1)
+					Emitter_emit(", ");
+				IR_emitOperand(ir, value->operands[i]);
+			}
+			sprintf(temp, " }, %d);", value->operandCount - 1);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_LOAD:
+			Emitter_emit("tt_arr_");
+			Emitter_emit(ir->variables[value->variable]->text);
+			Emitter_emit("[");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine("];");
+			break;
+
+		case IR_STORE:
+			Emitter_emit("tt_arr_");
+			Emitter_emit(ir->variables[value->variable]->text);
+			Emitter_emit("[");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit("] = ");
+			IR_emitOperand(ir, value->operands[1]);
+			Emitter_emitLine(";");
+			break;
+
+		case IR_ENV:
+			Emitter_emit(value->text);
+			Emitter_emitLine(";");
+			break;
+
+		case IR_ENV_SET:
+			Emitter_emit(value->text);
+			Emitter_emit(" = ");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(";");
+			break;
+
+		case IR_ENV_ADD:
+			Emitter_emit(IR_resolve(value->operands[0])->type == IR_INT ? "tt_par_add_int(&" : "tt_par_add_float(&");
+			Emitter_emit(value->text);
+			Emitter_emit(", ");
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_PARALLEL:
+			sprintf(temp, "tt_par_run(tt_par%d, ", value->variable);
+			Emitter_emit(temp);
+			IR_emitOperand(ir, value->operands[0]);
+			Emitter_emit(", ");
+			IR_emitOperand(ir, value->operands[1]);
+			Emitter_emitLine(");");
+			break;
+
+		case IR_BOUNDS:
+			Emitter_emit("if ((unsigned) ");
+			IR_emitOperand(ir, value->operands[0]);
+			sprintf(temp, " >= %du) tt_bounds(%d);", ir->variables[value->variable]->size, value->line);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_PROF_HIT:
+			sprintf(temp, "tt_prof_hits[%d]++;", value->variable);
+			Emitter_emitLine(temp);
+			sprintf(temp, "tt_prof_start[%d] = tt_prof_clock();", value->variable);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_PROF_TIME:
+			sprintf(temp, "tt_prof_cycles[%d] += tt_prof_clock() - tt_prof_start[%d];", value->variable, value->variable);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_PROF_TRIP:
+			sprintf(temp, "tt_prof_trips[%d]++;", value->variable);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_JUMP:
+			sprintf(temp, "goto b%d;", value->targets[0]->id);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_BRANCH:
+			Emitter_emit(value->expect != 0 ? "if (__builtin_expect(" : "if (");
+			IR_emitOperand(ir, value->operands[0]);
+			if (value->expect != 0)
+				Emitter_emit(value->expect > 0 ? " != 0, 1)" : " != 0, 0)");
+			sprintf(temp, ") goto b%d;", value->targets[0]->id);
+			Emitter_emitLine(temp);
+			sprintf(temp, "goto b%d;", value->targets[1]->id);
+			Emitter_emitLine(temp);
+			break;
+
+		case IR_RETURN:
+			Emitter_emitLine(ir->outer != NULL ? "return;" : "goto tt_done;");
+			break;
+
+		default:
+			AST_abort("IR has a value that can not be emitted.");
+			break;
+	}
+}
+
+void IR_emitOperand(IR *ir, IRValue *value) {
+	char temp[32];
+	value = IR_resolve(value);
+	switch (value->op) {
+		case IR_CONST:
+			Emitter_emit(value->text);
+			return;
+		case IR_UNDEF:
+			Emitter_emit("0");
+			return;
+		case IR_STRVAR:
+			Emitter_emit(ir->variables[value->variable]->text);
+			return;
+		case IR_STRLIT:
+			sprintf(temp, "tt_lits[%d]", value->variable);
+			break;
+		case IR_STRTMP:
+			sprintf(temp, "tt_tmp%d", value->variable);
+			break;
+		default:
+			sprintf(temp, "v%d", value->id);
+			break;
+	}
+	Emitter_emit(temp);
+}
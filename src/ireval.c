@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ir.h"
+#include "diagnostic.h"
+
+// Runs the optimized IR at compile time. A program that never reaches INPUT
+// prints the same thing every time it runs, so when it finishes within the
+// budget below its output can be written out instead of its code. Anything
+// the generated program would do differently, like trap on a division by 0,
+// makes the evaluation give up and the program is compiled as usual.
+
+// instructions run, bytes printed and bytes of strings and arrays held
+#define IR_EVAL_STEPS 5000000
+#define IR_EVAL_OUTPUT (1 << 20)
+#define IR_EVAL_MEMORY (1 << 26)
+
+typedef union IRSlot {
+	int i;
+	float f;
+	double d;
+} IRSlot;
+
+typedef struct IRString {
+	char *text;
+	size_t length;
+	// 0 for literals, which are never written to
+	size_t capacity;
+} IRString;
+
+typedef struct IREval {
+	IR *ir;
+	IRSlot *slots;
+	IRSlot *scratch;
+	IRString *variables;
+	IRString *temps;
+	IRString *literals;
+	void **arrays;
+	IRString *output;
+	long steps;
+	size_t memory;
+	int status;
+} IREval;
+
+// room for length characters, a literal is copied out the first time
+static int IR_evalReserve(IREval *ev, IRString *s, size_t length) {
+	if (length < s->capacity)
+		return 1;
+	size_t capacity = s->capacity < 16 ? 16 : s->capacity;
+	while (capacity <= length)
+		capacity *= 2;
+	ev->memory += capacity - s->capacity;
+	if (ev->memory > IR_EVAL_MEMORY)
+		return 0;
+	char *text = realloc(s->capacity == 0 ? NULL : s->text, capacity);
+	if (text == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for evaluation.");
+	}
+	if (s->capacity == 0)
+		memcpy(text, s->text, s->length);
+	s->text = text;
+	s->capacity = capacity;
+	return 1;
+}
+
+static int IR_evalWrite(IREval *ev, const char *text, size_t length) {
+	if (ev->output->length + length > IR_EVAL_OUTPUT || !IR_evalReserve(ev, ev->output, ev->output->length + length))
+		return 0;
+	memcpy(ev->output->text + ev->output->length, text, length);
+	ev->output->length += length;
+	return 1;
+}
+
+static IRString *IR_evalString(IREval *ev, IRValue *value) {
+	value = IR_resolve(value);
+	if (value->op == IR_STRVAR)
+		return &ev->variables[value->variable];
+	if (value->op == IR_STRTMP)
+		return &ev->temps[value->variable];
+	return &ev->literals[value->variable];
+}
+
+static IRSlot IR_evalOperand(IREval *ev, IRValue *value) {
+	return ev->slots[IR_resolve(value)->id];
+}
+
+static IRType IR_operandType(IRValue *value) {
+	return IR_resolve(value->operands[0])->type;
+}
+
+// dst = parts[1] + ... + parts[n-1], appending in place when parts[1] is dst
+static int IR_evalConcat(IREval *ev, IRValue *value) {
+	IRString *dst = IR_evalString(ev, value->operands[0]);
+	size_t length = 0;
+	int first = IR_evalString(ev, value->operands[1]) == dst ? 2 : 1;
+	int alias = 0;
+	int i;
+	for (i = 1; i < value->operandCount; i++) {
+		IRString *part = IR_evalString(ev, value->operands[i]);
+		length += part->length;
+		if (i >= first && part == dst)
+			alias = 1;
+	}
+	IRString fresh = { "", 0, 0 };
+	IRString *into = dst;
+	if (alias || first == 1)
+		into = &fresh;
+	size_t at = first == 2 && !alias ? dst->length : 0;
+	if (!IR_evalReserve(ev, into, length))
+		return 0;
+	for (i = into == dst ? first : 1; i < value->operandCount; i++) {
+		IRString *part = IR_evalString(ev, value->operands[i]);
+		memcpy(into->text + at, part->text, part->length);
+		at += part->length;
+	}
+	if (into == &fresh) {
+		if (dst->capacity != 0) {
+			ev->memory -= dst->capacity;
+			free(dst->text);
+		}
+		*dst = fresh;
+	}
+	dst->length = length;
+	return 1;
+}
+
+static int IR_evalSet(IREval *ev, IRString *dst, IRString *src) {
+	if (dst == src)
+		return 1;
+	if (src->capacity == 0 && dst->capacity == 0) {
+		*dst = *src;
+		return 1;
+	}
+	if (dst->capacity == 0)
+		dst->length = 0;
+	if (!IR_evalReserve(ev, dst, src->length))
+		return 0;
+	memcpy(dst->text, src->text, src->length);
+	dst->length = src->length;
+	return 1;
+}
+
+// sets the phis of the block being entered, all at once like the C does
+static void IR_evalEdge(IREval *ev, IRBlock *from, IRBlock *to) {
+	int index = 0;
+	ListNode *pred;
+	for (pred = to->preds->first; pred->value != from; pred = pred->next)
+		index++;
+	int count = 0;
+	ListNode *node;
+	for (node = to->values->first; node != NULL; node = node->next) {
+		IRValue *phi = (IRValue *) node->value;
+		if (phi->op != IR_PHI)
+			break;
+		ev->scratch[count++] = IR_evalOperand(ev, phi->operands[index]);
+	}
+	count = 0;
+	for (node = to->values->first; node != NULL; node = node->next) {
+		IRValue *phi = (IRValue *) node->value;
+		if (phi->op != IR_PHI)
+			break;
+		ev->slots[phi->id] = ev->scratch[count++];
+	}
+}
+
+static int IR_evalCompare(IRType type, IROp op, IRSlot a, IRSlot b) {
+	double x = type == IR_INT ? a.i : type == IR_FLOAT ? a.f : a.d;
+	double y = type == IR_INT ? b.i : type == IR_FLOAT ? b.f : b.d;
+	switch (op) {
+		case IR_LT:
+			return x < y;
+		case IR_LE:
+			return x <= y;
+		case IR_GT:
+			return x > y;
+		case IR_GE:
+			return x >= y;
+		case IR_EQ:
+			return x == y;
+		default:
+			return x != y;
+	}
+}
+
+// int arithmetic wraps, as it does in every other backend
+static int IR_evalArithmetic(IRValue *value, IRSlot a, IRSlot b, IRSlot *result) {
+	switch (value->type) {
+		case IR_INT:
+			if (value->op == IR_ADD)
+				result->i = (int) ((unsigned int) a.i + (unsigned int) b.i);
+			else if (value->op == IR_SUB)
+				result->i = (int) ((unsigned int) a.i - (unsigned int) b.i);
+			else if (value->op == IR_MUL)
+				result->i = (int) ((unsigned int) a.i * (unsigned int) b.i);
+			else if (b.i == 0 || (a.i == INT_MIN && b.i == -1))
+				return 0;
+			else
+				result->i = a.i / b.i;
+			return 1;
+		case IR_FLOAT:
+			if (value->op == IR_ADD)
+				result->f = a.f + b.f;
+			else if (value->op == IR_SUB)
+				result->f = a.f - b.f;
+			else if (value->op == IR_MUL)
+				result->f = a.f * b.f;
+			else
+				result->f = a.f / b.f;
+			return 1;
+		default:
+			if (value->op == IR_ADD)
+				result->d = a.d + b.d;
+			else if (value->op == IR_SUB)
+				result->d = a.d - b.d;
+			else if (value->op == IR_MUL)
+				result->d = a.d * b.d;
+			else
+				result->d = a.d / b.d;
+			return 1;
+	}
+}
+
+static IRSlot IR_evalConvert(IRType to, IRType from, IRSlot a) {
+	IRSlot result;
+	double x = from == IR_INT ? a.i : from == IR_FLOAT ? a.f : a.d;
+	if (to == IR_INT)
+		result.i = from == IR_FLOAT ? (int) a.f : (int) x;
+	else if (to == IR_FLOAT)
+		result.f = from == IR_INT ? (float) a.i : (float) x;
+	else
+		result.d = x;
+	return result;
+}
+
+// 1 when the program ran to its end, 0 when evaluation gave up
+static int IR_run(IREval *ev) {
+	IR *ir = ev->ir;
+	IRBlock *block = (IRBlock *) List_first(ir->blocks);
+	char text[352];
+	int length;
+
+	for (;;) {
+		IRBlock *next = NULL;
+		ListNode *node;
+		for (node = block->values->first; node != NULL; node = node->next) {
+			IRValue *value = (IRValue *) node->value;
+			if (++ev->steps > IR_EVAL_STEPS)
+				return 0;
+			IRSlot a;
+			IRSlot b;
+			int index;
+			Symbol *array;
+			switch (value->op) {
+				case IR_PHI:
+					break;
+
+				case IR_ADD:
+				case IR_SUB:
+				case IR_MUL:
+				case IR_DIV:
+					a = IR_evalOperand(ev, value->operands[0]);
+					b = IR_evalOperand(ev, value->operands[1]);
+					if (!IR_evalArithmetic(value, a, b, &ev->slots[value->id]))
+						return 0;
+					break;
+
+				case IR_LT:
+				case IR_LE:
+				case IR_GT:
+				case IR_GE:
+				case IR_EQ:
+				case IR_NE:
+					a = IR_evalOperand(ev, value->operands[0]);
+					b = IR_evalOperand(ev, value->operands[1]);
+					ev->slots[value->id].i = IR_evalCompare(IR_operandType(value), value->op, a, b);
+					break;
+
+				case IR_CONVERT:
+					a = IR_evalOperand(ev, value->operands[0]);
+					ev->slots[value->id] = IR_evalConvert(value->type, IR_operandType(value), a);
+					break;
+
+				case IR_STREQ:
+				case IR_STRNE: {
+					IRString *x = IR_evalString(ev, value->operands[0]);
+					IRString *y = IR_evalString(ev, value->operands[1]);
+					int equal = x->length == y->length && memcmp(x->text, y->text, x->length) == 0;
+					ev->slots[value->id].i = value->op == IR_STREQ ? equal : !equal;
+					break;
+				}
+
+				case IR_LOAD:
+				case IR_STORE:
+					array = ir->variables[value->variable];
+					index = IR_evalOperand(ev, value->operands[0]).i;
+					if (index < 0 || index >= array->size)
+						return 0;
+					if (value->op == IR_STORE && array->type == INT_ARRAY)
+						((int *) ev->arrays[value->variable])[index] = IR_evalOperand(ev, value->operands[1]).i;
+					else if (value->op == IR_STORE)
+						((float *) ev->arrays[value->variable])[index] = IR_evalOperand(ev, value->operands[1]).f;
+					else if (array->type == INT_ARRAY)
+						ev->slots[value->id].i = ((int *) ev->arrays[value->variable])[index];
+					else
+						ev->slots[value->id].f = ((float *) ev->arrays[value->variable])[index];
+					break;
+
+				case IR_BOUNDS:
+					index = IR_evalOperand(ev, value->operands[0]).i;
+					if ((unsigned int) index < (unsigned int) ir->variables[value->variable]->size)
+						break;
+					length = sprintf(text, "ERROR AT LINE #%d:\nArray index out of bounds.\n", value->line);
+					ev->status = 1;
+					return IR_evalWrite(ev, text, (size_t) length);
+
+				case IR_PRINT_INT:
+					length = sprintf(text, "%d\n", IR_evalOperand(ev, value->operands[0]).i);
+					if (!IR_evalWrite(ev, text, (size_t) length))
+						return 0;
+					break;
+
+				case IR_PRINT_FLOAT:
+					a = IR_evalOperand(ev, value->operands[0]);
+					length = sprintf(text, "%.2f\n", IR_operandType(value) == IR_FLOAT ? (double) a.f : a.d);
+					if (!IR_evalWrite(ev, text, (size_t) length))
+						return 0;
+					break;
+
+				case IR_PRINT_BOOL:
+					if (IR_evalOperand(ev, value->operands[0]).i == 0) {
+						if (!IR_evalWrite(ev, "FALSE\n", 6))
+							return 0;
+					} else if (!IR_evalWrite(ev, "TRUE\n", 5)) {
+						return 0;
+					}
+					break;
+
+				case IR_PRINT_STR: {
+					IRString *s = IR_evalString(ev, value->operands[0]);
+					if (!IR_evalWrite(ev, s->text, s->length) || !IR_evalWrite(ev, "\n", 1))
+						return 0;
+					break;
+				}
+
+				case IR_WRITE:
+					if (!IR_evalWrite(ev, value->text, strlen(value->text)))
+						return 0;
+					break;
+
+				case IR_STRSET:
+					if (!IR_evalSet(ev, IR_evalString(ev, value->operands[0]), IR_evalString(ev, value->operands[1])))
+						return 0;
+					break;
+
+				case IR_STRCAT:
+					if (!IR_evalConcat(ev, value))
+						return 0;
+					break;
+
+				case IR_JUMP:
+					next = value->targets[0];
+					break;
+
+				case IR_BRANCH:
+					next = IR_evalOperand(ev, value->operands[0]).i != 0 ? value->targets[0] : value->targets[1];
+					break;
+
+				case IR_RETURN:
+					return 1;
+
+				default:
+					// INPUT, the output now depends on what the user types,
+					// or a PARALLEL FOR, which only the generated code runs
+					return 0;
+			}
+		}
+		IR_evalEdge(ev, block, next);
+		block = next;
+	}
+}
+
+static void *IR_evalAllocate(size_t count, size_t size) {
+	void *memory = calloc(count + 1, size);
+	if (memory == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for evaluation.");
+	}
+	return memory;
+}
+
+static void IR_evalSetup(IREval *ev) {
+	IR *ir = ev->ir;
+	ev->slots = IR_evalAllocate(ir->nextValue, sizeof(IRSlot));
+	ev->scratch = IR_evalAllocate(ir->nextValue, sizeof(IRSlot));
+	ev->variables = IR_evalAllocate(ir->variableCount, sizeof(IRString));
+	ev->temps = IR_evalAllocate(ir->ast->stringTemps, sizeof(IRString));
+	ev->literals = IR_evalAllocate(List_count(ir->ast->stringLiterals), sizeof(IRString));
+	ev->arrays = IR_evalAllocate(ir->variableCount, sizeof(void *));
+
+	int i;
+	for (i = 0; i < ir->variableCount; i++) {
+		ev->variables[i].text = "";
+		Symbol *s = ir->variables[i];
+		if (AST_isArray(s->type)) {
+			ev->memory += (size_t) s->size * 4;
+			if (ev->memory <= IR_EVAL_MEMORY)
+				ev->arrays[i] = IR_evalAllocate((size_t) s->size, 4);
+		}
+	}
+	for (i = 0; i < ir->ast->stringTemps; i++)
+		ev->temps[i].text = "";
+	i = 0;
+	LIST_FOREACH(ir->ast->stringLiterals, first, next, cur) {
+		ev->literals[i].text = (char *) cur->value;
+		ev->literals[i++].length = strlen((char *) cur->value);
+	}
+
+	ListNode *node;
+	for (node = ir->values->first; node != NULL; node = node->next) {
+		IRValue *value = (IRValue *) node->value;
+		if (value->op != IR_CONST)
+			continue;
+		if (value->type == IR_INT)
+			ev->slots[value->id].i = (int) strtoll(value->text, NULL, 10);
+		else if (value->type == IR_FLOAT)
+			ev->slots[value->id].f = strtof(value->text, NULL);
+		else
+			ev->slots[value->id].d = strtod(value->text, NULL);
+	}
+}
+
+static void IR_evalFree(IRString *strings, int count) {
+	int i;
+	for (i = 0; i < count; i++) {
+		if (strings[i].capacity != 0)
+			free(strings[i].text);
+	}
+	free(strings);
+}
+
+int IR_evaluate(IR *ir, char **output, size_t *length, int *status) {
+	IREval ev;
+	IRString result = { "", 0, 0 };
+	memset(&ev, 0, sizeof(IREval));
+	ev.ir = ir;
+	ev.output = &result;
+	IR_evalSetup(&ev);
+
+	int finished = ev.memory <= IR_EVAL_MEMORY && IR_run(&ev);
+
+	int i;
+	for (i = 0; i < ir->variableCount; i++)
+		free(ev.arrays[i]);
+	free(ev.arrays);
+	IR_evalFree(ev.variables, ir->variableCount);
+	IR_evalFree(ev.temps, ir->ast->stringTemps);
+	free(ev.literals);
+	free(ev.scratch);
+	free(ev.slots);
+
+	if (!finished) {
+		if (result.capacity != 0)
+			free(result.text);
+		return 0;
+	}
+	*output = result.text;
+	*length = result.length;
+	*status = ev.status;
+	return 1;
+}
@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ir.h"
+#include "diagnostic.h"
+
+// how far IR_range looks back through the values an index is made from
+#define IR_RANGE_DEPTH 6
+
+// what is known of an int value: low <= value <= high
+typedef struct IRRange {
+	long long low;
+	long long high;
+} IRRange;
+
+// value op other holds in every block that block dominates
+typedef struct IRFact {
+	IRValue *value;
+	IROp op;
+	IRValue *other;
+	IRBlock *block;
+} IRFact;
+
+static void IR_markReachable(IR *ir) {
+	List *work = List_create();
+	IRBlock *entry = (IRBlock *) List_first(ir->blocks);
+	entry->reachable = 1;
+	List_push(work, entry);
+	IRBlock *block;
+	while ((block = (IRBlock *) List_pop(work)) != NULL) {
+		IRValue *last = (IRValue *) List_last(block->values);
+		int i;
+		for (i = 0; i < 2; i++) {
+			if (last->targets[i] != NULL && !last->targets[i]->reachable) {
+				last->targets[i]->reachable = 1;
+				List_push(work, last->targets[i]);
+			}
+		}
+	}
+	List_destroy(work);
+}
+
+// forgets the edges from blocks that are never run, with their phi operands
+static void IR_prunePreds(IR *ir, List *phis) {
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (!block->reachable)
+			continue;
+		ListNode *pred = block->preds->first;
+		int index = 0;
+		while (pred != NULL) {
+			ListNode *following = pred->next;
+			if (((IRBlock *) pred->value)->reachable) {
+				index++;
+			} else {
+				ListNode *node;
+				for (node = block->values->first; node != NULL; node = node->next) {
+					IRValue *phi = (IRValue *) node->value;
+					if (phi->op != IR_PHI)
+						break;
+					phi->operandCount--;
+					memmove(&phi->operands[index], &phi->operands[index + 1], sizeof(IRValue *) * (phi->operandCount - index));
+				}
+				List_remove(block->preds, pred);
+			}
+			pred = following;
+		}
+		ListNode *node;
+		for (node = block->values->first; node != NULL && ((IRValue *) node->value)->op == IR_PHI; node = node->next)
+			List_push(phis, node->value);
+	}
+}
+
+// everything with a side effect is live, and so is whatever it reads
+static void IR_markLive(IR *ir) {
+	List *work = List_create();
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (!block->reachable)
+			continue;
+		ListNode *node;
+		for (node = block->values->first; node != NULL; node = node->next) {
+			IRValue *value = (IRValue *) node->value;
+			if (IR_hasSideEffects(value->op)) {
+				value->live = 1;
+				List_push(work, value);
+			}
+		}
+	}
+	IRValue *value;
+	while ((value = (IRValue *) List_pop(work)) != NULL) {
+		int i;
+		for (i = 0; i < value->operandCount; i++) {
+			IRValue *operand = IR_resolve(value->operands[i]);
+			value->operands[i] = operand;
+			if (!operand->live) {
+				operand->live = 1;
+				List_push(work, operand);
+			}
+		}
+	}
+	List_destroy(work);
+}
+
+static void IR_sweep(IR *ir) {
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (!block->reachable)
+			continue;
+		ListNode *node = block->values->first;
+		while (node != NULL) {
+			ListNode *following = node->next;
+			if (!((IRValue *) node->value)->live)
+				List_remove(block->values, node);
+			node = following;
+		}
+	}
+}
+
+// drops the blocks no path from the entry reaches, the phis that only
+// differed along those paths, the bounds checks that can never fail and
+// every pure value that nothing reads
+void IR_optimize(IR *ir) {
+	List *phis = List_create();
+	IR_markReachable(ir);
+	IR_prunePreds(ir, phis);
+	while (List_count(phis) > 0) {
+		IRValue *phi = (IRValue *) List_shift(phis);
+		if (phi->replacement == NULL)
+			IR_tryRemoveTrivialPhi(ir, phi);
+	}
+	List_destroy(phis);
+	IR_removeBoundsChecks(ir);
+	IR_markLive(ir);
+	IR_sweep(ir);
+	LIST_FOREACH(ir->parallels, first, next, cur) {
+		IR_optimize((IR *) cur->value);
+	}
+}
+
+static IRBlock *IR_intersect(IRBlock *a, IRBlock *b) {
+	while (a != b) {
+		while (a->order > b->order)
+			a = a->idom;
+		while (b->order > a->order)
+			b = b->idom;
+	}
+	return a;
+}
+
+// Cooper, Harvey and Kennedy's iterative algorithm, over reachable blocks
+void IR_dominators(IR *ir) {
+	IRBlock **postorder = malloc(sizeof(IRBlock *) * (ir->nextBlock + 1));
+	IRBlock **stack = malloc(sizeof(IRBlock *) * (ir->nextBlock + 1));
+	int *edge = calloc(ir->nextBlock + 1, sizeof(int));
+	char *seen = calloc(ir->nextBlock + 1, 1);
+	if (postorder == NULL || stack == NULL || edge == NULL || seen == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	int count = 0;
+	int depth = 0;
+	IRBlock *entry = (IRBlock *) List_first(ir->blocks);
+	stack[depth++] = entry;
+	seen[entry->id] = 1;
+	while (depth > 0) {
+		IRBlock *block = stack[depth - 1];
+		IRValue *last = (IRValue *) List_last(block->values);
+		IRBlock *target = NULL;
+		while (edge[block->id] < 2 && target == NULL) {
+			target = last->targets[edge[block->id]++];
+			if (target != NULL && seen[target->id])
+				target = NULL;
+		}
+		if (target == NULL) {
+			postorder[count++] = block;
+			depth--;
+			continue;
+		}
+		seen[target->id] = 1;
+		stack[depth++] = target;
+	}
+
+	int i;
+	for (i = 0; i < count; i++) {
+		postorder[i]->order = count - 1 - i;
+		postorder[i]->idom = NULL;
+	}
+	entry->idom = entry;
+	int changed = 1;
+	while (changed) {
+		changed = 0;
+		for (i = count - 2; i >= 0; i--) {
+			IRBlock *block = postorder[i];
+			IRBlock *idom = NULL;
+			LIST_FOREACH(block->preds, first, next, cur) {
+				IRBlock *pred = (IRBlock *) cur->value;
+				if (pred->idom == NULL)
+					continue;
+				idom = idom == NULL ? pred : IR_intersect(pred, idom);
+			}
+			if (block->idom != idom) {
+				block->idom = idom;
+				changed = 1;
+			}
+		}
+	}
+	free(seen);
+	free(edge);
+	free(stack);
+	free(postorder);
+}
+
+int IR_dominates(IRBlock *a, IRBlock *b) {
+	while (b != a) {
+		if (b->idom == b)
+			return 0;
+		b = b->idom;
+	}
+	return 1;
+}
+
+static IROp IR_swapped(IROp op) {
+	switch (op) {
+		case IR_LT:
+			return IR_GT;
+		case IR_LE:
+			return IR_GE;
+		case IR_GT:
+			return IR_LT;
+		case IR_GE:
+			return IR_LE;
+		default:
+			return op;
+	}
+}
+
+static IROp IR_negated(IROp op) {
+	switch (op) {
+		case IR_LT:
+			return IR_GE;
+		case IR_LE:
+			return IR_GT;
+		case IR_GT:
+			return IR_LE;
+		case IR_GE:
+			return IR_LT;
+		default:
+			return IR_NE;
+	}
+}
+
+static void IR_addFact(List **facts, IRValue *value, IROp op, IRValue *other, IRBlock *block) {
+	if (op == IR_NE || value->op == IR_CONST)
+		return;
+	IRFact *fact = malloc(sizeof(IRFact));
+	fact->value = value;
+	fact->op = op;
+	fact->other = other;
+	fact->block = block;
+	if (facts[value->id] == NULL)
+		facts[value->id] = List_create();
+	List_push(facts[value->id], fact);
+}
+
+// an int comparison a branch tests holds along the edge it is true for, and
+// its negation along the other, from the first block past that edge on
+static void IR_branchFacts(IRBlock *block, List **facts) {
+	IRValue *branch = (IRValue *) List_last(block->values);
+	if (branch->op != IR_BRANCH || branch->targets[0] == branch->targets[1])
+		return;
+	IRValue *condition = IR_resolve(branch->operands[0]);
+	if (condition->op < IR_LT || condition->op > IR_EQ || condition->block != block)
+		return;
+	IRValue *left = IR_resolve(condition->operands[0]);
+	IRValue *right = IR_resolve(condition->operands[1]);
+	if (left->type != IR_INT)
+		return;
+	int i;
+	for (i = 0; i < 2; i++) {
+		IRBlock *target = branch->targets[i];
+		if (List_count(target->preds) != 1)
+			continue;
+		IROp op = i == 0 ? condition->op : IR_negated(condition->op);
+		IR_addFact(facts, left, op, right, target);
+		IR_addFact(facts, right, IR_swapped(op), left, target);
+	}
+}
+
+static IRRange IR_range(List **facts, IRValue *value, IRBlock *at, int depth);
+
+// narrows the range with the comparisons known to hold at that block
+static IRRange IR_applyFacts(List **facts, IRValue *value, IRBlock *at, IRRange range, int depth) {
+	if (facts[value->id] == NULL || depth >= IR_RANGE_DEPTH)
+		return range;
+	LIST_FOREACH(facts[value->id], first, next, cur) {
+		IRFact *fact = (IRFact *) cur->value;
+		if (!IR_dominates(fact->block, at))
+			continue;
+		IRRange other = IR_range(facts, fact->other, at, depth + 1);
+		long long strict = fact->op == IR_LT || fact->op == IR_GT;
+		if ((fact->op == IR_LT || fact->op == IR_LE || fact->op == IR_EQ) && other.high - strict < range.high)
+			range.high = other.high - strict;
+		if ((fact->op == IR_GT || fact->op == IR_GE || fact->op == IR_EQ) && other.low + strict > range.low)
+			range.low = other.low + strict;
+	}
+	return range;
+}
+
+static IRRange IR_clamp(long long low, long long high) {
+	IRRange range = { INT_MIN, INT_MAX };
+	if (low >= INT_MIN && high <= INT_MAX && low <= high) {
+		range.low = low;
+		range.high = high;
+	}
+	return range;
+}
+
+// a phi that only ever adds to itself starts from its other operands and
+// never goes below them, as long as the add can not wrap
+static IRRange IR_phiRange(List **facts, IRValue *phi, int depth) {
+	IRRange full = { INT_MIN, INT_MAX };
+	long long low = LLONG_MAX;
+	long long high = LLONG_MIN;
+	int grows = 0;
+	int i = 0;
+	LIST_FOREACH(phi->block->preds, first, next, cur) {
+		IRBlock *pred = (IRBlock *) cur->value;
+		IRValue *operand = IR_resolve(phi->operands[i++]);
+		if (operand->op == IR_ADD && IR_resolve(operand->operands[0]) == phi) {
+			IRRange step = IR_range(facts, operand->operands[1], pred, depth + 1);
+			IRRange before = IR_applyFacts(facts, phi, operand->block, full, depth + 1);
+			if (step.low < 0 || before.high + step.high > INT_MAX)
+				return full;
+			grows = 1;
+			continue;
+		}
+		IRRange range = IR_range(facts, operand, pred, depth + 1);
+		low = range.low < low ? range.low : low;
+		high = range.high > high ? range.high : high;
+	}
+	if (low == LLONG_MAX)
+		return full;
+	return IR_clamp(low, grows ? INT_MAX : high);
+}
+
+static IRRange IR_range(List **facts, IRValue *value, IRBlock *at, int depth) {
+	IRRange range = { INT_MIN, INT_MAX };
+	value = IR_resolve(value);
+	if (value->type != IR_INT)
+		return range;
+	IRRange a;
+	IRRange b;
+
+	if (depth < IR_RANGE_DEPTH) {
+		switch (value->op) {
+			case IR_CONST:
+				a.low = strtoll(value->text, NULL, 10);
+				range = IR_clamp(a.low, a.low);
+				break;
+			case IR_UNDEF:
+				range.low = range.high = 0;
+				break;
+			case IR_ADD:
+			case IR_SUB:
+			case IR_MUL:
+				a = IR_range(facts, value->operands[0], at, depth + 1);
+				b = IR_range(facts, value->operands[1], at, depth + 1);
+				if (value->op == IR_ADD) {
+					range = IR_clamp(a.low + b.low, a.high + b.high);
+				} else if (value->op == IR_SUB) {
+					range = IR_clamp(a.low - b.high, a.high - b.low);
+				} else if (b.low == b.high && b.low >= 0) {
+					range = IR_clamp(a.low * b.low, a.high * b.low);
+				}
+				break;
+			case IR_DIV:
+				a = IR_range(facts, value->operands[0], at, depth + 1);
+				b = IR_range(facts, value->operands[1], at, depth + 1);
+				if (b.low == b.high && b.low > 0)
+					range = IR_clamp(a.low / b.low, a.high / b.low);
+				break;
+			case IR_LT:
+			case IR_LE:
+			case IR_GT:
+			case IR_GE:
+			case IR_EQ:
+			case IR_NE:
+			case IR_STREQ:
+			case IR_STRNE:
+				range.low = 0;
+				range.high = 1;
+				break;
+			case IR_PHI:
+				range = IR_phiRange(facts, value, depth);
+				break;
+			default:
+				break;
+		}
+	}
+
+	return IR_applyFacts(facts, value, at, range, depth);
+}
+
+// a check goes when every value its index can have at that point is inside
+// the array, the usual case being a FOR loop from 0 to the last element
+void IR_removeBoundsChecks(IR *ir) {
+	if (!ir->ast->seenArray)
+		return;
+	IR_dominators(ir);
+	List **facts = calloc(ir->nextValue + 1, sizeof(List *));
+	if (facts == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the IR.");
+	}
+	LIST_FOREACH(ir->blocks, first, next, cur) {
+		IRBlock *block = (IRBlock *) cur->value;
+		if (block->reachable)
+			IR_branchFacts(block, facts);
+	}
+
+	ListNode *blockNode;
+	for (blockNode = ir->blocks->first; blockNode != NULL; blockNode = blockNode->next) {
+		IRBlock *block = (IRBlock *) blockNode->value;
+		if (!block->reachable)
+			continue;
+		ListNode *node = block->values->first;
+		while (node != NULL) {
+			ListNode *following = node->next;
+			IRValue *check = (IRValue *) node->value;
+			if (check->op == IR_BOUNDS) {
+				IRRange range = IR_range(facts, check->operands[0], block, 0);
+				if (range.low >= 0 && range.high < ir->variables[check->variable]->size)
+					List_remove(block->values, node);
+			}
+			node = following;
+		}
+	}
+
+	int i;
+	for (i = 0; i < ir->nextValue; i++) {
+		if (facts[i] != NULL)
+			List_clear_destroy(facts[i]);
+	}
+	free(facts);
+}
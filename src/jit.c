@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "jit.h"
+
+// in X64RuntimeCall order
+static void *Jit_helpers[X64RUNTIME_COUNT] = {
+	(void *) X64Runtime_init,
+	(void *) X64Runtime_flush,
+	(void *) X64Runtime_write,
+	(void *) X64Runtime_printInt,
+	(void *) X64Runtime_printFloat,
+	(void *) X64Runtime_printBool,
+	(void *) X64Runtime_printStr,
+	(void *) X64Runtime_inputInt,
+	(void *) X64Runtime_inputFloat,
+	(void *) X64Runtime_strInput,
+	(void *) X64Runtime_strSet,
+	(void *) X64Runtime_strCat,
+	(void *) X64Runtime_strEq
+};
+
+static unsigned long Jit_align(unsigned long value, unsigned long alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// the same jmp rel32 table the blob starts with, but each entry lands on a
+// jmp [rip] to wherever the helper is, which can be far from the mapping
+static void Jit_runtimeTable(unsigned char *table) {
+	unsigned char *trampolines = table + Jit_align(X64RUNTIME_COUNT * X64RUNTIME_ENTRY_SIZE, JIT_TRAMPOLINE_SIZE);
+	int i;
+	for (i = 0; i < X64RUNTIME_COUNT; i++) {
+		unsigned char *entry = table + i * X64RUNTIME_ENTRY_SIZE;
+		unsigned char *trampoline = trampolines + i * JIT_TRAMPOLINE_SIZE;
+		int rel = (int) (trampoline - (entry + X64RUNTIME_ENTRY_SIZE));
+		entry[0] = 0xe9;
+		memcpy(entry + 1, &rel, 4);
+		// jmp qword [rip + 0]; dq helper
+		trampoline[0] = 0xff;
+		trampoline[1] = 0x25;
+		memset(trampoline + 2, 0, 4);
+		memcpy(trampoline + 6, &Jit_helpers[i], 8);
+	}
+}
+
+void Jit_run(X64 *x) {
+	unsigned long page = (unsigned long) sysconf(_SC_PAGESIZE);
+	unsigned long offsets[X64_SECTIONS];
+	offsets[X64_CODE] = 0;
+	offsets[X64_RODATA] = Jit_align(x->code.length, 16);
+	offsets[X64_RUNTIME] = Jit_align(offsets[X64_RODATA] + x->rodata.length, 16);
+	unsigned long tableSize = Jit_align(X64RUNTIME_COUNT * X64RUNTIME_ENTRY_SIZE, JIT_TRAMPOLINE_SIZE)
+		+ X64RUNTIME_COUNT * JIT_TRAMPOLINE_SIZE;
+	unsigned long textSize = Jit_align(offsets[X64_RUNTIME] + tableSize, page);
+	offsets[X64_BSS] = textSize;
+	unsigned long size = textSize + Jit_align(x->bssSize, page);
+
+	// one mapping keeps the data in reach of the code's rip relative operands
+	unsigned char *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		printf("Unable to map memory for the JIT.\n");
+		exit(1);
+	}
+	unsigned long addresses[X64_SECTIONS];
+	int i;
+	for (i = 0; i < X64_SECTIONS; i++)
+		addresses[i] = (unsigned long) base + offsets[i];
+	X64_resolve(x, addresses);
+
+	memcpy(base + offsets[X64_CODE], x->code.bytes, x->code.length);
+	memcpy(base + offsets[X64_RODATA], x->rodata.bytes, x->rodata.length);
+	Jit_runtimeTable(base + offsets[X64_RUNTIME]);
+
+	if (mprotect(base, textSize, PROT_READ | PROT_EXEC) != 0) {
+		printf("Unable to make JIT code executable.\n");
+		exit(1);
+	}
+	void (*program)(void) = (void (*)(void)) base;
+	program();
+	munmap(base, size);
+}
@@ -0,0 +1,15 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "x64.h"
+
+// Runs the native backend's code in process. The code and its constants are
+// copied into a fresh mapping that is writable while it is filled in and
+// only executable afterwards, never both. Runtime calls go through a small
+// table of absolute jumps to the X64Runtime functions linked into teenytiny.
+
+#define JIT_TRAMPOLINE_SIZE 16
+
+void Jit_run(X64 *x);
+
+#endif
@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include "lex.h"
+#include "mem.h"
+#include "diagnostic.h"
 
 Lexer *Lexer_create(FILE *source) {
 	Lexer *lex = malloc(sizeof(Lexer));
@@ -37,11 +39,10 @@ char Lexer_peek(Lexer *lex) {
 	return lex->nextChar;	
 }
 
+// t is not finished and not counted yet, so only the struct is freed
 void Lexer_abort(Lexer *lex, Token *t, char *message) {
-	printf("ERROR AT LINE #%d:\n", lex->lineNumber);
-	printf("%s\n", message);
-	Token_kill(t);
-	exit(1);
+	free(t);
+	Diagnostic_raise(lex->lineNumber, message);
 }
 
 Token *Lexer_getToken(Lexer *lex) {
@@ -137,6 +138,16 @@ Token *Lexer_getToken(Lexer *lex) {
 			t->type = RIGHTPAREN;
 			break;
 
+		case '[':
+			t->text = strdup("[");
+			t->type = LEFTBRACKET;
+			break;
+
+		case ']':
+			t->text = strdup("]");
+			t->type = RIGHTBRACKET;
+			break;
+
 		case '\"':
 			Lexer_nextChar(lex);
 			Lexer_readString(lex, t);
@@ -159,19 +170,23 @@ Token *Lexer_getToken(Lexer *lex) {
 			} else if (isalpha(lex->curChar)) {
 				Lexer_readSymbol(lex, t);   
 			} else {
-				printf("unknown character: %c\n", lex->curChar);
-				t->text = strdup("");
-				t->type = 0;
+				char message[32];
+				snprintf(message, sizeof(message), "Unknown character %c.", lex->curChar);
+				Lexer_abort(lex, t, message);
 			}
 	}
 	
 	Lexer_nextChar(lex);
+	Mem_add(MEM_TOKENS, t);
+	Mem_add(MEM_TOKENS, t->text);
 	return t;
 }
 
 void Token_kill(Token *t) {
 	if (t == NULL)
 		return;
+	Mem_remove(MEM_TOKENS, t->text);
+	Mem_remove(MEM_TOKENS, t);
 	free(t->text);
 	free(t);
 }
@@ -183,6 +198,8 @@ Token *Token_copy(Token *t) {
 	Token *newToken = malloc(sizeof(Token));
 	newToken->type = t->type;
 	newToken->text = strdup(t->text);
+	Mem_add(MEM_TOKENS, newToken);
+	Mem_add(MEM_TOKENS, newToken->text);
 	return newToken;
 }
 
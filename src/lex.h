@@ -39,6 +39,9 @@ typedef enum TokenType {
 	BOOL = 119,
 	TRUE = 120,
 	FALSE = 121,
+	ARRAY = 122,
+	PARALLEL = 123,
+	REDUCE = 124,
 	EQ = 201,
 	PLUS = 202,
 	MINUS = 203,
@@ -52,11 +55,15 @@ typedef enum TokenType {
 	GTEQ = 211,
 	LEFTPAREN = 212,
 	RIGHTPAREN = 213,
+	LEFTBRACKET = 214,
+	RIGHTBRACKET = 215,
 	NOT_VAR = 301,
 	INT_VAR = 302,
 	STRING_VAR = 303,
 	FLOAT_VAR = 304,
-	BOOL_VAR = 305
+	BOOL_VAR = 305,
+	INT_ARRAY = 306,
+	FLOAT_ARRAY = 307
 } TokenType;
 
 struct Token;
@@ -90,7 +97,10 @@ static const struct {
 	{BOOL_VAR, "BOOL"},
 	{STRING_VAR, "STRING"},
 	{TRUE, "TRUE"},
-	{FALSE, "FALSE"}
+	{FALSE, "FALSE"},
+	{ARRAY, "ARRAY"},
+	{PARALLEL, "PARALLEL"},
+	{REDUCE, "REDUCE"}
 };
 
 Lexer *Lexer_create(FILE *source);
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libteenytiny.h"
+#include "compile.h"
+#include "emit.h"
+
+int TeenyTiny_compile(const char *source, size_t length, const TeenyTinyOptions *options, TeenyTinyResult *result) {
+	memset(result, 0, sizeof(TeenyTinyResult));
+	CompileOptions compileOptions = { 0, 0, 0, 0, options->evaluate, options->profile, NULL, NULL, NULL, 0 };
+	// set after setjmp and read after longjmp, so volatile
+	Compilation *volatile comp = NULL;
+	char *volatile name = NULL;
+
+	DiagnosticTrap trap;
+	Diagnostic_trap(&trap);
+	if (setjmp(trap.jump) != 0) {
+		Diagnostic_release(&trap);
+		Compilation_kill(comp);
+		free(name);
+		result->diagnostics = malloc(sizeof(Diagnostic));
+		if (result->diagnostics != NULL) {
+			*result->diagnostics = trap.diagnostic;
+			result->diagnosticCount = 1;
+		}
+		return 1;
+	}
+
+	comp = Compilation_create(NULL, NULL, &compileOptions);
+	if (options->name != NULL) {
+		name = strdup(options->name);
+		if (name == NULL)
+			Diagnostic_raise(0, "Unable to allocate memory for the name.");
+	}
+	// the lexer reads a stream, an empty one still needs a byte to open
+	FILE *stream = fmemopen((void *) (length == 0 ? "" : source), length == 0 ? 1 : length, "r");
+	if (stream == NULL)
+		Diagnostic_raise(0, "Unable to allocate memory for the source.");
+	comp->lex = Lexer_create(stream);
+	Emitter_create(NULL);
+	Compilation_check(comp);
+	Compilation_emitC(comp, name);
+	result->code = Emitter_text(&result->length);
+
+	Diagnostic_release(&trap);
+	Compilation_kill(comp);
+	free(name);
+	return 0;
+}
+
+void TeenyTiny_free(TeenyTinyResult *result) {
+	free(result->code);
+	free(result->diagnostics);
+	memset(result, 0, sizeof(TeenyTinyResult));
+}
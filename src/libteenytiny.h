@@ -0,0 +1,35 @@
+#ifndef LIBTEENYTINY_H
+#define LIBTEENYTINY_H
+
+#include <stddef.h>
+#include "diagnostic.h"
+
+// The compiler as a library, built with make lib into libteenytiny.a. It
+// compiles source in memory to C in memory, and neither exits nor touches a
+// file. Every call has its own state, so calls on different threads may run
+// at the same time.
+
+typedef struct TeenyTinyOptions {
+	// run a program that reads no input while compiling and keep its output
+	int evaluate;
+	// count and time every statement, as --profile
+	int profile;
+	// the file #line directives name, or NULL for none
+	const char *name;
+} TeenyTinyOptions;
+
+typedef struct TeenyTinyResult {
+	// the C file, NUL terminated, or NULL when compiling failed
+	char *code;
+	size_t length;
+	// compiling stops at the first error, so there is at most one for now
+	Diagnostic *diagnostics;
+	int diagnosticCount;
+} TeenyTinyResult;
+
+// returns 0 when the code was generated, 1 when there are diagnostics
+int TeenyTiny_compile(const char *source, size_t length, const TeenyTinyOptions *options, TeenyTinyResult *result);
+
+void TeenyTiny_free(TeenyTinyResult *result);
+
+#endif
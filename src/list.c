@@ -1,19 +1,25 @@
 #include "list.h"
 #include "dbg.h"
+#include "mem.h"
 
 List *List_create()
 {
-	return calloc(1, sizeof(List));
+	List *list = calloc(1, sizeof(List));
+	Mem_add(MEM_LISTS, list);
+	return list;
 }
 
 void List_destroy(List *list)
 {
 	LIST_FOREACH(list, first, next, cur) {
 		if (cur->prev) {
+			Mem_remove(MEM_LISTS, cur->prev);
 			free(cur->prev);
 		}
 	}
 
+	Mem_remove(MEM_LISTS, list->last);
+	Mem_remove(MEM_LISTS, list);
 	free(list->last);
 	free(list);
 }
@@ -35,6 +41,7 @@ void List_push(List * list, void *value)
 {
 	ListNode *node = calloc(1, sizeof(ListNode));
 	check_mem(node);
+	Mem_add(MEM_LISTS, node);
 
 	node->value = value;
 
@@ -63,6 +70,7 @@ void List_unshift(List *list, void *value)
 {
 	ListNode *node = calloc(1, sizeof(ListNode));
 	check_mem(node);
+	Mem_add(MEM_LISTS, node);
 
 	node->value = value;
 
@@ -116,6 +124,7 @@ void *List_remove(List *list, ListNode *node)
 
 	list->count--;
 	result = node->value;
+	Mem_remove(MEM_LISTS, node);
 	free(node);
 
 error:
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include "mem.h"
+
+static const char *Mem_names[MEM_CATEGORIES] = {
+	[MEM_TOKENS] = "tokens", [MEM_AST] = "AST nodes", [MEM_LISTS] = "list nodes",
+	[MEM_SYMBOLS] = "symbols", [MEM_EMITTER] = "emitter buffers", [MEM_IR] = "IR"
+};
+
+static int enabled = 0;
+static MemCount counts[MEM_CATEGORIES];
+static MemCount all;
+
+void Mem_enable() {
+	enabled = 1;
+}
+
+static void Mem_count(MemCount *count, long long size) {
+	if (size > 0) {
+		count->allocs++;
+		count->bytes += size;
+	}
+	count->live += size;
+	if (count->live > count->peak)
+		count->peak = count->live;
+}
+
+void Mem_add(MemCategory category, void *block) {
+	if (!enabled || block == NULL)
+		return;
+	long long size = malloc_usable_size(block);
+	Mem_count(&counts[category], size);
+	Mem_count(&all, size);
+}
+
+void Mem_remove(MemCategory category, void *block) {
+	if (!enabled || block == NULL)
+		return;
+	long long size = malloc_usable_size(block);
+	Mem_count(&counts[category], -size);
+	Mem_count(&all, -size);
+}
+
+// every block counted so far, for bench/micro's allocations per call
+long long Mem_allocations() {
+	return all.allocs;
+}
+
+// live at exit is what the category leaked, as everything has been killed
+// by the time this runs
+void Mem_report(FILE *out) {
+	if (!enabled)
+		return;
+	fflush(stdout);
+	fprintf(out, "%-16s %10s %14s %14s %14s\n", "category", "allocs", "bytes", "peak live", "live at exit");
+	int i;
+	for (i = 0; i < MEM_CATEGORIES; i++)
+		fprintf(out, "%-16s %10lld %14lld %14lld %14lld\n", Mem_names[i], counts[i].allocs, counts[i].bytes, counts[i].peak, counts[i].live);
+	fprintf(out, "%-16s %10lld %14lld %14lld %14lld\n", "total", all.allocs, all.bytes, all.peak, all.live);
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		fprintf(out, "peak RSS %ld kB\n", usage.ru_maxrss);
+}
@@ -0,0 +1,37 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stdio.h>
+
+// --mem-stats: allocations, bytes and peak live bytes of the compiler's
+// structures. Blocks are measured by malloc_usable_size, so a free only has
+// to say what it frees and the counts include malloc's rounding up.
+
+typedef enum MemCategory {
+	MEM_TOKENS,
+	MEM_AST,
+	MEM_LISTS,
+	MEM_SYMBOLS,
+	MEM_EMITTER,
+	MEM_IR,
+	MEM_CATEGORIES
+} MemCategory;
+
+typedef struct MemCount {
+	long long allocs;
+	long long bytes;
+	long long live;
+	long long peak;
+} MemCount;
+
+void Mem_enable();
+
+void Mem_add(MemCategory category, void *block);
+
+void Mem_remove(MemCategory category, void *block);
+
+long long Mem_allocations();
+
+void Mem_report(FILE *out);
+
+#endif
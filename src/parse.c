@@ -2,22 +2,37 @@
 #include <string.h>
 #include <stdlib.h>
 #include "parse.h"
+#include "timer.h"
+#include "diagnostic.h"
+
+// the lexer runs a token ahead of the parser, --time-report counts it apart
+static Token *Parser_lex(Lexer *lex) {
+	Timer_begin("lex", NULL, TIMER_TOKEN);
+	Token *token = Lexer_getToken(lex);
+	Timer_end();
+	return token;
+}
 
 Parser *Parser_create(Lexer *lex, AST *ast) {
 	Parser *par = malloc(sizeof(Parser));
 	if (par == NULL) {
-		Lexer_kill(lex);
-		printf("Unable to allocate memory for parser.\n");
-		exit(1);
+		Diagnostic_raise(0, "Unable to allocate memory for parser.");
 	}
 	
 	par->lex = lex;
 	par->ast = ast;
-	par->curToken = Lexer_getToken(lex);
-	par->peekToken = Lexer_getToken(lex);
+	par->curToken = NULL;
+	par->peekToken = NULL;
 	return par;
 }
 
+// reads the first two tokens, apart from Parser_create so that a lexer
+// error in them leaves a parser for its owner to kill
+void Parser_start(Parser *par) {
+	Parser_nextToken(par);
+	Parser_nextToken(par);
+}
+
 void Parser_kill(Parser *par) {
 	if (par == NULL)
 		return;
@@ -31,13 +46,13 @@ void Parser_kill(Parser *par) {
 void Parser_nextToken(Parser *par) {
 	Token_kill(par->curToken);
 	par->curToken = par->peekToken;
-	par->peekToken = Lexer_getToken(par->lex);
+	// cleared first, an error while lexing must not leave it killed twice
+	par->peekToken = NULL;
+	par->peekToken = Parser_lex(par->lex);
 }
 
 void Parser_abort(Parser *par, char *message) {
-	printf("ERROR AT LINE #%d:\n", par->lex->lineNumber);
-	printf("%s\n", message);
-	exit(1);
+	Diagnostic_raise(par->lex->lineNumber, message);
 }	
 
 void Parser_match(Parser *par, TokenType type) {
@@ -66,7 +81,7 @@ void Parser_program(Parser *par) {
 	}
 }
 
-// statement ::= print | if | while | for | label | goto | let | input
+// statement ::= print | if | while | for | label | goto | let | input | array
 ASTNode *Parser_statement(Parser *par) {
 	ASTNode *statement = NULL;
 
@@ -84,6 +99,7 @@ ASTNode *Parser_statement(Parser *par) {
 			break;
 			
 		case FOR:
+		case PARALLEL:
 			statement = Parser_for(par);
 			break;
 
@@ -102,6 +118,10 @@ ASTNode *Parser_statement(Parser *par) {
 		case INPUT:
 			statement = Parser_input(par);
 			break;
+
+		case ARRAY:
+			statement = Parser_array(par);
+			break;
 		
 		default:
 			Parser_abort(par, "Invalid statement.");
@@ -188,9 +208,19 @@ ASTNode *Parser_while(Parser *par) {
 	return statement;
 }
 
-// for ::= "FOR" ["INT" || "FLOAT"] ident "=" expression "TO" expression "REPEAT" nl {statement} "ENDFOR" nl
+// for ::= ["PARALLEL"] "FOR" ["INT" || "FLOAT"] ident "=" expression "TO" expression ["REDUCE" ident {ident}] "REPEAT" nl {statement} "ENDFOR" nl
+// a PARALLEL FOR is a FOR with the subType PARALLEL, its REDUCE variables are
+// children of its loop variable, only it may have them
 ASTNode *Parser_for(Parser *par) {
+	int parallel = par->curToken->type == PARALLEL;
+	if (parallel) {
+		Parser_nextToken(par);
+		if (par->curToken->type != FOR)
+			Parser_abort(par, "PARALLEL has to be followed by FOR.");
+	}
 	ASTNode *statement = ASTNode_create(par->curToken);
+	if (parallel)
+		statement->subType = PARALLEL;
 	Parser_nextToken(par);
 
 	TokenType variable = Parser_variable(par);
@@ -212,13 +242,25 @@ ASTNode *Parser_for(Parser *par) {
 		}
 	}
 
-	ASTNode_add(statement, ASTNode_create(par->curToken));
+	ASTNode *ident = ASTNode_create(par->curToken);
+	ASTNode_add(statement, ident);
 	Parser_match(par, IDENT);
 	Parser_match(par, EQ);
 	ASTNode_add(statement, Parser_expression(par));
 
 	Parser_match(par, TO);
 	ASTNode_add(statement, Parser_expression(par));
+	if (par->curToken->type == REDUCE) {
+		if (!parallel)
+			Parser_abort(par, "REDUCE can only be used in a PARALLEL FOR.");
+		Parser_nextToken(par);
+		do {
+			if (par->curToken->type == IDENT && !AST_seenSymbol(par->ast, par->curToken->text))
+				Parser_abort(par, "Attempted to REDUCE a variable that was never declared.");
+			ASTNode_add(ident, ASTNode_create(par->curToken));
+			Parser_match(par, IDENT);
+		} while (par->curToken->type == IDENT);
+	}
 	Parser_match(par, REPEAT);
 	Parser_nl(par);
 
@@ -257,7 +299,7 @@ ASTNode *Parser_goto(Parser *par) {
 	return statement;
 }
 
-// let ::= "LET" variable ident "=" comparison nl
+// let ::= "LET" variable ident [index] "=" comparison nl
 ASTNode *Parser_let(Parser *par) {
 	ASTNode *statement = ASTNode_create(par->curToken);
 	Parser_nextToken(par);
@@ -276,15 +318,17 @@ ASTNode *Parser_let(Parser *par) {
 		}
 	}
 
-	ASTNode_add(statement, ASTNode_create(par->curToken));
+	ASTNode *ident = ASTNode_create(par->curToken);
+	ASTNode_add(statement, ident);
 	Parser_match(par, IDENT);
+	Parser_index(par, ident);
 	Parser_match(par, EQ);
 	ASTNode_add(statement, Parser_comparison(par));
 
 	return statement;
 }
 
-// input ::= "INPUT" variable ident nl
+// input ::= "INPUT" variable ident [index] nl
 ASTNode *Parser_input(Parser *par) {
 	ASTNode *statement = ASTNode_create(par->curToken);
 	Parser_nextToken(par);
@@ -303,12 +347,55 @@ ASTNode *Parser_input(Parser *par) {
 		}
 	}
 
-	ASTNode_add(statement, ASTNode_create(par->curToken));
+	ASTNode *ident = ASTNode_create(par->curToken);
+	ASTNode_add(statement, ident);
+	Parser_match(par, IDENT);
+	Parser_index(par, ident);
+
+	return statement;
+}
+
+// array ::= "ARRAY" ("INT" | "FLOAT") ident "[" number "]" nl
+ASTNode *Parser_array(Parser *par) {
+	ASTNode *statement = ASTNode_create(par->curToken);
+	Parser_nextToken(par);
+
+	TokenType variable = Parser_variable(par);
+	if (variable != INT_VAR && variable != FLOAT_VAR)
+		Parser_abort(par, "Arrays can only hold INT or FLOAT.");
+	if (AST_seenSymbol(par->ast, par->curToken->text))
+		Parser_abort(par, "Attemped to declare a variable that was previously used.");
+
+	ASTNode *ident = ASTNode_create(par->curToken);
+	ASTNode_add(statement, ident);
 	Parser_match(par, IDENT);
+	Parser_match(par, LEFTBRACKET);
 
+	if (par->curToken->type != NUMBERINT)
+		Parser_abort(par, "Array size must be an integer.");
+	long size = strtol(par->curToken->text, NULL, 10);
+	if (size <= 0 || size > PARSER_MAX_ARRAY)
+		Parser_abort(par, "Array size is out of range.");
+	ASTNode_add(statement, ASTNode_create(par->curToken));
+	Parser_nextToken(par);
+	Parser_match(par, RIGHTBRACKET);
+
+	AST_addArray(par->ast, ident->token->text, variable == INT_VAR ? INT_ARRAY : FLOAT_ARRAY, (int) size);
 	return statement;
 }
 
+// index ::= "[" expression "]", which every use of an array has
+void Parser_index(Parser *par, ASTNode *ident) {
+	TokenType type = AST_getSymbolType(ident->token->text);
+	if (type != INT_ARRAY && type != FLOAT_ARRAY)
+		return;
+	if (par->curToken->type != LEFTBRACKET)
+		Parser_abort(par, "Array used without an index.");
+	Parser_nextToken(par);
+	ASTNode_add(ident, Parser_expression(par));
+	Parser_match(par, RIGHTBRACKET);
+}
+
 // comparison ::= "TRUE" | "FALSE" | (expression {("==" | "!=" | ">" | ">=" | "<" | "<=") expression})
 ASTNode *Parser_comparison(Parser *par) {
 	if (par->curToken->type == TRUE || par->curToken->type == FALSE) {
@@ -360,10 +447,11 @@ ASTNode *Parser_comparison(Parser *par) {
 ASTNode *Parser_expression(Parser *par) {
 	ASTNode *expression = NULL;
 	int paren = 0;
-	Token *parenToken = NULL;
+	// Parser_nextToken frees curToken, and a copy would be lost on an error
+	// inside the parentheses, so the node is made from this one
+	Token parenToken = { "(", LEFTPAREN };
 	if (par->curToken->type == LEFTPAREN) {
 		paren = 1;
-		parenToken = par->curToken;
 		Parser_nextToken(par);
 	}
 
@@ -380,7 +468,7 @@ ASTNode *Parser_expression(Parser *par) {
 
 	if (paren == 1 && par->curToken->type == RIGHTPAREN) {
 		Parser_nextToken(par);
-		ASTNode *paren = ASTNode_create(parenToken);
+		ASTNode *paren = ASTNode_create(&parenToken);
 		List_unshift(expression->children, paren);
 	} else if (paren == 1) {
 		Parser_abort(par, "Missing closing parenthesis.");
@@ -412,11 +500,8 @@ ASTNode *Parser_unary(Parser *par) {
 	if (par->curToken->type == PLUS || par->curToken->type == MINUS) {
 		unary = ASTNode_create(par->curToken);
 
-		Token *zeroToken = malloc(sizeof(Token));
-		zeroToken->text = strdup("0");
-		zeroToken->type = NUMBERINT;
-
-		ASTNode *zeroNode = ASTNode_create(zeroToken);
+		Token zeroToken = { "0", NUMBERINT };
+		ASTNode *zeroNode = ASTNode_create(&zeroToken);
 
 		ASTNode_add(unary, zeroNode);
 		Parser_nextToken(par);
@@ -428,7 +513,7 @@ ASTNode *Parser_unary(Parser *par) {
 	return unary;
 }
 
-// primary ::= number | string | ident
+// primary ::= number | string | ident [index]
 ASTNode *Parser_primary(Parser *par) {
 	ASTNode *primary = ASTNode_create(par->curToken);
 
@@ -439,6 +524,7 @@ ASTNode *Parser_primary(Parser *par) {
 			Parser_abort(par, "Referenced variable before assignment.");
 		}
 		Parser_nextToken(par);
+		Parser_index(par, primary);
 	} else {
 		Parser_abort(par, "Unexpected token in primary.");
 	}
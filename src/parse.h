@@ -6,6 +6,9 @@
 #include "ast.h"
 #include "emit.h"
 
+// arrays are static in the generated C, keep them well clear of 2GB
+#define PARSER_MAX_ARRAY (1 << 26)
+
 typedef struct Parser {
 	Lexer *lex;
 	AST *ast;
@@ -15,6 +18,8 @@ typedef struct Parser {
 
 Parser *Parser_create(Lexer *lex, AST *ast);
 
+void Parser_start(Parser *par);
+
 void Parser_kill(Parser *par);
 
 void Parser_nextToken(Parser *par);
@@ -43,6 +48,10 @@ ASTNode *Parser_let(Parser *par);
 
 ASTNode *Parser_input(Parser *par);
 
+ASTNode *Parser_array(Parser *par);
+
+void Parser_index(Parser *par, ASTNode *ident);
+
 ASTNode *Parser_comparison(Parser *par);
 
 ASTNode *Parser_expression(Parser *par);
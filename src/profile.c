@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+
+Profile *Profile_read(char *path) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		printf("Profile could not be opened.\n");
+		exit(1);
+	}
+	Profile *profile = calloc(1, sizeof(Profile));
+	if (profile == NULL) {
+		printf("Unable to allocate memory for the profile.\n");
+		exit(1);
+	}
+
+	char text[256];
+	while (fgets(text, sizeof(text), file) != NULL) {
+		if (text[0] == '#' || text[0] == '\n')
+			continue;
+		int line;
+		char kind[16];
+		unsigned long long hits;
+		unsigned long long cycles;
+		double share;
+		unsigned long long trips;
+		if (sscanf(text, "%d %15s %llu %llu %lf %llu", &line, kind, &hits, &cycles, &share, &trips) != 6 || line <= 0) {
+			printf("%s is not a teenytiny profile.\n", path);
+			exit(1);
+		}
+		if (line >= profile->lineCount) {
+			int count = line * 2;
+			ProfileLine *lines = realloc(profile->lines, sizeof(ProfileLine) * count);
+			if (lines == NULL) {
+				printf("Unable to allocate memory for the profile.\n");
+				exit(1);
+			}
+			memset(lines + profile->lineCount, 0, sizeof(ProfileLine) * (count - profile->lineCount));
+			profile->lines = lines;
+			profile->lineCount = count;
+		}
+		ProfileLine *entry = &profile->lines[line];
+		strcpy(entry->kind, kind);
+		entry->hits = hits;
+		entry->trips = trips;
+		entry->seen = 1;
+	}
+	fclose(file);
+	return profile;
+}
+
+void Profile_kill(Profile *profile) {
+	if (profile == NULL)
+		return;
+	free(profile->lines);
+	free(profile);
+}
+
+// the counts recorded for this statement, NULL if there are none
+ProfileLine *Profile_line(Profile *profile, ASTNode *statement) {
+	if (profile == NULL || statement->lineNumber >= profile->lineCount)
+		return NULL;
+	ProfileLine *entry = &profile->lines[statement->lineNumber];
+	if (!entry->seen || strcmp(entry->kind, statement->token->text) != 0)
+		return NULL;
+	return entry;
+}
@@ -0,0 +1,29 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "ast.h"
+
+// A report written by a --profile build, read back to guide the next
+// compile. Counts are looked up by the statement's line and only trusted
+// when the keyword recorded there still matches, so an edited source
+// degrades to no guidance instead of wrong guidance.
+
+typedef struct ProfileLine {
+	char kind[16];
+	unsigned long long hits;
+	unsigned long long trips;
+	int seen;
+} ProfileLine;
+
+typedef struct Profile {
+	ProfileLine *lines;
+	int lineCount;
+} Profile;
+
+Profile *Profile_read(char *path);
+
+void Profile_kill(Profile *profile);
+
+ProfileLine *Profile_line(Profile *profile, ASTNode *statement);
+
+#endif
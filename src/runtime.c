@@ -0,0 +1,701 @@
+#include <stdio.h>
+#include "runtime.h"
+#include "emit.h"
+
+static const char *includes[] = {
+	"#include <stdio.h>",
+	"#include <stdlib.h>",
+	"#include <string.h>",
+	"#include <unistd.h>",
+	""
+};
+
+// PRINT goes through a private buffer instead of printf, so numbers are
+// formatted by hand and stdout is only touched when the buffer fills, before
+// INPUT and at exit.
+static const char *output[] = {
+	"#define TT_OUT_SIZE (1 << 16)",
+	"static char tt_out[TT_OUT_SIZE];",
+	"static size_t tt_outLen = 0;",
+	"",
+	"static void tt_flush(void) {",
+	"	fwrite(tt_out, 1, tt_outLen, stdout);",
+	"	fflush(stdout);",
+	"	tt_outLen = 0;",
+	"}",
+	"",
+	"static inline void tt_write(const char *s, size_t n) {",
+	"	if (n > TT_OUT_SIZE - tt_outLen) {",
+	"		tt_flush();",
+	"		if (n > TT_OUT_SIZE) {",
+	"			fwrite(s, 1, n, stdout);",
+	"			return;",
+	"		}",
+	"	}",
+	"	memcpy(tt_out + tt_outLen, s, n);",
+	"	tt_outLen += n;",
+	"}",
+	"",
+	"static inline void tt_print_int(int v) {",
+	"	char text[16];",
+	"	char *p = text + sizeof(text);",
+	"	unsigned int u = v < 0 ? 0u - (unsigned int) v : (unsigned int) v;",
+	"	*--p = '\\n';",
+	"	do {",
+	"		*--p = (char) ('0' + u % 10);",
+	"		u /= 10;",
+	"	} while (u != 0);",
+	"	if (v < 0)",
+	"		*--p = '-';",
+	"	tt_write(p, (size_t) (text + sizeof(text) - p));",
+	"}",
+	"",
+	"// same digits as printf(\"%.2f\\n\"). Anything that fits in a float times",
+	"// 100 is exact in a double, so rounding half to even by hand matches libc.",
+	"static inline void tt_print_float(double v) {",
+	"	char text[32];",
+	"	double m = v < 0 ? -v : v;",
+	"	if (m != m || m > 1e15 || (double) (float) v != v) {",
+	"		char big[320];",
+	"		int n = snprintf(big, sizeof(big), \"%.2f\\n\", v);",
+	"		tt_write(big, (size_t) n);",
+	"		return;",
+	"	}",
+	"	m *= 100;",
+	"	unsigned long long q = (unsigned long long) m;",
+	"	double frac = m - (double) q;",
+	"	if (frac > 0.5 || (frac == 0.5 && (q & 1)))",
+	"		q++;",
+	"	char *p = text + sizeof(text);",
+	"	*--p = '\\n';",
+	"	*--p = (char) ('0' + q % 10);",
+	"	*--p = (char) ('0' + q / 10 % 10);",
+	"	*--p = '.';",
+	"	q /= 100;",
+	"	do {",
+	"		*--p = (char) ('0' + q % 10);",
+	"		q /= 10;",
+	"	} while (q != 0);",
+	"	if (v < 0 || (v == 0 && 1 / v < 0))",
+	"		*--p = '-';",
+	"	tt_write(p, (size_t) (text + sizeof(text) - p));",
+	"}",
+	"",
+	"static inline void tt_print_bool(int v) {",
+	"	if (v == 0)",
+	"		tt_write(\"FALSE\\n\", 6);",
+	"	else",
+	"		tt_write(\"TRUE\\n\", 5);",
+	"}",
+	""
+};
+
+// INPUT reads stdin in large blocks and parses numbers by hand, which keeps
+// it independent of the locale and much faster than scanf.
+static const char *input[] = {
+	"#define TT_IN_SIZE (1 << 16)",
+	"static char tt_in[TT_IN_SIZE];",
+	"static size_t tt_inPos = 0;",
+	"static size_t tt_inLen = 0;",
+	"// set when a number was read and the rest of its line is still unread",
+	"static int tt_inMidLine = 0;",
+	"",
+	"// the next byte of stdin without consuming it, -1 at the end of input",
+	"static inline int tt_in_peek(void) {",
+	"	if (tt_inPos == tt_inLen) {",
+	"		// prompts have to be on screen before we wait on the user",
+	"		tt_flush();",
+	"		ssize_t n = read(0, tt_in, TT_IN_SIZE);",
+	"		if (n <= 0)",
+	"			return -1;",
+	"		tt_inPos = 0;",
+	"		tt_inLen = (size_t) n;",
+	"	}",
+	"	return (unsigned char) tt_in[tt_inPos];",
+	"}",
+	"",
+	"static inline int tt_in_isSpace(int c) {",
+	"	return c == ' ' || c == '\\n' || c == '\\t' || c == '\\r' || c == '\\v' || c == '\\f';",
+	"}",
+	"",
+	"// skips whitespace, returns 0 if only the end of input is left",
+	"static inline int tt_in_skipSpace(void) {",
+	"	int c;",
+	"	while ((c = tt_in_peek()) != -1 && tt_in_isSpace(c))",
+	"		tt_inPos++;",
+	"	return c != -1;",
+	"}",
+	"",
+	"// bad input becomes 0 and the offending word is thrown away",
+	"static void tt_in_bad(void) {",
+	"	int c;",
+	"	while ((c = tt_in_peek()) != -1 && !tt_in_isSpace(c))",
+	"		tt_inPos++;",
+	"}",
+	"",
+	"static inline void tt_input_int(int *v) {",
+	"	if (!tt_in_skipSpace())",
+	"		return;",
+	"	tt_inMidLine = 1;",
+	"	int negative = 0;",
+	"	int c = tt_in_peek();",
+	"	if (c == '-' || c == '+') {",
+	"		negative = c == '-';",
+	"		tt_inPos++;",
+	"	}",
+	"	unsigned int u = 0;",
+	"	int digits = 0;",
+	"	while ((c = tt_in_peek()) >= '0' && c <= '9') {",
+	"		u = u * 10 + (unsigned int) (c - '0');",
+	"		digits++;",
+	"		tt_inPos++;",
+	"	}",
+	"	if (digits == 0) {",
+	"		*v = 0;",
+	"		tt_in_bad();",
+	"		return;",
+	"	}",
+	"	*v = (int) (negative ? 0u - u : u);",
+	"}",
+	"",
+	"// how much of word, lower case, the input goes on with in any case",
+	"static inline int tt_in_word(const char *word) {",
+	"	int i;",
+	"	for (i = 0; word[i] != '\\0'; i++) {",
+	"		int c = tt_in_peek();",
+	"		if (c == -1 || (c | 0x20) != word[i])",
+	"			break;",
+	"		tt_inPos++;",
+	"	}",
+	"	return i;",
+	"}",
+	"",
+	"static inline void tt_input_float(float *v) {",
+	"	static const double powers[] = {",
+	"		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,",
+	"		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22",
+	"	};",
+	"	if (!tt_in_skipSpace())",
+	"		return;",
+	"	tt_inMidLine = 1;",
+	"	int negative = 0;",
+	"	int c = tt_in_peek();",
+	"	if (c == '-' || c == '+') {",
+	"		negative = c == '-';",
+	"		tt_inPos++;",
+	"	}",
+	"	// nan, inf and infinity, in any case, as scanf took them",
+	"	if ((c = tt_in_peek() | 0x20) == 'n' || c == 'i') {",
+	"		if (c == 'n' ? tt_in_word(\"nan\") != 3 : tt_in_word(\"inf\") != 3) {",
+	"			*v = 0;",
+	"			tt_in_bad();",
+	"			return;",
+	"		}",
+	"		if (c == 'i')",
+	"			tt_in_word(\"inity\");",
+	"		float special = c == 'n' ? __builtin_nanf(\"\") : __builtin_inff();",
+	"		*v = negative ? -special : special;",
+	"		return;",
+	"	}",
+	"	// up to 19 significant digits are kept, the rest only move the exponent",
+	"	unsigned long long mantissa = 0;",
+	"	int significant = 0;",
+	"	int exponent = 0;",
+	"	int digits = 0;",
+	"	while ((c = tt_in_peek()) >= '0' && c <= '9') {",
+	"		if (significant < 19) {",
+	"			mantissa = mantissa * 10 + (unsigned long long) (c - '0');",
+	"			if (mantissa != 0)",
+	"				significant++;",
+	"		} else {",
+	"			exponent++;",
+	"		}",
+	"		digits++;",
+	"		tt_inPos++;",
+	"	}",
+	"	if (c == '.') {",
+	"		tt_inPos++;",
+	"		while ((c = tt_in_peek()) >= '0' && c <= '9') {",
+	"			if (significant < 19) {",
+	"				mantissa = mantissa * 10 + (unsigned long long) (c - '0');",
+	"				if (mantissa != 0)",
+	"					significant++;",
+	"				exponent--;",
+	"			}",
+	"			digits++;",
+	"			tt_inPos++;",
+	"		}",
+	"	}",
+	"	if (digits == 0) {",
+	"		*v = 0;",
+	"		tt_in_bad();",
+	"		return;",
+	"	}",
+	"	if (c == 'e' || c == 'E') {",
+	"		tt_inPos++;",
+	"		int expNegative = 0;",
+	"		int e = 0;",
+	"		c = tt_in_peek();",
+	"		if (c == '-' || c == '+') {",
+	"			expNegative = c == '-';",
+	"			tt_inPos++;",
+	"		}",
+	"		while ((c = tt_in_peek()) >= '0' && c <= '9') {",
+	"			if (e < 10000)",
+	"				e = e * 10 + (c - '0');",
+	"			tt_inPos++;",
+	"		}",
+	"		exponent += expNegative ? -e : e;",
+	"	}",
+	"	double value = (double) mantissa;",
+	"	while (exponent > 22) {",
+	"		value *= 1e22;",
+	"		exponent -= 22;",
+	"	}",
+	"	while (exponent < -22) {",
+	"		value /= 1e22;",
+	"		exponent += 22;",
+	"	}",
+	"	value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];",
+	"	*v = (float) (negative ? -value : value);",
+	"}",
+};
+
+// STRING variables own a buffer that is reused across assignments. ptr is
+// either that buffer or an entry of the literal pool, so assigning a literal
+// never touches the heap. hash is only known (non-zero) for pooled literals
+// and their copies.
+static const char *strings[] = {
+	"typedef struct tt_str {",
+	"	const char *ptr;",
+	"	size_t len;",
+	"	char *buf;",
+	"	size_t cap;",
+	"	unsigned int hash;",
+	"} tt_str;",
+	"",
+	"#define TT_STR_INIT { \"\", 0, NULL, 0, 0 }",
+	"",
+	"static void tt_oom(void) {",
+	"	tt_flush();",
+	"	fputs(\"out of memory\\n\", stderr);",
+	"	exit(1);",
+	"}",
+	"",
+	"// room for n characters plus the terminator, old contents are dropped",
+	"static inline void tt_str_grow(tt_str *s, size_t n) {",
+	"	if (n < s->cap)",
+	"		return;",
+	"	size_t cap = s->cap < 16 ? 16 : s->cap;",
+	"	while (cap <= n)",
+	"		cap *= 2;",
+	"	free(s->buf);",
+	"	s->buf = malloc(cap);",
+	"	if (s->buf == NULL)",
+	"		tt_oom();",
+	"	s->cap = cap;",
+	"}",
+	"",
+	"// room for n characters plus the terminator, old contents are kept",
+	"static inline void tt_str_reserve(tt_str *s, size_t n) {",
+	"	if (n < s->cap)",
+	"		return;",
+	"	size_t cap = s->cap < 16 ? 16 : s->cap;",
+	"	while (cap <= n)",
+	"		cap *= 2;",
+	"	char *buf = realloc(s->buf, cap);",
+	"	if (buf == NULL)",
+	"		tt_oom();",
+	"	s->buf = buf;",
+	"	s->cap = cap;",
+	"}",
+	"",
+	"static inline void tt_str_set(tt_str *dst, tt_str src) {",
+	"	if (dst->ptr == src.ptr && dst->len == src.len)",
+	"		return;",
+	"	if (src.ptr != src.buf) {",
+	"		// a literal, share it instead of copying",
+	"		dst->ptr = src.ptr;",
+	"		dst->len = src.len;",
+	"		dst->hash = src.hash;",
+	"		return;",
+	"	}",
+	"	tt_str_grow(dst, src.len);",
+	"	memcpy(dst->buf, src.ptr, src.len);",
+	"	dst->buf[src.len] = '\\0';",
+	"	dst->ptr = dst->buf;",
+	"	dst->len = src.len;",
+	"	dst->hash = src.hash;",
+	"}",
+	"",
+	"// dst = parts[0] + ... + parts[n-1] with a single sized allocation. When",
+	"// parts[0] is dst itself the new parts are appended in place, so LET s =",
+	"// s + x in a loop is amortized linear thanks to the geometric growth.",
+	"static inline tt_str tt_str_cat(tt_str *dst, const tt_str *parts, int n) {",
+	"	size_t len = 0;",
+	"	size_t at = 0;",
+	"	int first = 0;",
+	"	int alias = 0;",
+	"	int i;",
+	"	for (i = 0; i < n; i++)",
+	"		len += parts[i].len;",
+	"	if (dst->ptr == dst->buf && parts[0].ptr == dst->buf && parts[0].len == dst->len) {",
+	"		first = 1;",
+	"		at = dst->len;",
+	"	}",
+	"	for (i = first; i < n; i++) {",
+	"		if (parts[i].ptr == dst->buf)",
+	"			alias = 1;",
+	"	}",
+	"	if (alias) {",
+	"		// dst is read again further along, build into a fresh buffer",
+	"		tt_str fresh = TT_STR_INIT;",
+	"		tt_str_grow(&fresh, len);",
+	"		at = 0;",
+	"		for (i = 0; i < n; i++) {",
+	"			memcpy(fresh.buf + at, parts[i].ptr, parts[i].len);",
+	"			at += parts[i].len;",
+	"		}",
+	"		free(dst->buf);",
+	"		dst->buf = fresh.buf;",
+	"		dst->cap = fresh.cap;",
+	"	} else {",
+	"		if (first)",
+	"			tt_str_reserve(dst, len);",
+	"		else",
+	"			tt_str_grow(dst, len);",
+	"		for (i = first; i < n; i++) {",
+	"			memcpy(dst->buf + at, parts[i].ptr, parts[i].len);",
+	"			at += parts[i].len;",
+	"		}",
+	"	}",
+	"	dst->buf[len] = '\\0';",
+	"	dst->ptr = dst->buf;",
+	"	dst->len = len;",
+	"	dst->hash = 0;",
+	"	return *dst;",
+	"}",
+	"",
+	"// length and hash reject, identity accepts, bytes are compared last",
+	"static inline int tt_str_eq(tt_str a, tt_str b) {",
+	"	if (a.len != b.len)",
+	"		return 0;",
+	"	if (a.ptr == b.ptr)",
+	"		return 1;",
+	"	if (a.hash != 0 && b.hash != 0 && a.hash != b.hash)",
+	"		return 0;",
+	"	return memcmp(a.ptr, b.ptr, a.len) == 0;",
+	"}",
+	"",
+	"static inline void tt_print_str(tt_str s) {",
+	"	tt_write(s.ptr, s.len);",
+	"	tt_write(\"\\n\", 1);",
+	"}",
+	""
+};
+
+static const char *stringInput[] = {
+	"// reads the next line without its newline, reusing the variable's buffer",
+	"static inline void tt_str_input(tt_str *s) {",
+	"	int c;",
+	"	if (tt_inMidLine) {",
+	"		// throw away what is left of the line the last number came from",
+	"		while ((c = tt_in_peek()) != -1) {",
+	"			tt_inPos++;",
+	"			if (c == '\\n')",
+	"				break;",
+	"		}",
+	"		tt_inMidLine = 0;",
+	"	}",
+	"	if (tt_in_peek() == -1) {",
+	"		s->ptr = \"\";",
+	"		s->len = 0;",
+	"		s->hash = 0;",
+	"		return;",
+	"	}",
+	"	size_t len = 0;",
+	"	while (tt_in_peek() != -1) {",
+	"		char *start = tt_in + tt_inPos;",
+	"		char *end = memchr(start, '\\n', tt_inLen - tt_inPos);",
+	"		size_t n = end != NULL ? (size_t) (end - start) : tt_inLen - tt_inPos;",
+	"		tt_str_reserve(s, len + n);",
+	"		memcpy(s->buf + len, start, n);",
+	"		len += n;",
+	"		tt_inPos += n;",
+	"		if (end != NULL) {",
+	"			tt_inPos++;",
+	"			break;",
+	"		}",
+	"	}",
+	"	tt_str_reserve(s, len);",
+	"	s->buf[len] = '\\0';",
+	"	s->ptr = s->buf;",
+	"	s->len = len;",
+	"	s->hash = 0;",
+	"}",
+};
+
+// reached only through a bounds check the compiler could not prove away
+static const char *arrays[] = {
+	"__attribute__((noreturn, cold)) static void tt_bounds(int line) {",
+	"	tt_flush();",
+	"	printf(\"ERROR AT LINE #%d:\\nArray index out of bounds.\\n\", line);",
+	"	exit(1);",
+	"}",
+	"",
+};
+
+// --profile: TT_PROF_SLOTS, tt_prof_lines and tt_prof_kinds come from the
+// compiler. Every profiled statement counts its hits and adds up the cycles
+// from its start to its end, loops and IF arms also count how often their
+// body was entered. The report is written at exit, to $TT_PROFILE or
+// teenytiny.prof.
+static const char *profile[] = {
+	"#if defined(__x86_64__) || defined(__i386__)",
+	"#include <x86intrin.h>",
+	"#define tt_prof_clock() __rdtsc()",
+	"#else",
+	"#include <time.h>",
+	"static inline unsigned long long tt_prof_clock(void) {",
+	"	struct timespec t;",
+	"	clock_gettime(CLOCK_MONOTONIC, &t);",
+	"	return (unsigned long long) t.tv_sec * 1000000000ull + (unsigned long long) t.tv_nsec;",
+	"}",
+	"#endif",
+	"",
+	"static unsigned long long tt_prof_hits[TT_PROF_SLOTS];",
+	"static unsigned long long tt_prof_cycles[TT_PROF_SLOTS];",
+	"static unsigned long long tt_prof_trips[TT_PROF_SLOTS];",
+	"static unsigned long long tt_prof_start[TT_PROF_SLOTS];",
+	"static unsigned long long tt_prof_begin;",
+	"",
+	"static void tt_prof_write(void) {",
+	"	unsigned long long total = tt_prof_clock() - tt_prof_begin;",
+	"	const char *path = getenv(\"TT_PROFILE\");",
+	"	FILE *f = fopen(path != NULL ? path : \"teenytiny.prof\", \"w\");",
+	"	if (f == NULL)",
+	"		return;",
+	"	fprintf(f, \"# teenytiny profile, %llu cycles in total\\n\", total);",
+	"	fprintf(f, \"#   line kind            hits           cycles  %%time        trips\\n\");",
+	"	int i;",
+	"	for (i = 0; i < TT_PROF_SLOTS; i++) {",
+	"		double share = total == 0 ? 0 : 100.0 * (double) tt_prof_cycles[i] / (double) total;",
+	"		fprintf(f, \"%8d %-7s %12llu %16llu %6.2f %12llu\\n\", tt_prof_lines[i], tt_prof_kinds[i],",
+	"			tt_prof_hits[i], tt_prof_cycles[i], share, tt_prof_trips[i]);",
+	"	}",
+	"	fclose(f);",
+	"}",
+	"",
+};
+
+// PARALLEL FOR: tt_par_run splits the iterations evenly between the workers,
+// each runs its share from the front a grain at a time, and once it is out
+// of work it steals the back half of what another worker has left. A range
+// is two ints in one word, so taking from the front and stealing from the
+// back are each a compare and swap. The workers, $TT_THREADS or one per CPU,
+// are started by the first loop and sleep between loops.
+static const char *parallel[] = {
+	"#include <pthread.h>",
+	"#define TT_PAR_MAX 64",
+	"typedef void (*tt_par_body)(int lo, int hi);",
+	"",
+	"// a worker's range, lo in the high half so a compare and swap takes both",
+	"typedef struct {",
+	"	_Alignas(64) unsigned long long range;",
+	"} tt_par_slot;",
+	"",
+	"static struct {",
+	"	pthread_mutex_t lock;",
+	"	pthread_cond_t start;",
+	"	pthread_cond_t done;",
+	"	int threads;",
+	"	int busy;",
+	"	unsigned long long round;",
+	"	tt_par_body body;",
+	"	long long grain;",
+	"	tt_par_slot slots[TT_PAR_MAX];",
+	"} tt_par = { .lock = PTHREAD_MUTEX_INITIALIZER, .start = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER };",
+	"",
+	"static inline unsigned long long tt_par_pack(long long lo, long long hi) {",
+	"	if (lo > hi)",
+	"		return 1ull << 32;",
+	"	return (unsigned long long) (unsigned int) lo << 32 | (unsigned int) hi;",
+	"}",
+	"",
+	"// the next grain of a worker's own range, from the front",
+	"static int tt_par_take(int self, int *lo, int *hi) {",
+	"	unsigned long long *range = &tt_par.slots[self].range;",
+	"	unsigned long long seen = __atomic_load_n(range, __ATOMIC_ACQUIRE);",
+	"	for (;;) {",
+	"		long long first = (int) (seen >> 32);",
+	"		long long last = (int) seen;",
+	"		if (first > last)",
+	"			return 0;",
+	"		long long end = last - first < tt_par.grain ? last : first + tt_par.grain - 1;",
+	"		if (__atomic_compare_exchange_n(range, &seen, tt_par_pack(end + 1, last), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {",
+	"			*lo = (int) first;",
+	"			*hi = (int) end;",
+	"			return 1;",
+	"		}",
+	"	}",
+	"}",
+	"",
+	"// the back half of another worker's range, all of it when one iteration is left",
+	"static int tt_par_steal(int victim, int *lo, int *hi) {",
+	"	unsigned long long *range = &tt_par.slots[victim].range;",
+	"	unsigned long long seen = __atomic_load_n(range, __ATOMIC_ACQUIRE);",
+	"	for (;;) {",
+	"		long long first = (int) (seen >> 32);",
+	"		long long last = (int) seen;",
+	"		if (first > last)",
+	"			return 0;",
+	"		long long middle = first + (last - first + 1) / 2;",
+	"		if (__atomic_compare_exchange_n(range, &seen, tt_par_pack(first, middle - 1), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {",
+	"			*lo = (int) middle;",
+	"			*hi = (int) last;",
+	"			return 1;",
+	"		}",
+	"	}",
+	"}",
+	"",
+	"// runs its own range, then steals, until a pass over every other worker",
+	"// finds nothing left",
+	"static void tt_par_work(int self) {",
+	"	int lo;",
+	"	int hi;",
+	"	for (;;) {",
+	"		while (tt_par_take(self, &lo, &hi))",
+	"			tt_par.body(lo, hi);",
+	"		int found = 0;",
+	"		int i;",
+	"		for (i = 1; i < tt_par.threads && !found; i++)",
+	"			found = tt_par_steal((self + i) % tt_par.threads, &lo, &hi);",
+	"		if (!found)",
+	"			return;",
+	"		// stolen work goes in its own range, where others can steal from it",
+	"		__atomic_store_n(&tt_par.slots[self].range, tt_par_pack(lo, hi), __ATOMIC_RELEASE);",
+	"	}",
+	"}",
+	"",
+	"static void *tt_par_thread(void *arg) {",
+	"	int self = (int) (long) arg;",
+	"	unsigned long long round = 0;",
+	"	pthread_mutex_lock(&tt_par.lock);",
+	"	for (;;) {",
+	"		while (tt_par.round == round)",
+	"			pthread_cond_wait(&tt_par.start, &tt_par.lock);",
+	"		round = tt_par.round;",
+	"		pthread_mutex_unlock(&tt_par.lock);",
+	"		tt_par_work(self);",
+	"		pthread_mutex_lock(&tt_par.lock);",
+	"		if (--tt_par.busy == 0)",
+	"			pthread_cond_signal(&tt_par.done);",
+	"	}",
+	"	return NULL;",
+	"}",
+	"",
+	"// $TT_THREADS workers, or one per CPU, started by the first loop",
+	"static void tt_par_start(void) {",
+	"	const char *text = getenv(\"TT_THREADS\");",
+	"	int threads = text != NULL ? atoi(text) : 0;",
+	"	if (threads < 1)",
+	"		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);",
+	"	if (threads < 1)",
+	"		threads = 1;",
+	"	if (threads > TT_PAR_MAX)",
+	"		threads = TT_PAR_MAX;",
+	"	pthread_attr_t attr;",
+	"	pthread_attr_init(&attr);",
+	"	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);",
+	"	tt_par.threads = 1;",
+	"	while (tt_par.threads < threads) {",
+	"		pthread_t thread;",
+	"		if (pthread_create(&thread, &attr, tt_par_thread, (void *) (long) tt_par.threads) != 0)",
+	"			break;",
+	"		tt_par.threads++;",
+	"	}",
+	"	pthread_attr_destroy(&attr);",
+	"}",
+	"",
+	"// every iteration from lo to hi, each worker starting on an equal share",
+	"static void tt_par_run(tt_par_body body, int lo, int hi) {",
+	"	if (lo > hi)",
+	"		return;",
+	"	if (tt_par.threads == 0)",
+	"		tt_par_start();",
+	"	long long trips = (long long) hi - lo + 1;",
+	"	int threads = tt_par.threads;",
+	"	if (threads == 1 || trips == 1) {",
+	"		body(lo, hi);",
+	"		return;",
+	"	}",
+	"	tt_par.body = body;",
+	"	tt_par.grain = trips / (threads * 16) > 0 ? trips / (threads * 16) : 1;",
+	"	int i;",
+	"	for (i = 0; i < threads; i++)",
+	"		tt_par.slots[i].range = tt_par_pack(lo + trips * i / threads, lo + trips * (i + 1) / threads - 1);",
+	"	pthread_mutex_lock(&tt_par.lock);",
+	"	tt_par.busy = threads - 1;",
+	"	tt_par.round++;",
+	"	pthread_cond_broadcast(&tt_par.start);",
+	"	pthread_mutex_unlock(&tt_par.lock);",
+	"	tt_par_work(0);",
+	"	pthread_mutex_lock(&tt_par.lock);",
+	"	while (tt_par.busy > 0)",
+	"		pthread_cond_wait(&tt_par.done, &tt_par.lock);",
+	"	pthread_mutex_unlock(&tt_par.lock);",
+	"}",
+	"",
+	"static inline void tt_par_add_int(int *total, int value) {",
+	"	__atomic_fetch_add(total, value, __ATOMIC_RELAXED);",
+	"}",
+	"",
+	"static inline void tt_par_add_float(float *total, float value) {",
+	"	float seen;",
+	"	float sum;",
+	"	__atomic_load(total, &seen, __ATOMIC_RELAXED);",
+	"	do {",
+	"		sum = seen + value;",
+	"	} while (!__atomic_compare_exchange(total, &seen, &sum, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));",
+	"}",
+	"",
+};
+
+void Runtime_emitLines(const char **lines, int count) {
+	int i;
+	for (i = 0; i < count; i++) {
+		Emitter_headerLine((char *) lines[i]);
+	}
+}
+
+void Runtime_emitIncludes() {
+	Runtime_emitLines(includes, sizeof(includes)/sizeof(includes[0]));
+}
+
+void Runtime_emitOutput() {
+	Runtime_emitLines(output, sizeof(output)/sizeof(output[0]));
+}
+
+void Runtime_emitInput() {
+	Runtime_emitLines(input, sizeof(input)/sizeof(input[0]));
+}
+
+void Runtime_emitStrings() {
+	Runtime_emitLines(strings, sizeof(strings)/sizeof(strings[0]));
+}
+
+void Runtime_emitStringInput() {
+	Runtime_emitLines(stringInput, sizeof(stringInput)/sizeof(stringInput[0]));
+}
+
+void Runtime_emitArrays() {
+	Runtime_emitLines(arrays, sizeof(arrays)/sizeof(arrays[0]));
+}
+
+void Runtime_emitProfile() {
+	Runtime_emitLines(profile, sizeof(profile)/sizeof(profile[0]));
+}
+
+void Runtime_emitParallel() {
+	Runtime_emitLines(parallel, sizeof(parallel)/sizeof(parallel[0]));
+}
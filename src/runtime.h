@@ -0,0 +1,25 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+// The runtime is C source that gets written into the header of every
+// generated program, so out.c never needs anything beyond libc.
+
+void Runtime_emitLines(const char **lines, int count);
+
+void Runtime_emitIncludes();
+
+void Runtime_emitOutput();
+
+void Runtime_emitInput();
+
+void Runtime_emitStrings();
+
+void Runtime_emitStringInput();
+
+void Runtime_emitArrays();
+
+void Runtime_emitProfile();
+
+void Runtime_emitParallel();
+
+#endif
@@ -1,55 +1,248 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "ast.h"
-#include "emit.h"
-#include "parse.h"
-#include "lex.h"
-#include "list.h"
+#include <unistd.h>
+#include "compile.h"
+#include "diagnostic.h"
+#include "watch.h"
+#include "timer.h"
+#include "mem.h"
 
-Lexer *lex;
-AST *ast;
-Parser *par;
+// the compilation of a single file, torn down at exit however it ends
+Compilation *single;
+Cache *cache;
+int cacheStats;
+
+// many files, taken one at a time by the workers
+typedef struct Pool {
+	char **paths;
+	char **outputs;
+	int count;
+	int next;
+	int failed;
+	CompileOptions *options;
+} Pool;
+
+// trims the cache to its size once everything was stored
+void finishCache() {
+	if (cache == NULL)
+		return;
+	Cache_evict(cache);
+	if (cacheStats) {
+		fflush(stdout);
+		Cache_report(cache, stderr);
+	}
+	Cache_kill(cache);
+	cache = NULL;
+}
 
 void killAll() {
-	Lexer_kill(lex);
-	AST_kill(ast);
-	Parser_kill(par);
-	Emitter_kill();
+	Timer_begin("killAll", NULL, TIMER_PHASE);
+	Compilation_kill(single);
+	Timer_end();
+	finishCache();
+	Timer_finish();
+	Timer_kill();
+	Mem_report(stderr);
 }
 
-int main(int argc, char *argv[]) {
-	if (argc != 2) {
-		printf("Must give a file to compile.\n");
+// an error in one file is printed and its output removed, the rest of the
+// files still get compiled
+int compileOne(Pool *pool, int i) {
+	// set after setjmp and read after longjmp, so volatile
+	Compilation *volatile comp = NULL;
+	DiagnosticTrap trap;
+	Diagnostic_trap(&trap);
+	if (setjmp(trap.jump) != 0) {
+		Diagnostic_release(&trap);
+		Compilation_kill(comp);
+		if (pool->outputs[i] != NULL)
+			unlink(pool->outputs[i]);
+		// the other workers print too, the path has to stay with the error
+		flockfile(stdout);
+		printf("%s failed:\n", pool->paths[i]);
+		Diagnostic_print(&trap.diagnostic);
+		funlockfile(stdout);
+		return 1;
+	}
+	comp = Compilation_create(pool->paths[i], pool->outputs[i], pool->options);
+	int failed = Compilation_run(comp);
+	Diagnostic_release(&trap);
+	Compilation_kill(comp);
+	return failed;
+}
+
+void *worker(void *arg) {
+	Pool *pool = arg;
+	int i;
+	while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count) {
+		if (compileOne(pool, i) != 0)
+			__atomic_store_n(&pool->failed, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+// every file gets its own output named after it, examples/fibonacci.teeny
+// -> fibonacci.c, or fibonacci with --native
+int compileMany(char **paths, int count, int jobs, CompileOptions *options) {
+	Pool pool = { paths, calloc(count, sizeof(char *)), count, 0, 0, options };
+	char **names = calloc(count, sizeof(char *));
+	if (pool.outputs == NULL || names == NULL) {
+		printf("Unable to allocate memory for the outputs.\n");
 		exit(1);
 	}
-	
-	if (atexit(killAll) != 0) {
-		printf("killAll was not registered as exit function.\n");
+	int i;
+	for (i = 0; i < count; i++) {
+		names[i] = Compilation_name(paths[i]);
+		int j;
+		for (j = 0; j < i; j++) {
+			if (strcmp(names[i], names[j]) == 0) {
+				printf("%s and %s would both be compiled to %s.\n", paths[j], paths[i], names[i]);
+				exit(1);
+			}
+		}
+		if (!options->useNative) {
+			pool.outputs[i] = malloc(strlen(names[i]) + 3);
+			if (pool.outputs[i] == NULL) {
+				printf("Unable to allocate memory for the outputs.\n");
+				exit(1);
+			}
+			sprintf(pool.outputs[i], "%s.c", names[i]);
+		}
+	}
+
+	if (jobs > count)
+		jobs = count;
+	pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+	if (threads == NULL) {
+		printf("Unable to allocate memory for the workers.\n");
 		exit(1);
 	}
+	for (i = 0; i < jobs; i++) {
+		if (pthread_create(&threads[i], NULL, worker, &pool) != 0) {
+			printf("Worker could not be started.\n");
+			exit(1);
+		}
+	}
+	for (i = 0; i < jobs; i++)
+		pthread_join(threads[i], NULL);
 
-	printf("Compiling %s...\n", argv[1]);
+	for (i = 0; i < count; i++) {
+		free(names[i]);
+		free(pool.outputs[i]);
+	}
+	free(names);
+	free(pool.outputs);
+	free(threads);
+	return pool.failed;
+}
 
-	FILE *teenytinyFile = fopen(argv[1], "r");
-	if (teenytinyFile == NULL) {
-		printf("File could not be opened.\n");
-		return 1;
+int main(int argc, char *argv[]) {
+	char **paths = malloc(argc * sizeof(char *));
+	int count = 0;
+	CompileOptions options = { 0, 0, 0, 0, 1, 0, NULL, NULL, NULL, 0 };
+	char *cacheDirectory = NULL;
+	long long cacheSize = CACHE_DEFAULT_SIZE;
+	int timeReport = 0;
+	char *tracePath = NULL;
+	int memStats = 0;
+	int jobs = 0;
+	int watch = 0;
+	int i;
+	if (paths == NULL) {
+		printf("Unable to allocate memory for the file list.\n");
+		exit(1);
+	}
+	for (i = 1; i < argc; i++) {
+		if (i == 1 && strcmp(argv[i], "run") == 0)
+			options.run = 1;
+		else if (strcmp(argv[i], "--native") == 0)
+			options.useNative = 1;
+		else if (strcmp(argv[i], "--jit") == 0)
+			options.jit = 1;
+		else if (strcmp(argv[i], "--dump-ir") == 0)
+			options.dumpIR = 1;
+		else if (strcmp(argv[i], "--no-eval") == 0)
+			options.evaluate = 0;
+		else if (strcmp(argv[i], "--profile") == 0)
+			options.profile = 1;
+		else if (strcmp(argv[i], "--use-profile") == 0 && i + 1 < argc)
+			options.guidePath = argv[++i];
+		else if (strcmp(argv[i], "--mem-stats") == 0)
+			memStats = 1;
+		else if (strcmp(argv[i], "--time-report") == 0)
+			timeReport = 1;
+		else if (strncmp(argv[i], "--trace=", 8) == 0 && argv[i][8] != '\0')
+			tracePath = argv[i] + 8;
+		else if (strncmp(argv[i], "--cache=", 8) == 0 && argv[i][8] != '\0')
+			cacheDirectory = argv[i] + 8;
+		else if (strncmp(argv[i], "--cache-size=", 13) == 0) {
+			char *end;
+			cacheSize = strtoll(argv[i] + 13, &end, 10) << 20;
+			if (end == argv[i] + 13 || *end != '\0' || cacheSize < 0) {
+				printf("--cache-size takes megabytes.\n");
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--emit-ast=", 11) == 0 && argv[i][11] != '\0')
+			options.emitAST = argv[i] + 11;
+		else if (strcmp(argv[i], "--from-ast") == 0)
+			options.fromAST = 1;
+		else if (strcmp(argv[i], "--watch") == 0)
+			watch = 1;
+		else if (strcmp(argv[i], "--cache-stats") == 0)
+			cacheStats = 1;
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			jobs = atoi(argv[++i]);
+		else
+			paths[count++] = argv[i];
+	}
+	if (count == 0) {
+		printf("Must give a file to compile.\n");
+		exit(1);
+	}
+	if ((options.profile || options.guidePath != NULL) && (options.useNative || options.run || options.jit)) {
+		printf("--profile and --use-profile only work when compiling to C.\n");
+		exit(1);
+	}
+	// the timer, the allocation counts and the programs being run are
+	// process wide, so they only make sense for a single file
+	if (count > 1 && (options.run || options.jit || options.dumpIR || options.guidePath != NULL || options.emitAST != NULL || memStats || timeReport || tracePath != NULL)) {
+		printf("run, --jit, --dump-ir, --use-profile, --emit-ast, --mem-stats, --time-report and --trace take a single file.\n");
+		exit(1);
 	}
-	lex = Lexer_create(teenytinyFile);
 
-	Emitter_create("out.c");
+	if (watch && (count > 1 || options.fromAST || options.emitAST != NULL || options.run || options.jit || options.dumpIR || memStats || timeReport || tracePath != NULL)) {
+		printf("--watch takes a single directory and does not run, --jit, --dump-ir, --emit-ast, --from-ast, --mem-stats, --time-report or --trace.\n");
+		exit(1);
+	}
 
-	ast = AST_create(lex);
-	par = Parser_create(lex, ast);
-	
-	Parser_program(par);
+	if (cacheDirectory != NULL)
+		options.cache = cache = Cache_create(cacheDirectory, cacheSize);
+	if (watch)
+		return Watch_run(paths[0], &options);
 
-	AST_check(ast);
+	if (count > 1) {
+		if (jobs <= 0)
+			jobs = sysconf(_SC_NPROCESSORS_ONLN);
+		int failed = compileMany(paths, count, jobs < 1 ? 1 : jobs, &options);
+		free(paths);
+		finishCache();
+		return failed;
+	}
 
-	AST_emit(ast);
-	Emitter_writeFile();
-	printf("Compiling completed.\n\n");
+	if (memStats)
+		Mem_enable();
+	if (atexit(killAll) != 0) {
+		printf("killAll was not registered as exit function.\n");
+		exit(1);
+	}
+	if (timeReport || tracePath != NULL)
+		Timer_create(timeReport, tracePath);
 
-	return 0;
+	int compileC = !options.useNative && !options.run && !options.jit;
+	single = Compilation_create(paths[0], compileC ? "out.c" : NULL, &options);
+	free(paths);
+	return Compilation_run(single);
 }
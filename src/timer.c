@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timer.h"
+
+static Timer *timer = NULL;
+
+static long long Timer_clock(clockid_t clock) {
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void *Timer_grow(void *array, int *capacity, size_t size) {
+	*capacity = *capacity == 0 ? 64 : *capacity * 2;
+	array = realloc(array, size * *capacity);
+	if (array == NULL) {
+		printf("Unable to allocate memory for the timer.\n");
+		exit(1);
+	}
+	return array;
+}
+
+void Timer_create(int report, char *tracePath) {
+	timer = calloc(1, sizeof(Timer));
+	if (timer == NULL) {
+		printf("Unable to allocate memory for the timer.\n");
+		exit(1);
+	}
+	timer->report = report;
+	timer->tracePath = tracePath;
+	timer->start = Timer_clock(CLOCK_MONOTONIC);
+}
+
+void Timer_kill() {
+	if (timer == NULL)
+		return;
+	int i;
+	for (i = 0; i < timer->totalCount; i++) {
+		free(timer->totals[i]->name);
+		free(timer->totals[i]->detail);
+		free(timer->totals[i]);
+	}
+	free(timer->totals);
+	free(timer->spans);
+	free(timer->events);
+	free(timer);
+	timer = NULL;
+}
+
+// totals are few, so they are found by name in the order first seen
+static TimerTotal *Timer_total(char *name, char *detail, TimerKind kind) {
+	int i;
+	for (i = 0; i < timer->totalCount; i++) {
+		TimerTotal *total = timer->totals[i];
+		if (strcmp(total->name, name) == 0 && (detail == NULL ? total->detail == NULL : total->detail != NULL && strcmp(total->detail, detail) == 0))
+			return total;
+	}
+	if (timer->totalCount == timer->totalCapacity)
+		timer->totals = Timer_grow(timer->totals, &timer->totalCapacity, sizeof(TimerTotal *));
+	TimerTotal *total = calloc(1, sizeof(TimerTotal));
+	if (total == NULL) {
+		printf("Unable to allocate memory for the timer.\n");
+		exit(1);
+	}
+	total->name = strdup(name);
+	total->detail = detail == NULL ? NULL : strdup(detail);
+	total->kind = kind;
+	timer->totals[timer->totalCount++] = total;
+	return total;
+}
+
+void Timer_begin(char *name, char *detail, TimerKind kind) {
+	if (timer == NULL)
+		return;
+	if (timer->depth == timer->spanCapacity)
+		timer->spans = Timer_grow(timer->spans, &timer->spanCapacity, sizeof(TimerSpan));
+	TimerSpan *span = &timer->spans[timer->depth++];
+	span->total = Timer_total(name, detail, kind);
+	span->childWall = 0;
+	span->cpu = kind == TIMER_PHASE ? Timer_clock(CLOCK_PROCESS_CPUTIME_ID) : 0;
+	span->wall = Timer_clock(CLOCK_MONOTONIC);
+}
+
+void Timer_end() {
+	if (timer == NULL || timer->depth == 0)
+		return;
+	long long now = Timer_clock(CLOCK_MONOTONIC);
+	TimerSpan *span = &timer->spans[--timer->depth];
+	TimerTotal *total = span->total;
+	long long wall = now - span->wall;
+	long long cpu = total->kind == TIMER_PHASE ? Timer_clock(CLOCK_PROCESS_CPUTIME_ID) - span->cpu : 0;
+	total->calls++;
+	total->wall += wall;
+	total->selfWall += wall - span->childWall;
+	total->cpu += cpu;
+	if (timer->depth > 0)
+		timer->spans[timer->depth - 1].childWall += wall;
+
+	if (timer->tracePath == NULL || total->kind == TIMER_TOKEN)
+		return;
+	if (timer->eventCount == timer->eventCapacity)
+		timer->events = Timer_grow(timer->events, &timer->eventCapacity, sizeof(TimerEvent));
+	TimerEvent *event = &timer->events[timer->eventCount++];
+	event->total = total;
+	event->start = span->wall - timer->start;
+	event->wall = wall;
+	event->cpu = cpu;
+}
+
+// spans still open when the compiler stops on an error are closed so their
+// time so far shows up, then the report and the trace are written
+void Timer_finish() {
+	if (timer == NULL)
+		return;
+	while (timer->depth > 0)
+		Timer_end();
+	fflush(stdout);
+	if (timer->report)
+		Timer_report(stderr);
+	if (timer->tracePath != NULL)
+		Timer_writeTrace();
+}
+
+static void Timer_name(char *name, size_t size, TimerTotal *total) {
+	if (total->detail == NULL)
+		snprintf(name, size, "%s", total->name);
+	else
+		snprintf(name, size, "%s %s", total->name, total->detail);
+}
+
+void Timer_report(FILE *out) {
+	fprintf(out, "%-28s %8s %11s %11s %11s\n", "phase", "calls", "wall ms", "self ms", "cpu ms");
+	int i;
+	for (i = 0; i < timer->totalCount; i++) {
+		TimerTotal *total = timer->totals[i];
+		char name[64];
+		Timer_name(name, sizeof(name), total);
+		fprintf(out, "%-28s %8lld %11.3f %11.3f", name, total->calls, total->wall / 1e6, total->selfWall / 1e6);
+		if (total->kind == TIMER_PHASE)
+			fprintf(out, " %11.3f\n", total->cpu / 1e6);
+		else
+			fprintf(out, " %11s\n", "-");
+	}
+	fprintf(out, "%-28s %8s %11.3f\n", "total", "", (Timer_clock(CLOCK_MONOTONIC) - timer->start) / 1e6);
+}
+
+// Chrome's trace event format, open it in chrome://tracing or ui.perfetto.dev
+void Timer_writeTrace() {
+	FILE *out = fopen(timer->tracePath, "w");
+	if (out == NULL) {
+		printf("Trace file could not be opened.\n");
+		return;
+	}
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+	int i;
+	for (i = 0; i < timer->eventCount; i++) {
+		TimerEvent *event = &timer->events[i];
+		char name[64];
+		Timer_name(name, sizeof(name), event->total);
+		fputs("{\"name\":\"", out);
+		char *c;
+		for (c = name; *c != '\0'; c++) {
+			if (*c == '"' || *c == '\\')
+				fputc('\\', out);
+			fputc(*c, out);
+		}
+		fprintf(out, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+			event->total->kind == TIMER_PHASE ? "phase" : "statement", event->start / 1e3, event->wall / 1e3);
+		if (event->total->kind == TIMER_PHASE)
+			fprintf(out, ",\"tdur\":%.3f", event->cpu / 1e3);
+		fputs(i + 1 < timer->eventCount ? "},\n" : "}\n", out);
+	}
+	fputs("]}\n", out);
+	fclose(out);
+}
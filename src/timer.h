@@ -0,0 +1,74 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdio.h>
+
+// --time-report and --trace: wall and CPU time of the compiler's phases.
+// Spans nest, every span's time is reported both whole and without the
+// spans it contains, so lexing, which the parser drives one token at a time,
+// comes out separate from parsing. Reading the CPU clock is a system call,
+// so only phases read it and their CPU time is always whole, statements and
+// tokens are timed by the wall clock alone and tokens are too many to each
+// get a trace event.
+
+typedef enum TimerKind {
+	TIMER_PHASE,
+	TIMER_STATEMENT,
+	TIMER_TOKEN
+} TimerKind;
+
+typedef struct TimerTotal {
+	char *name;
+	char *detail;
+	TimerKind kind;
+	long long calls;
+	long long wall;
+	long long selfWall;
+	long long cpu;
+} TimerTotal;
+
+typedef struct TimerSpan {
+	TimerTotal *total;
+	long long wall;
+	long long cpu;
+	// wall time of the spans inside this one
+	long long childWall;
+} TimerSpan;
+
+typedef struct TimerEvent {
+	TimerTotal *total;
+	long long start;
+	long long wall;
+	long long cpu;
+} TimerEvent;
+
+typedef struct Timer {
+	int report;
+	char *tracePath;
+	long long start;
+	TimerTotal **totals;
+	int totalCount;
+	int totalCapacity;
+	TimerSpan *spans;
+	int depth;
+	int spanCapacity;
+	TimerEvent *events;
+	int eventCount;
+	int eventCapacity;
+} Timer;
+
+void Timer_create(int report, char *tracePath);
+
+void Timer_kill();
+
+void Timer_begin(char *name, char *detail, TimerKind kind);
+
+void Timer_end();
+
+void Timer_finish();
+
+void Timer_report(FILE *out);
+
+void Timer_writeTrace();
+
+#endif
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm.h"
+
+#define VM_STRCAT_PARTS 16
+
+// every register starts as it was left by the compiler, string registers
+// point at their slot and literal slots at their text
+static X64String *VM_slots(Bytecode *bc, Value *registers) {
+	X64String *slots = calloc(List_count(bc->slots) + 1, sizeof(X64String));
+	if (slots == NULL) {
+		printf("Unable to allocate memory for the VM.\n");
+		exit(1);
+	}
+	LIST_FOREACH(bc->constants, first, next, cur) {
+		BytecodeConstant *c = (BytecodeConstant *) cur->value;
+		if (c->type != BYTECODE_STRING)
+			continue;
+		X64String *s = &slots[c->slot];
+		s->ptr = c->text == NULL ? "" : c->text;
+		s->len = c->text == NULL ? 0 : strlen(c->text);
+		s->hash = c->text == NULL ? 0 : AST_hashString(c->text);
+		registers[c->reg].s = s;
+	}
+	return slots;
+}
+
+static BytecodeText **VM_texts(Bytecode *bc) {
+	BytecodeText **texts = malloc(sizeof(BytecodeText *) * (List_count(bc->texts) + 1));
+	int count = 0;
+	LIST_FOREACH(bc->texts, first, next, cur) {
+		texts[count++] = (BytecodeText *) cur->value;
+	}
+	return texts;
+}
+
+void VM_run(Bytecode *bc) {
+	static void *dispatch[OP_COUNT] = {
+		[OP_HALT] = &&halt, [OP_MOV] = &&mov,
+		[OP_ADDI] = &&addi, [OP_SUBI] = &&subi, [OP_MULI] = &&muli, [OP_DIVI] = &&divi,
+		[OP_ADDF] = &&addf, [OP_SUBF] = &&subf, [OP_MULF] = &&mulf, [OP_DIVF] = &&divf,
+		[OP_ADDD] = &&addd, [OP_SUBD] = &&subd, [OP_MULD] = &&muld, [OP_DIVD] = &&divd,
+		[OP_ITOF] = &&itof, [OP_ITOD] = &&itod, [OP_FTOD] = &&ftod,
+		[OP_FTOI] = &&ftoi, [OP_DTOI] = &&dtoi, [OP_DTOF] = &&dtof,
+		[OP_TRUTHI] = &&truthi, [OP_TRUTHF] = &&truthf, [OP_TRUTHD] = &&truthd,
+		[OP_LTI] = &&lti, [OP_LEI] = &&lei, [OP_EQI] = &&eqi, [OP_NEI] = &&nei,
+		[OP_LTF] = &&ltf, [OP_LEF] = &&lef, [OP_EQF] = &&eqf, [OP_NEF] = &&nef,
+		[OP_LTD] = &&ltd, [OP_LED] = &&led, [OP_EQD] = &&eqd, [OP_NED] = &&ned,
+		[OP_STREQ] = &&streq, [OP_STRNE] = &&strne,
+		[OP_JMP] = &&jmp, [OP_JZ] = &&jz,
+		[OP_JLTI] = &&jlti, [OP_JLEI] = &&jlei, [OP_JEQI] = &&jeqi, [OP_JNEI] = &&jnei,
+		[OP_JLTF] = &&jltf, [OP_JLEF] = &&jlef, [OP_JEQF] = &&jeqf, [OP_JNEF] = &&jnef,
+		[OP_JLTD] = &&jltd, [OP_JLED] = &&jled, [OP_JEQD] = &&jeqd, [OP_JNED] = &&jned,
+		[OP_FORI] = &&fori, [OP_FORF] = &&forf,
+		[OP_PRINTI] = &&printi, [OP_PRINTF] = &&printfloat, [OP_PRINTD] = &&printd,
+		[OP_PRINTB] = &&printb, [OP_PRINTS] = &&prints,
+		[OP_WRITE] = &&writetext,
+		[OP_INPUTI] = &&inputi, [OP_INPUTF] = &&inputf, [OP_INPUTS] = &&inputs,
+		[OP_STRSET] = &&strset, [OP_STRCAT] = &&concat, [OP_ARGS] = &&args
+	};
+
+	Value *R = malloc(sizeof(Value) * (bc->registerCount + 1));
+	if (R == NULL) {
+		printf("Unable to allocate memory for the VM.\n");
+		exit(1);
+	}
+	memcpy(R, bc->registers, sizeof(Value) * bc->registerCount);
+	X64String *slots = VM_slots(bc, R);
+	BytecodeText **texts = VM_texts(bc);
+	const X64String *parts[VM_STRCAT_PARTS];
+	X64Runtime rt;
+	X64Runtime_init(&rt);
+
+	Instruction *code = bc->code;
+	Instruction *ip = code;
+
+#define NEXT() do { ip++; goto *dispatch[ip->op]; } while (0)
+#define JUMP(target) do { ip = code + (target); goto *dispatch[ip->op]; } while (0)
+#define BINARY(field, op) R[ip->a].field = R[ip->b].field op R[ip->c].field; NEXT()
+#define COMPARE(field, op) R[ip->a].i = R[ip->b].field op R[ip->c].field; NEXT()
+#define BRANCH(field, op) if (R[ip->a].field op R[ip->b].field) NEXT(); JUMP(ip->c)
+
+	goto *dispatch[ip->op];
+
+mov:	R[ip->a] = R[ip->b]; NEXT();
+addi:	BINARY(i, +);
+subi:	BINARY(i, -);
+muli:	BINARY(i, *);
+divi:	BINARY(i, /);
+addf:	BINARY(f, +);
+subf:	BINARY(f, -);
+mulf:	BINARY(f, *);
+divf:	BINARY(f, /);
+addd:	BINARY(d, +);
+subd:	BINARY(d, -);
+muld:	BINARY(d, *);
+divd:	BINARY(d, /);
+itof:	R[ip->a].f = (float) R[ip->b].i; NEXT();
+itod:	R[ip->a].d = (double) R[ip->b].i; NEXT();
+ftod:	R[ip->a].d = (double) R[ip->b].f; NEXT();
+ftoi:	R[ip->a].i = (int) R[ip->b].f; NEXT();
+dtoi:	R[ip->a].i = (int) R[ip->b].d; NEXT();
+dtof:	R[ip->a].f = (float) R[ip->b].d; NEXT();
+truthi:	R[ip->a].i = R[ip->b].i != 0; NEXT();
+truthf:	R[ip->a].i = R[ip->b].f != 0; NEXT();
+truthd:	R[ip->a].i = R[ip->b].d != 0; NEXT();
+lti:	COMPARE(i, <);
+lei:	COMPARE(i, <=);
+eqi:	COMPARE(i, ==);
+nei:	COMPARE(i, !=);
+ltf:	COMPARE(f, <);
+lef:	COMPARE(f, <=);
+eqf:	COMPARE(f, ==);
+nef:	COMPARE(f, !=);
+ltd:	COMPARE(d, <);
+led:	COMPARE(d, <=);
+eqd:	COMPARE(d, ==);
+ned:	COMPARE(d, !=);
+streq:	R[ip->a].i = X64Runtime_strEq(&rt, R[ip->b].s, R[ip->c].s); NEXT();
+strne:	R[ip->a].i = !X64Runtime_strEq(&rt, R[ip->b].s, R[ip->c].s); NEXT();
+jmp:	JUMP(ip->c);
+jz:	if (R[ip->a].i != 0) NEXT(); JUMP(ip->c);
+jlti:	BRANCH(i, <);
+jlei:	BRANCH(i, <=);
+jeqi:	BRANCH(i, ==);
+jnei:	BRANCH(i, !=);
+jltf:	BRANCH(f, <);
+jlef:	BRANCH(f, <=);
+jeqf:	BRANCH(f, ==);
+jnef:	BRANCH(f, !=);
+jltd:	BRANCH(d, <);
+jled:	BRANCH(d, <=);
+jeqd:	BRANCH(d, ==);
+jned:	BRANCH(d, !=);
+fori:	if (++R[ip->a].i <= R[ip->b].i) JUMP(ip->c); NEXT();
+forf:	if ((R[ip->a].f += 1.0f) <= R[ip->b].f) JUMP(ip->c); NEXT();
+printi:	X64Runtime_printInt(&rt, R[ip->a].i); NEXT();
+printfloat:	X64Runtime_printFloat(&rt, R[ip->a].f); NEXT();
+printd:	X64Runtime_printFloat(&rt, R[ip->a].d); NEXT();
+printb:	X64Runtime_printBool(&rt, R[ip->a].i); NEXT();
+prints:	X64Runtime_printStr(&rt, R[ip->a].s); NEXT();
+writetext:	X64Runtime_write(&rt, texts[ip->c]->text, texts[ip->c]->length); NEXT();
+inputi:	X64Runtime_inputInt(&rt, &R[ip->a].i); NEXT();
+inputf:	X64Runtime_inputFloat(&rt, &R[ip->a].f); NEXT();
+inputs:	X64Runtime_strInput(&rt, R[ip->a].s); NEXT();
+strset:	X64Runtime_strSet(&rt, R[ip->a].s, R[ip->b].s); NEXT();
+concat:
+	{
+		int count = ip->c;
+		const X64String **list = count <= VM_STRCAT_PARTS ? parts : malloc(sizeof(X64String *) * count);
+		Instruction *arg = ip + 1;
+		int i;
+		for (i = 0; i < count; i++) {
+			int at = i % 3;
+			list[i] = R[at == 0 ? arg->a : at == 1 ? arg->b : arg->c].s;
+			if (at == 2)
+				arg++;
+		}
+		X64Runtime_strCat(&rt, R[ip->a].s, list, count);
+		if (list != parts)
+			free(list);
+		ip += (count + 2) / 3;
+	}
+	NEXT();
+args:
+	// only ever skipped over by concat
+	NEXT();
+halt:
+	X64Runtime_flush(&rt);
+	free(texts);
+	free(slots);
+	free(R);
+
+#undef NEXT
+#undef JUMP
+#undef BINARY
+#undef COMPARE
+#undef BRANCH
+}
@@ -0,0 +1,11 @@
+#ifndef VM_H
+#define VM_H
+
+#include "bytecode.h"
+
+// Runs bytecode in process. Dispatch is a computed goto per instruction and
+// PRINT, INPUT and strings go through the same runtime as native executables.
+
+void VM_run(Bytecode *bc);
+
+#endif
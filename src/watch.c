@@ -0,0 +1,188 @@
+#include <dirent.h>
+#include <errno.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "watch.h"
+#include "diagnostic.h"
+
+extern char **environ;
+
+static double Watch_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+static int Watch_isTeeny(char *name) {
+	size_t length = strlen(name);
+	return length > 6 && strcmp(name + length - 6, ".teeny") == 0;
+}
+
+static WatchFile *Watch_file(Watch *watch, char *name) {
+	char *path = malloc(strlen(watch->directory) + strlen(name) + 2);
+	if (path == NULL) {
+		printf("Unable to allocate memory for the watched files.\n");
+		exit(1);
+	}
+	sprintf(path, "%s/%s", watch->directory, name);
+	LIST_FOREACH(watch->files, first, next, cur) {
+		WatchFile *file = cur->value;
+		if (strcmp(file->path, path) == 0) {
+			free(path);
+			return file;
+		}
+	}
+	WatchFile *file = calloc(1, sizeof(WatchFile));
+	if (file == NULL) {
+		printf("Unable to allocate memory for the watched files.\n");
+		exit(1);
+	}
+	file->path = path;
+	file->name = Compilation_name(path);
+	List_push(watch->files, file);
+	return file;
+}
+
+// the whole file, NULL when it is gone
+static char *Watch_read(char *path, size_t *length) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return NULL;
+	char *source = NULL;
+	size_t capacity = 0;
+	*length = 0;
+	do {
+		capacity = capacity == 0 ? 4096 : capacity * 2;
+		source = realloc(source, capacity);
+		if (source == NULL) {
+			printf("Unable to allocate memory for the watched files.\n");
+			exit(1);
+		}
+		*length += fread(source + *length, 1, capacity - *length, file);
+	} while (*length == capacity);
+	fclose(file);
+	return source;
+}
+
+// $CC -w name.c -o name -pthread, returns its exit status
+static int Watch_link(Watch *watch, char *output, char *name) {
+	char *argv[] = { watch->cc, "-w", output, "-o", name, "-pthread", NULL };
+	pid_t pid;
+	int status;
+	if (posix_spawnp(&pid, watch->cc, NULL, NULL, argv, environ) != 0) {
+		printf("%s could not be started.\n", watch->cc);
+		return 1;
+	}
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+		;
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+// returns 0 when the executable was written
+static int Watch_compile(Watch *watch, WatchFile *file, char *output) {
+	// set after setjmp and read after longjmp, so volatile
+	Compilation *volatile comp = NULL;
+	DiagnosticTrap trap;
+	Diagnostic_trap(&trap);
+	if (setjmp(trap.jump) != 0) {
+		Diagnostic_release(&trap);
+		Compilation_kill(comp);
+		// the C may already be there, cut short
+		if (output != NULL)
+			unlink(output);
+		Diagnostic_print(&trap.diagnostic);
+		return 1;
+	}
+	comp = Compilation_create(file->path, output, watch->options);
+	int failed = Compilation_run(comp);
+	Diagnostic_release(&trap);
+	Compilation_kill(comp);
+	if (output == NULL)
+		return failed;
+	if (!failed)
+		failed = Watch_link(watch, output, file->name);
+	unlink(output);
+	return failed;
+}
+
+static void Watch_build(Watch *watch, WatchFile *file) {
+	double start = Watch_now();
+	size_t length;
+	char *source = Watch_read(file->path, &length);
+	if (source == NULL)
+		return;
+	if (file->source != NULL && length == file->length && memcmp(source, file->source, length) == 0) {
+		free(source);
+		return;
+	}
+	free(file->source);
+	file->source = source;
+	file->length = length;
+
+	char *output = NULL;
+	if (!watch->options->useNative) {
+		output = malloc(strlen(file->name) + 3);
+		if (output == NULL) {
+			printf("Unable to allocate memory for the watched files.\n");
+			exit(1);
+		}
+		sprintf(output, "%s.c", file->name);
+	}
+	if (Watch_compile(watch, file, output) == 0)
+		printf("%s built in %.1f ms\n\n", file->name, Watch_now() - start);
+	else
+		printf("%s not built\n\n", file->name);
+	// a watch never exits the way that would trim the cache, so every build does
+	if (watch->options->cache != NULL)
+		Cache_evict(watch->options->cache);
+	fflush(stdout);
+	free(output);
+}
+
+int Watch_run(char *directory, CompileOptions *options) {
+	Watch watch = { directory, options, getenv("CC"), List_create() };
+	if (watch.cc == NULL || *watch.cc == '\0')
+		watch.cc = "gcc";
+
+	int fd = inotify_init1(IN_CLOEXEC);
+	// a save is a write closed, or with most editors a file renamed over it
+	if (fd < 0 || inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		printf("%s could not be watched.\n", directory);
+		return 1;
+	}
+
+	DIR *dir = opendir(directory);
+	struct dirent *found;
+	while (dir != NULL && (found = readdir(dir)) != NULL) {
+		if (Watch_isTeeny(found->d_name))
+			Watch_build(&watch, Watch_file(&watch, found->d_name));
+	}
+	if (dir != NULL)
+		closedir(dir);
+	printf("Watching %s for changes.\n", directory);
+	fflush(stdout);
+
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	for (;;) {
+		ssize_t length = read(fd, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR)
+			continue;
+		if (length <= 0)
+			break;
+		char *at = buffer;
+		while (at < buffer + length) {
+			struct inotify_event *event = (struct inotify_event *) at;
+			if (event->len > 0 && Watch_isTeeny(event->name))
+				Watch_build(&watch, Watch_file(&watch, event->name));
+			at += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	printf("Watching %s failed.\n", directory);
+	return 1;
+}
@@ -0,0 +1,33 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stddef.h>
+#include "compile.h"
+#include "list.h"
+
+// --watch dir: builds every .teeny file in dir, then stays running and
+// rebuilds each one as soon as it is saved. The executables go to the
+// current directory, linked by $CC (gcc), or written directly with
+// --native. An error is reported and the file waits for its next save, and
+// a save that changed nothing is not built again.
+
+typedef struct WatchFile {
+	char *path;
+	// examples/fibonacci.teeny -> fibonacci
+	char *name;
+	// as it was last built
+	char *source;
+	size_t length;
+} WatchFile;
+
+typedef struct Watch {
+	char *directory;
+	CompileOptions *options;
+	char *cc;
+	List *files;
+} Watch;
+
+// only returns when watching failed
+int Watch_run(char *directory, CompileOptions *options);
+
+#endif
@@ -0,0 +1,936 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "x64.h"
+#include "diagnostic.h"
+
+// Code generation is a simple stack machine: every expression leaves its
+// value in eax (INT, BOOL), xmm0 (FLOAT as a float, DOUBLE as a double) or
+// rax (a pointer to a string), and binary operators park the left operand
+// on the stack while the right one is evaluated.
+
+// X64_jump kinds, anything else is the second byte of a 0f 8x jcc
+#define X64_JMP 1
+#define X64_JZ 0x84
+
+static void X64_byte(X64Buffer *b, int v) {
+	if (b->length == b->capacity) {
+		b->capacity = b->capacity == 0 ? 4096 : b->capacity * 2;
+		b->bytes = realloc(b->bytes, b->capacity);
+		if (b->bytes == NULL) {
+			Diagnostic_raise(0, "Unable to allocate memory for machine code.");
+		}
+	}
+	b->bytes[b->length++] = (unsigned char) v;
+}
+
+static void X64_int32(X64Buffer *b, int v) {
+	X64_byte(b, v & 0xff);
+	X64_byte(b, (v >> 8) & 0xff);
+	X64_byte(b, (v >> 16) & 0xff);
+	X64_byte(b, (v >> 24) & 0xff);
+}
+
+static void X64_align(X64Buffer *b, int alignment) {
+	while (b->length % alignment != 0)
+		X64_byte(b, 0);
+}
+
+// emits count instruction bytes
+static void X64_emit(X64 *x, int count, ...) {
+	va_list bytes;
+	va_start(bytes, count);
+	int i;
+	for (i = 0; i < count; i++)
+		X64_byte(&x->code, va_arg(bytes, int));
+	va_end(bytes);
+}
+
+// the disp32 of a [rip + disp] operand, trailing is the size of any
+// immediate that still follows it in the instruction
+static void X64_rip(X64 *x, X64Section section, int offset, int trailing) {
+	X64Fixup *f = malloc(sizeof(X64Fixup));
+	f->at = x->code.length;
+	f->end = x->code.length + 4 + trailing;
+	f->section = section;
+	f->offset = offset;
+	List_push(x->fixups, f);
+	X64_int32(&x->code, 0);
+}
+
+// jz or jmp with a rel32 that X64_patch fills in, returns where it is
+static int X64_jump(X64 *x, int kind) {
+	if (kind == X64_JMP)
+		X64_emit(x, 1, 0xe9);
+	else
+		X64_emit(x, 2, 0x0f, kind);
+	int at = x->code.length;
+	X64_int32(&x->code, 0);
+	return at;
+}
+
+static void X64_patch(X64 *x, int at, int target) {
+	int rel = target - (at + 4);
+	memcpy(x->code.bytes + at, &rel, 4);
+}
+
+static void X64_jumpBack(X64 *x, int target) {
+	X64_patch(x, X64_jump(x, X64_JMP), target);
+}
+
+static int X64_double(X64 *x, double value) {
+	X64_align(&x->rodata, 8);
+	int offset = x->rodata.length;
+	unsigned char bytes[8];
+	memcpy(bytes, &value, 8);
+	int i;
+	for (i = 0; i < 8; i++)
+		X64_byte(&x->rodata, bytes[i]);
+	return offset;
+}
+
+static int X64_bss(X64 *x, int size) {
+	x->bssSize = (x->bssSize + 7) & ~7;
+	int offset = x->bssSize;
+	x->bssSize += size;
+	return offset;
+}
+
+X64 *X64_create(AST *ast) {
+	X64 *x = calloc(1, sizeof(X64));
+	if (x == NULL) {
+		Diagnostic_raise(0, "Unable to allocate memory for the native backend.");
+	}
+	x->ast = ast;
+	x->fixups = List_create();
+	x->labels = List_create();
+	x->gotos = List_create();
+	x->variables = List_create();
+	x->literals = List_create();
+	x->strings = List_create();
+
+	// the runtime's state comes first, at offset 0
+	X64_bss(x, sizeof(X64Runtime));
+
+	LIST_FOREACH(ast->symbols, first, next, cur) {
+		Symbol *s = (Symbol *) cur->value;
+		if (AST_isArray(s->type))
+			AST_abort("Arrays are only supported when compiling to C.");
+		X64Variable *v = malloc(sizeof(X64Variable));
+		v->name = strdup(s->text);
+		v->type = s->type;
+		if (s->type == STRING_VAR) {
+			v->offset = X64_string(x);
+		} else {
+			v->offset = X64_bss(x, 8);
+		}
+		List_push(x->variables, v);
+	}
+
+	X64_byte(&x->rodata, 0);
+	x->emptyString = 0;
+	X64_align(&x->rodata, 4);
+	float one = 1.0f;
+	x->one = x->rodata.length;
+	unsigned char bytes[4];
+	memcpy(bytes, &one, 4);
+	int i;
+	for (i = 0; i < 4; i++)
+		X64_byte(&x->rodata, bytes[i]);
+	return x;
+}
+
+// labels, variables and literals all start with a name of their own
+static void X64_killNamed(List *list) {
+	LIST_FOREACH(list, first, next, cur) {
+		free(*(char **) cur->value);
+	}
+	List_clear_destroy(list);
+}
+
+void X64_kill(X64 *x) {
+	if (x == NULL)
+		return;
+	free(x->code.bytes);
+	free(x->rodata.bytes);
+	List_clear_destroy(x->fixups);
+	X64_killNamed(x->labels);
+	X64_killNamed(x->gotos);
+	X64_killNamed(x->variables);
+	X64_killNamed(x->literals);
+	List_clear_destroy(x->strings);
+	free(x);
+}
+
+// literals point into rodata and get their length and hash up front
+static void X64_setupLiterals(X64 *x) {
+	LIST_FOREACH(x->literals, first, next, cur) {
+		X64Literal *l = (X64Literal *) cur->value;
+		// lea rax, [literal text]; mov [string.ptr], rax
+		X64_emit(x, 3, 0x48, 0x8d, 0x05);
+		X64_rip(x, X64_RODATA, l->rodata, 0);
+		X64_emit(x, 3, 0x48, 0x89, 0x05);
+		X64_rip(x, X64_BSS, l->bss, 0);
+		// mov qword [string.len], length; mov dword [string.hash], hash
+		X64_emit(x, 3, 0x48, 0xc7, 0x05);
+		X64_rip(x, X64_BSS, l->bss + 8, 4);
+		X64_int32(&x->code, (int) strlen(l->text));
+		X64_emit(x, 2, 0xc7, 0x05);
+		X64_rip(x, X64_BSS, l->bss + 32, 4);
+		X64_int32(&x->code, (int) AST_hashString(l->text));
+	}
+}
+
+// every variable and temporary starts out as ""
+static void X64_setupStrings(X64 *x) {
+	LIST_FOREACH(x->strings, first, next, cur) {
+		X64_emit(x, 3, 0x48, 0x8d, 0x05);
+		X64_rip(x, X64_RODATA, x->emptyString, 0);
+		X64_emit(x, 3, 0x48, 0x89, 0x05);
+		X64_rip(x, X64_BSS, *(int *) cur->value, 0);
+	}
+}
+
+static void X64_patchGotos(X64 *x) {
+	LIST_FOREACH(x->gotos, first, next, cur) {
+		X64Label *jump = (X64Label *) cur->value;
+		LIST_FOREACH(x->labels, first, next, label) {
+			X64Label *l = (X64Label *) label->value;
+			if (strcmp(l->name, jump->name) == 0)
+				X64_patch(x, jump->offset, l->offset);
+		}
+	}
+}
+
+// entry point: start the runtime, set up the string literals (emitted at
+// the end, once they are all known), run the program and exit
+void X64_program(X64 *x, AST *ast) {
+	// a call left the stack 8 bytes off the alignment an ELF entry starts with
+	if (x->returns)
+		X64_emit(x, 4, 0x48, 0x83, 0xec, 0x08);
+	X64_call(x, X64RUNTIME_INIT);
+	int setup = X64_jump(x, X64_JMP);
+	int start = x->code.length;
+
+	X64_block(x, ast->children->first, NULL);
+
+	X64_call(x, X64RUNTIME_FLUSH);
+	if (x->returns) {
+		// add rsp, 8; ret
+		X64_emit(x, 5, 0x48, 0x83, 0xc4, 0x08, 0xc3);
+	} else {
+		// mov eax, 231 (exit_group); xor edi, edi; syscall
+		X64_emit(x, 1, 0xb8);
+		X64_int32(&x->code, 231);
+		X64_emit(x, 4, 0x31, 0xff, 0x0f, 0x05);
+	}
+
+	X64_patch(x, setup, x->code.length);
+	X64_setupLiterals(x);
+	X64_setupStrings(x);
+	X64_jumpBack(x, start);
+
+	X64_patchGotos(x);
+}
+
+void X64_resolve(X64 *x, unsigned long addresses[X64_SECTIONS]) {
+	LIST_FOREACH(x->fixups, first, next, cur) {
+		X64Fixup *f = (X64Fixup *) cur->value;
+		long rel = (long) (addresses[f->section] + f->offset) - (long) (addresses[X64_CODE] + f->end);
+		if (rel != (int) rel) {
+			Diagnostic_raise(0, "Native code is too far away from its data.");
+		}
+		int rel32 = (int) rel;
+		memcpy(x->code.bytes + f->at, &rel32, 4);
+	}
+}
+
+// statements from current up to, not including, end
+void X64_block(X64 *x, ListNode *current, ListNode *end) {
+	while (current != end) {
+		ASTNode *statement = (ASTNode *) current->value;
+		if (AST_isConstantPrint(statement)) {
+			X64_constantPrints(x, &current);
+			if (current == end)
+				break;
+			continue;
+		}
+		X64_statement(x, statement);
+		current = current->next;
+	}
+}
+
+// same merging of PRINT "literal" runs as IR_constantPrints, moves current
+// past the run
+void X64_constantPrints(X64 *x, ListNode **current) {
+	int start = x->rodata.length;
+	while (*current != NULL && AST_isConstantPrint((ASTNode *) (*current)->value)) {
+		ASTNode *printed = (ASTNode *) List_first(((ASTNode *) (*current)->value)->children);
+		char *text = printed->token->text;
+		while (*text != '\0')
+			X64_byte(&x->rodata, *text++);
+		X64_byte(&x->rodata, '\n');
+		*current = (*current)->next;
+	}
+	// lea rsi, [text]; mov edx, length
+	X64_emit(x, 3, 0x48, 0x8d, 0x35);
+	X64_rip(x, X64_RODATA, start, 0);
+	X64_emit(x, 1, 0xba);
+	X64_int32(&x->code, x->rodata.length - start);
+	X64_call(x, X64RUNTIME_WRITE);
+}
+
+void X64_statement(X64 *x, ASTNode *statement) {
+	x->ast->currentLineNumber = statement->lineNumber;
+	ASTNode *child = (ASTNode *) List_first(statement->children);
+	X64Variable *variable = NULL;
+	X64Type type;
+	int top;
+	int end;
+
+	switch (statement->token->type) {
+		case PRINT:
+			if (child->subType == BOOL_VAR) {
+				X64_comparison(x, child);
+				// mov esi, eax
+				X64_emit(x, 2, 0x89, 0xc6);
+				X64_call(x, X64RUNTIME_PRINT_BOOL);
+				break;
+			}
+			type = X64_comparison(x, child);
+			if (type == X64_STRING) {
+				// mov rsi, rax
+				X64_emit(x, 3, 0x48, 0x89, 0xc6);
+				X64_call(x, X64RUNTIME_PRINT_STR);
+			} else if (type == X64_INT) {
+				X64_emit(x, 2, 0x89, 0xc6);
+				X64_call(x, X64RUNTIME_PRINT_INT);
+			} else {
+				// cvtss2sd xmm0, xmm0
+				if (type == X64_FLOAT)
+					X64_emit(x, 4, 0xf3, 0x0f, 0x5a, 0xc0);
+				X64_call(x, X64RUNTIME_PRINT_FLOAT);
+			}
+			break;
+
+		case IF:
+		case ELSEIF:
+			X64_if(x, statement);
+			break;
+
+		case WHILE:
+			top = x->code.length;
+			end = X64_jump(x, X64_condition(x, child));
+			X64_block(x, statement->children->first->next, NULL);
+			X64_jumpBack(x, top);
+			X64_patch(x, end, x->code.length);
+			break;
+
+		case FOR:
+			X64_for(x, statement);
+			break;
+
+		case LABEL:
+			{
+				X64Label *l = malloc(sizeof(X64Label));
+				l->name = strdup(child->token->text);
+				l->offset = x->code.length;
+				List_push(x->labels, l);
+			}
+			break;
+
+		case GOTO:
+			{
+				X64Label *l = malloc(sizeof(X64Label));
+				l->name = strdup(child->token->text);
+				l->offset = X64_jump(x, X64_JMP);
+				List_push(x->gotos, l);
+			}
+			break;
+
+		case LET:
+			variable = X64_variable(x, child->token->text);
+			child = (ASTNode *) List_last(statement->children);
+			if (variable->type == STRING_VAR && child->token->type == PLUS) {
+				X64_concat(x, child, variable->offset);
+			} else if (variable->type == STRING_VAR) {
+				X64_comparison(x, child);
+				// mov rdx, rax; lea rsi, [variable]
+				X64_emit(x, 3, 0x48, 0x89, 0xc2);
+				X64_emit(x, 3, 0x48, 0x8d, 0x35);
+				X64_rip(x, X64_BSS, variable->offset, 0);
+				X64_call(x, X64RUNTIME_STR_SET);
+			} else {
+				X64_store(x, variable, X64_comparison(x, child));
+			}
+			break;
+
+		case INPUT:
+			variable = X64_variable(x, child->token->text);
+			// lea rsi, [variable]
+			X64_emit(x, 3, 0x48, 0x8d, 0x35);
+			X64_rip(x, X64_BSS, variable->offset, 0);
+			if (variable->type == STRING_VAR) {
+				X64_call(x, X64RUNTIME_STR_INPUT);
+			} else if (variable->type == FLOAT_VAR) {
+				X64_call(x, X64RUNTIME_INPUT_FLOAT);
+			} else {
+				X64_call(x, X64RUNTIME_INPUT_INT);
+			}
+			if (variable->type == BOOL_VAR) {
+				// mov eax, [variable], then store it back as 0 or 1
+				X64_emit(x, 2, 0x8b, 0x05);
+				X64_rip(x, X64_BSS, variable->offset, 0);
+				X64_store(x, variable, X64_INT);
+			}
+			break;
+
+		default:
+			AST_abort("Native backend does not know this statement.");
+			break;
+	}
+}
+
+// statement.children = List(comparison, {statement}, [ELSEIF | ELSE])
+void X64_if(X64 *x, ASTNode *statement) {
+	ListNode *first = statement->children->first;
+	ASTNode *tail = (ASTNode *) List_last(statement->children);
+	ListNode *end = NULL;
+	if (statement->children->last != first && (tail->token->type == ELSEIF || tail->token->type == ELSE))
+		end = statement->children->last;
+	else
+		tail = NULL;
+
+	int skip = X64_jump(x, X64_condition(x, (ASTNode *) first->value));
+	X64_block(x, first->next, end);
+
+	if (tail == NULL) {
+		X64_patch(x, skip, x->code.length);
+		return;
+	}
+	int done = X64_jump(x, X64_JMP);
+	X64_patch(x, skip, x->code.length);
+	if (tail->token->type == ELSEIF)
+		X64_if(x, tail);
+	else
+		X64_block(x, tail->children->first, NULL);
+	X64_patch(x, done, x->code.length);
+}
+
+// for (v = from; v <= to; v++), with to evaluated on every iteration
+void X64_for(X64 *x, ASTNode *statement) {
+	ListNode *current = statement->children->first;
+	ASTNode *ident = (ASTNode *) current->value;
+	X64Variable *variable = X64_variable(x, ident->token->text);
+	current = current->next;
+	X64_store(x, variable, X64_comparison(x, (ASTNode *) current->value));
+	current = current->next;
+
+	int top = x->code.length;
+	X64Type left = X64_comparison(x, ident);
+	ASTItem **bound = AST_flatten((ASTNode *) current->value);
+	if (left == X64_INT && X64_loadEcx(x, bound, 0, 0)) {
+		X64_integer(x, LTEQ);
+	} else {
+		X64_push(x, left);
+		X64Type right = X64_comparison(x, (ASTNode *) current->value);
+		X64_compare(x, LTEQ, left, right);
+	}
+	AST_killItems(bound);
+	int end = X64_jump(x, X64_unless(x));
+
+	X64_block(x, current->next, NULL);
+
+	if (variable->type == INT_VAR) {
+		// add dword [variable], 1
+		X64_emit(x, 2, 0x83, 0x05);
+		X64_rip(x, X64_BSS, variable->offset, 1);
+		X64_emit(x, 1, 0x01);
+	} else {
+		// movss xmm0, [variable]; addss xmm0, [1.0f]; movss [variable], xmm0
+		X64_emit(x, 4, 0xf3, 0x0f, 0x10, 0x05);
+		X64_rip(x, X64_BSS, variable->offset, 0);
+		X64_emit(x, 4, 0xf3, 0x0f, 0x58, 0x05);
+		X64_rip(x, X64_RODATA, x->one, 0);
+		X64_emit(x, 4, 0xf3, 0x0f, 0x11, 0x05);
+		X64_rip(x, X64_BSS, variable->offset, 0);
+	}
+	X64_jumpBack(x, top);
+	X64_patch(x, end, x->code.length);
+}
+
+// converts the current value to the variable's type, like a C assignment
+void X64_store(X64 *x, X64Variable *variable, X64Type type) {
+	switch (variable->type) {
+		case INT_VAR:
+			// cvttss2si / cvttsd2si eax, xmm0
+			if (type == X64_FLOAT)
+				X64_emit(x, 4, 0xf3, 0x0f, 0x2c, 0xc0);
+			else if (type == X64_DOUBLE)
+				X64_emit(x, 4, 0xf2, 0x0f, 0x2c, 0xc0);
+			// mov [variable], eax
+			X64_emit(x, 2, 0x89, 0x05);
+			X64_rip(x, X64_BSS, variable->offset, 0);
+			break;
+
+		case BOOL_VAR:
+			X64_truth(x, type);
+			// test eax, eax; setne al; movzx eax, al; mov [variable], eax
+			X64_emit(x, 8, 0x85, 0xc0, 0x0f, 0x95, 0xc0, 0x0f, 0xb6, 0xc0);
+			X64_emit(x, 2, 0x89, 0x05);
+			X64_rip(x, X64_BSS, variable->offset, 0);
+			break;
+
+		case FLOAT_VAR:
+			// cvtsi2ss xmm0, eax / cvtsd2ss xmm0, xmm0
+			if (type == X64_INT)
+				X64_emit(x, 4, 0xf3, 0x0f, 0x2a, 0xc0);
+			else if (type == X64_DOUBLE)
+				X64_emit(x, 4, 0xf2, 0x0f, 0x5a, 0xc0);
+			// movss [variable], xmm0
+			X64_emit(x, 4, 0xf3, 0x0f, 0x11, 0x05);
+			X64_rip(x, X64_BSS, variable->offset, 0);
+			break;
+
+		default:
+			AST_abort("Native backend can not store this type.");
+			break;
+	}
+}
+
+// returns the jcc that skips when the condition is false
+int X64_condition(X64 *x, ASTNode *comparison) {
+	X64Type type = X64_comparison(x, comparison);
+	if (type == X64_STRING)
+		AST_abort("A string can not be used as a condition.");
+	X64_truth(x, type);
+	return X64_unless(x);
+}
+
+// If the value in eax was just made by a setcc from the flags, those flags
+// are branched on directly and the setcc goes, otherwise eax is tested.
+int X64_unless(X64 *x) {
+	if (x->setccEnd == x->code.length && x->setcc != 0) {
+		// setcc al; movzx eax, al
+		x->code.length -= 6;
+		x->setccEnd = -1;
+		return (x->setcc - 0x10) ^ 1;
+	}
+	// test eax, eax
+	X64_emit(x, 2, 0x85, 0xc0);
+	return X64_JZ;
+}
+
+// eax = value != 0 for a float or double in xmm0, NaN counts as true
+void X64_truth(X64 *x, X64Type type) {
+	if (type == X64_INT)
+		return;
+	// xorps xmm1, xmm1; ucomiss/ucomisd xmm0, xmm1
+	X64_emit(x, 3, 0x0f, 0x57, 0xc9);
+	if (type == X64_DOUBLE)
+		X64_emit(x, 1, 0x66);
+	X64_emit(x, 3, 0x0f, 0x2e, 0xc1);
+	// setne al; setp cl; or al, cl; movzx eax, al
+	X64_emit(x, 8, 0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8);
+	X64_emit(x, 3, 0x0f, 0xb6, 0xc0);
+}
+
+X64Type X64_comparison(X64 *x, ASTNode *comparison) {
+	ASTItem **items = AST_flatten(comparison);
+	int at = 0;
+	X64Type type = X64_climb(x, items, &at, 1);
+	AST_killItems(items);
+	return type;
+}
+
+// precedence climbing over the flattened items, binding like C does
+X64Type X64_climb(X64 *x, ASTItem **items, int *at, int precedence) {
+	ASTItem *item = items[(*at)++];
+	X64Type type;
+	if (item->kind == AST_ITEM_OPEN) {
+		type = X64_climb(x, items, at, 1);
+		(*at)++;
+	} else {
+		type = X64_value(x, item->node);
+	}
+
+	while (items[*at] != NULL && items[*at]->kind == AST_ITEM_OPERATOR) {
+		TokenType operation = items[*at]->node->token->type;
+		int level = AST_precedence(operation);
+		if (level < precedence)
+			break;
+		(*at)++;
+		if (type == X64_INT && X64_loadEcx(x, items, *at, level)) {
+			// the right operand was a plain int, straight into ecx
+			(*at)++;
+			type = X64_integer(x, operation);
+			continue;
+		}
+		X64_push(x, type);
+		X64Type right = X64_climb(x, items, at, level + 1);
+		if (AST_isComparisonOperator(operation))
+			type = X64_compare(x, operation, type, right);
+		else
+			type = X64_arithmetic(x, operation, type, right);
+	}
+	return type;
+}
+
+// the left operand is on the stack, the right one was just computed
+X64Type X64_compare(X64 *x, TokenType operation, X64Type left, X64Type right) {
+	if (left == X64_STRING) {
+		// mov rdx, rax; pop rsi
+		X64_emit(x, 4, 0x48, 0x89, 0xc2, 0x5e);
+		x->depth--;
+		X64_call(x, X64RUNTIME_STR_EQ);
+		// xor eax, 1
+		if (operation == NOTEQ)
+			X64_emit(x, 3, 0x83, 0xf0, 0x01);
+		return X64_INT;
+	}
+
+	X64Type common = left > right ? left : right;
+	X64_operands(x, left, right, common);
+
+	if (common == X64_INT)
+		return X64_integer(x, operation);
+
+	// ucomiss/ucomisd, swapped for < and <= so NaN compares false
+	int swapped = operation == LT || operation == LTEQ;
+	if (common == X64_DOUBLE)
+		X64_emit(x, 1, 0x66);
+	X64_emit(x, 3, 0x0f, 0x2e, swapped ? 0xc8 : 0xc1);
+	switch (operation) {
+		case GT:
+		case LT:
+			// seta al
+			X64_setcc(x, 0x97);
+			return X64_INT;
+		case GTEQ:
+		case LTEQ:
+			// setae al
+			X64_setcc(x, 0x93);
+			return X64_INT;
+		case EQEQ:
+			// sete al; setnp cl; and al, cl
+			X64_emit(x, 8, 0x0f, 0x94, 0xc0, 0x0f, 0x9b, 0xc1, 0x20, 0xc8);
+			break;
+		case NOTEQ:
+			// setne al; setp cl; or al, cl
+			X64_emit(x, 8, 0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8);
+			break;
+		default:
+			AST_abort("Invalid comparison.");
+			break;
+	}
+	// movzx eax, al
+	X64_emit(x, 3, 0x0f, 0xb6, 0xc0);
+	return X64_INT;
+}
+
+// setcc al; movzx eax, al, remembered so X64_unless can branch instead
+void X64_setcc(X64 *x, int setcc) {
+	X64_emit(x, 6, 0x0f, setcc, 0xc0, 0x0f, 0xb6, 0xc0);
+	x->setcc = setcc;
+	x->setccEnd = x->code.length;
+}
+
+// eax = eax operation ecx
+X64Type X64_integer(X64 *x, TokenType operation) {
+	switch (operation) {
+		case PLUS:
+			// add eax, ecx
+			X64_emit(x, 2, 0x01, 0xc8);
+			break;
+		case MINUS:
+			// sub eax, ecx
+			X64_emit(x, 2, 0x29, 0xc8);
+			break;
+		case ASTERISK:
+			// imul eax, ecx
+			X64_emit(x, 3, 0x0f, 0xaf, 0xc1);
+			break;
+		case SLASH:
+			// cdq; idiv ecx
+			X64_emit(x, 3, 0x99, 0xf7, 0xf9);
+			break;
+		default:
+			// cmp eax, ecx
+			X64_emit(x, 2, 0x39, 0xc8);
+			switch (operation) {
+				case EQEQ: X64_setcc(x, 0x94); break;
+				case NOTEQ: X64_setcc(x, 0x95); break;
+				case LT: X64_setcc(x, 0x9c); break;
+				case LTEQ: X64_setcc(x, 0x9e); break;
+				case GT: X64_setcc(x, 0x9f); break;
+				case GTEQ: X64_setcc(x, 0x9d); break;
+				default: AST_abort("Invalid comparison."); break;
+			}
+			break;
+	}
+	return X64_INT;
+}
+
+// When items[at] is an int variable or constant that binds to the operator
+// before it on its own, it is loaded into ecx without touching the stack.
+int X64_loadEcx(X64 *x, ASTItem **items, int at, int level) {
+	ASTItem *item = items[at];
+	ASTItem *after = items[at + 1];
+	if (item->kind != AST_ITEM_VALUE)
+		return 0;
+	if (after != NULL && after->kind == AST_ITEM_OPERATOR && AST_precedence(after->node->token->type) > level)
+		return 0;
+	if (item->node->token->type == NUMBERINT) {
+		// mov ecx, imm32
+		X64_emit(x, 1, 0xb9);
+		X64_int32(&x->code, (int) strtol(item->node->token->text, NULL, 10));
+		return 1;
+	}
+	if (item->node->token->type != IDENT)
+		return 0;
+	X64Variable *variable = X64_variable(x, item->node->token->text);
+	if (variable->type != INT_VAR && variable->type != BOOL_VAR)
+		return 0;
+	// mov ecx, [variable]
+	X64_emit(x, 2, 0x8b, 0x0d);
+	X64_rip(x, X64_BSS, variable->offset, 0);
+	return 1;
+}
+
+X64Type X64_value(X64 *x, ASTNode *expression) {
+	X64Variable *variable;
+	int offset;
+
+	if (expression->subType == STRING_VAR && expression->token->type == PLUS) {
+		// PRINT and comparisons concatenate into a temporary of their own
+		offset = X64_string(x);
+		X64_concat(x, expression, offset);
+		X64_emit(x, 3, 0x48, 0x8d, 0x05);
+		X64_rip(x, X64_BSS, offset, 0);
+		return X64_STRING;
+	}
+
+	switch (expression->token->type) {
+		case IDENT:
+			variable = X64_variable(x, expression->token->text);
+			if (variable->type == STRING_VAR) {
+				// lea rax, [variable]
+				X64_emit(x, 3, 0x48, 0x8d, 0x05);
+				X64_rip(x, X64_BSS, variable->offset, 0);
+				return X64_STRING;
+			} else if (variable->type == FLOAT_VAR) {
+				// movss xmm0, [variable]
+				X64_emit(x, 4, 0xf3, 0x0f, 0x10, 0x05);
+				X64_rip(x, X64_BSS, variable->offset, 0);
+				return X64_FLOAT;
+			}
+			// mov eax, [variable]
+			X64_emit(x, 2, 0x8b, 0x05);
+			X64_rip(x, X64_BSS, variable->offset, 0);
+			return X64_INT;
+
+		case NUMBERINT:
+			// mov eax, imm32
+			X64_emit(x, 1, 0xb8);
+			X64_int32(&x->code, (int) strtol(expression->token->text, NULL, 10));
+			return X64_INT;
+
+		case NUMBERFLOAT:
+			// movsd xmm0, [constant], a C literal like 4.5 is a double
+			offset = X64_double(x, strtod(expression->token->text, NULL));
+			X64_emit(x, 4, 0xf2, 0x0f, 0x10, 0x05);
+			X64_rip(x, X64_RODATA, offset, 0);
+			return X64_DOUBLE;
+
+		case STRING:
+			X64_emit(x, 3, 0x48, 0x8d, 0x05);
+			X64_rip(x, X64_BSS, X64_literal(x, expression->token->text), 0);
+			return X64_STRING;
+
+		case TRUE:
+			// mov eax, 1
+			X64_emit(x, 1, 0xb8);
+			X64_int32(&x->code, 1);
+			return X64_INT;
+
+		case FALSE:
+			// xor eax, eax
+			X64_emit(x, 2, 0x31, 0xc0);
+			return X64_INT;
+
+		default:
+			break;
+	}
+
+	if (!AST_isComparisonOperator(expression->token->type))
+		AST_abort("Native backend does not know this expression.");
+	// a string comparison, tt_str_eq in the C backend
+	X64_push(x, X64_comparison(x, (ASTNode *) List_first(expression->children)));
+	X64Type right = X64_comparison(x, (ASTNode *) List_last(expression->children));
+	return X64_compare(x, expression->token->type, X64_STRING, right);
+}
+
+// the left operand is on the stack, the right one was just computed
+X64Type X64_arithmetic(X64 *x, TokenType operation, X64Type left, X64Type right) {
+	X64Type common = left > right ? left : right;
+	X64_operands(x, left, right, common);
+
+	if (common == X64_INT)
+		return X64_integer(x, operation);
+
+	int opcode = 0x58;
+	if (operation == MINUS)
+		opcode = 0x5c;
+	else if (operation == ASTERISK)
+		opcode = 0x59;
+	else if (operation == SLASH)
+		opcode = 0x5e;
+	// addss/subss/mulss/divss or the sd forms, xmm0, xmm1
+	X64_emit(x, 4, common == X64_DOUBLE ? 0xf2 : 0xf3, 0x0f, opcode, 0xc1);
+	return common;
+}
+
+// Pops the left operand and lines both up as common: eax and ecx for ints,
+// xmm0 and xmm1 for floats and doubles.
+void X64_operands(X64 *x, X64Type left, X64Type right, X64Type common) {
+	int prefix = common == X64_DOUBLE ? 0xf2 : 0xf3;
+	x->depth--;
+
+	if (common == X64_INT) {
+		// mov ecx, eax; pop rax
+		X64_emit(x, 3, 0x89, 0xc1, 0x58);
+		return;
+	}
+
+	if (right == X64_INT) {
+		// cvtsi2ss/cvtsi2sd xmm1, eax
+		X64_emit(x, 4, prefix, 0x0f, 0x2a, 0xc8);
+	} else if (right == X64_FLOAT && common == X64_DOUBLE) {
+		// cvtss2sd xmm1, xmm0
+		X64_emit(x, 4, 0xf3, 0x0f, 0x5a, 0xc8);
+	} else {
+		// movaps xmm1, xmm0
+		X64_emit(x, 3, 0x0f, 0x28, 0xc8);
+	}
+
+	if (left == X64_INT) {
+		// pop rax; cvtsi2ss/cvtsi2sd xmm0, eax
+		X64_emit(x, 1, 0x58);
+		X64_emit(x, 4, prefix, 0x0f, 0x2a, 0xc0);
+		return;
+	}
+	// movss/movsd xmm0, [rsp]; add rsp, 8
+	X64_emit(x, 5, left == X64_DOUBLE ? 0xf2 : 0xf3, 0x0f, 0x10, 0x04, 0x24);
+	X64_emit(x, 4, 0x48, 0x83, 0xc4, 0x08);
+	if (left == X64_FLOAT && common == X64_DOUBLE) {
+		// cvtss2sd xmm0, xmm0
+		X64_emit(x, 4, 0xf3, 0x0f, 0x5a, 0xc0);
+	}
+}
+
+// one X64Runtime_strCat over every operand of the + chain, the pointers to
+// the operands are pushed so that the stack holds them in order
+void X64_concat(X64 *x, ASTNode *expression, int destination) {
+	List *parts = List_create();
+	X64_stringParts(expression, parts);
+	int count = List_count(parts);
+	int padding = (x->depth + count) % 2;
+	if (padding) {
+		// sub rsp, 8
+		X64_emit(x, 4, 0x48, 0x83, 0xec, 0x08);
+		x->depth++;
+	}
+	LIST_FOREACH(parts, last, prev, cur) {
+		X64_comparison(x, (ASTNode *) cur->value);
+		X64_push(x, X64_STRING);
+	}
+	// mov rdx, rsp; mov ecx, count; lea rsi, [destination]
+	X64_emit(x, 3, 0x48, 0x89, 0xe2);
+	X64_emit(x, 1, 0xb9);
+	X64_int32(&x->code, count);
+	X64_emit(x, 3, 0x48, 0x8d, 0x35);
+	X64_rip(x, X64_BSS, destination, 0);
+	X64_call(x, X64RUNTIME_STR_CAT);
+	// add rsp, 8 * slots
+	X64_emit(x, 3, 0x48, 0x81, 0xc4);
+	X64_int32(&x->code, 8 * (count + padding));
+	x->depth -= count + padding;
+	List_destroy(parts);
+}
+
+void X64_stringParts(ASTNode *expression, List *parts) {
+	if (expression->token->type != PLUS) {
+		List_push(parts, expression);
+		return;
+	}
+	ListNode *child = expression->children->first;
+	if (((ASTNode *) child->value)->token->type == LEFTPAREN)
+		child = child->next;
+	X64_stringParts((ASTNode *) child->value, parts);
+	X64_stringParts((ASTNode *) child->next->value, parts);
+}
+
+X64Variable *X64_variable(X64 *x, char *name) {
+	LIST_FOREACH(x->variables, first, next, cur) {
+		X64Variable *v = (X64Variable *) cur->value;
+		if (strcmp(v->name, name) == 0)
+			return v;
+	}
+	AST_abort("Native backend could not find a variable.");
+	return NULL;
+}
+
+// returns where the literal's X64String is, adding it the first time
+int X64_literal(X64 *x, char *text) {
+	LIST_FOREACH(x->literals, first, next, cur) {
+		X64Literal *l = (X64Literal *) cur->value;
+		if (strcmp(l->text, text) == 0)
+			return l->bss;
+	}
+	X64Literal *l = malloc(sizeof(X64Literal));
+	l->text = strdup(text);
+	l->rodata = x->rodata.length;
+	while (*text != '\0')
+		X64_byte(&x->rodata, *text++);
+	X64_byte(&x->rodata, 0);
+	l->bss = X64_bss(x, sizeof(X64String));
+	List_push(x->literals, l);
+	return l->bss;
+}
+
+// room for a string variable or temporary, set to "" on startup
+int X64_string(X64 *x) {
+	int *offset = malloc(sizeof(int));
+	*offset = X64_bss(x, sizeof(X64String));
+	List_push(x->strings, offset);
+	return *offset;
+}
+
+void X64_push(X64 *x, X64Type type) {
+	if (type == X64_INT || type == X64_STRING) {
+		// push rax
+		X64_emit(x, 1, 0x50);
+	} else {
+		// sub rsp, 8; movsd [rsp], xmm0
+		X64_emit(x, 4, 0x48, 0x83, 0xec, 0x08);
+		X64_emit(x, 5, 0xf2, 0x0f, 0x11, 0x04, 0x24);
+	}
+	x->depth++;
+}
+
+// rdi always carries the runtime's state, the stack is realigned to 16
+void X64_call(X64 *x, X64RuntimeCall call) {
+	int odd = x->depth % 2;
+	// sub rsp, 8
+	if (odd)
+		X64_emit(x, 4, 0x48, 0x83, 0xec, 0x08);
+	// lea rdi, [runtime state]; call entry
+	X64_emit(x, 3, 0x48, 0x8d, 0x3d);
+	X64_rip(x, X64_BSS, 0, 0);
+	X64_emit(x, 1, 0xe8);
+	X64_rip(x, X64_RUNTIME, call * X64RUNTIME_ENTRY_SIZE, 0);
+	// add rsp, 8
+	if (odd)
+		X64_emit(x, 4, 0x48, 0x83, 0xc4, 0x08);
+}
@@ -0,0 +1,139 @@
+#ifndef X64_H
+#define X64_H
+
+#include "ast.h"
+#include "list.h"
+#include "x64rt.h"
+
+// Native backend: lowers the checked AST straight to x86-64 machine code.
+// Code only reaches the other sections RIP-relative, through fixups that
+// X64_resolve patches once the caller has placed everything in memory.
+
+typedef enum X64Section {
+	X64_CODE = 0,
+	X64_RODATA = 1,
+	X64_RUNTIME = 2,
+	X64_BSS = 3,
+	X64_SECTIONS = 4
+} X64Section;
+
+// the C type a value has in the C backend, which decides the arithmetic
+typedef enum X64Type {
+	X64_INT = 1,
+	X64_FLOAT = 2,
+	X64_DOUBLE = 3,
+	X64_STRING = 4
+} X64Type;
+
+typedef struct X64Buffer {
+	unsigned char *bytes;
+	int length;
+	int capacity;
+} X64Buffer;
+
+// a disp32 at code[at] that points at section + offset, relative to end
+typedef struct X64Fixup {
+	int at;
+	int end;
+	X64Section section;
+	int offset;
+} X64Fixup;
+
+typedef struct X64Label {
+	char *name;
+	int offset;
+} X64Label;
+
+typedef struct X64Variable {
+	char *name;
+	TokenType type;
+	int offset;
+} X64Variable;
+
+typedef struct X64Literal {
+	char *text;
+	int rodata;
+	int bss;
+} X64Literal;
+
+typedef struct X64 {
+	AST *ast;
+	X64Buffer code;
+	X64Buffer rodata;
+	int bssSize;
+	List *fixups;
+	List *labels;
+	List *gotos;
+	List *variables;
+	List *literals;
+	List *strings;
+	// 8 byte slots pushed since the last statement, for call alignment
+	int depth;
+	int emptyString;
+	int one;
+	// where the last X64_setcc ended, for X64_unless
+	int setcc;
+	int setccEnd;
+	// called like a function by the JIT instead of being an executable's entry
+	int returns;
+} X64;
+
+X64 *X64_create(AST *ast);
+
+void X64_kill(X64 *x);
+
+void X64_program(X64 *x, AST *ast);
+
+void X64_resolve(X64 *x, unsigned long addresses[X64_SECTIONS]);
+
+void X64_block(X64 *x, ListNode *current, ListNode *end);
+
+void X64_statement(X64 *x, ASTNode *statement);
+
+void X64_constantPrints(X64 *x, ListNode **current);
+
+void X64_if(X64 *x, ASTNode *statement);
+
+void X64_for(X64 *x, ASTNode *statement);
+
+void X64_store(X64 *x, X64Variable *variable, X64Type type);
+
+void X64_truth(X64 *x, X64Type type);
+
+int X64_condition(X64 *x, ASTNode *comparison);
+
+int X64_unless(X64 *x);
+
+void X64_setcc(X64 *x, int setcc);
+
+X64Type X64_integer(X64 *x, TokenType operation);
+
+int X64_loadEcx(X64 *x, ASTItem **items, int at, int level);
+
+X64Type X64_comparison(X64 *x, ASTNode *comparison);
+
+X64Type X64_climb(X64 *x, ASTItem **items, int *at, int precedence);
+
+X64Type X64_value(X64 *x, ASTNode *value);
+
+X64Type X64_compare(X64 *x, TokenType operation, X64Type left, X64Type right);
+
+X64Type X64_arithmetic(X64 *x, TokenType operation, X64Type left, X64Type right);
+
+void X64_concat(X64 *x, ASTNode *expression, int destination);
+
+void X64_stringParts(ASTNode *expression, List *parts);
+
+X64Variable *X64_variable(X64 *x, char *name);
+
+int X64_literal(X64 *x, char *text);
+
+int X64_string(X64 *x);
+
+void X64_push(X64 *x, X64Type type);
+
+void X64_operands(X64 *x, X64Type left, X64Type right, X64Type common);
+
+void X64_call(X64 *x, X64RuntimeCall call);
+
+#endif
@@ -0,0 +1,535 @@
+#include "x64rt.h"
+
+// Built twice: linked into teenytiny like any other file, and with
+// -DX64RUNTIME_BLOB into the freestanding blob the native backend copies into
+// its executables. Nothing in here may use libc, writable globals or TLS.
+
+#define SYS_READ 0
+#define SYS_WRITE 1
+#define SYS_MMAP 9
+#define SYS_MUNMAP 11
+#define SYS_MREMAP 25
+
+#define PROT_READ_WRITE 3
+#define MAP_PRIVATE_ANONYMOUS 0x22
+#define MREMAP_MAYMOVE 1
+#define PAGE_SIZE 4096
+
+#ifdef X64RUNTIME_BLOB
+// jump table the generated code calls into, in X64RuntimeCall order
+__asm__(
+	".section .text.entry,\"ax\",@progbits\n"
+	".byte 0xe9\n .long X64Runtime_init - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_flush - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_write - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_printInt - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_printFloat - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_printBool - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_printStr - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_inputInt - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_inputFloat - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_strInput - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_strSet - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_strCat - . - 4\n"
+	".byte 0xe9\n .long X64Runtime_strEq - . - 4\n"
+	".text\n"
+);
+
+// gcc is allowed to emit calls to these even when freestanding
+void *memcpy(void *dst, const void *src, size_t n) {
+	char *d = dst;
+	const char *s = src;
+	while (n-- != 0)
+		*d++ = *s++;
+	return dst;
+}
+
+void *memset(void *dst, int c, size_t n) {
+	char *d = dst;
+	while (n-- != 0)
+		*d++ = (char) c;
+	return dst;
+}
+#endif
+
+static long X64Runtime_syscall(long n, long a, long b, long c, long d, long e, long f) {
+	long ret;
+	register long r10 __asm__("r10") = d;
+	register long r8 __asm__("r8") = e;
+	register long r9 __asm__("r9") = f;
+	__asm__ volatile ("syscall"
+		: "=a"(ret)
+		: "a"(n), "D"(a), "S"(b), "d"(c), "r"(r10), "r"(r8), "r"(r9)
+		: "rcx", "r11", "memory");
+	return ret;
+}
+
+static void X64Runtime_oom(void) {
+	static const char message[] = "out of memory\n";
+	X64Runtime_syscall(SYS_WRITE, 2, (long) message, sizeof(message) - 1, 0, 0, 0);
+	X64Runtime_syscall(231, 1, 0, 0, 0, 0, 0);
+}
+
+static char *X64Runtime_map(size_t size) {
+	long p = X64Runtime_syscall(SYS_MMAP, 0, (long) size, PROT_READ_WRITE, MAP_PRIVATE_ANONYMOUS, -1, 0);
+	if (p < 0 && p > -4096)
+		X64Runtime_oom();
+	return (char *) p;
+}
+
+static void X64Runtime_copy(char *dst, const char *src, size_t n) {
+	while (n-- != 0)
+		*dst++ = *src++;
+}
+
+static void X64Runtime_writeAll(const char *s, size_t n) {
+	while (n > 0) {
+		long written = X64Runtime_syscall(SYS_WRITE, 1, (long) s, (long) n, 0, 0, 0);
+		if (written == -4)
+			continue;
+		if (written <= 0)
+			return;
+		s += written;
+		n -= (size_t) written;
+	}
+}
+
+void X64Runtime_init(X64Runtime *rt) {
+	rt->out = X64Runtime_map(X64RUNTIME_OUT_SIZE);
+	rt->outLen = 0;
+	rt->in = X64Runtime_map(X64RUNTIME_IN_SIZE);
+	rt->inPos = 0;
+	rt->inLen = 0;
+	rt->inMidLine = 0;
+}
+
+void X64Runtime_flush(X64Runtime *rt) {
+	X64Runtime_writeAll(rt->out, rt->outLen);
+	rt->outLen = 0;
+}
+
+void X64Runtime_write(X64Runtime *rt, const char *s, size_t n) {
+	if (n > X64RUNTIME_OUT_SIZE - rt->outLen) {
+		X64Runtime_flush(rt);
+		if (n > X64RUNTIME_OUT_SIZE) {
+			X64Runtime_writeAll(s, n);
+			return;
+		}
+	}
+	X64Runtime_copy(rt->out + rt->outLen, s, n);
+	rt->outLen += n;
+}
+
+void X64Runtime_printInt(X64Runtime *rt, int v) {
+	char text[16];
+	char *p = text + sizeof(text);
+	unsigned int u = v < 0 ? 0u - (unsigned int) v : (unsigned int) v;
+	*--p = '\n';
+	do {
+		*--p = (char) ('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+	if (v < 0)
+		*--p = '-';
+	X64Runtime_write(rt, p, (size_t) (text + sizeof(text) - p));
+}
+
+// Same digits as printf("%.2f\n"). v is mantissa * 2^shift, so for
+// fractional values mantissa * 100 is shifted down and rounded half to even
+// by hand, and integral ones are printed exactly with a small bignum.
+void X64Runtime_printFloat(X64Runtime *rt, double v) {
+	char text[400];
+	char *p = text + sizeof(text);
+	union {
+		double d;
+		unsigned long long u;
+	} bits;
+	bits.d = v;
+	int negative = (int) (bits.u >> 63);
+	int exponent = (int) ((bits.u >> 52) & 0x7ff);
+	unsigned long long mantissa = bits.u & ((1ULL << 52) - 1);
+
+	*--p = '\n';
+	if (exponent == 0x7ff) {
+		const char *word = mantissa != 0 ? "nan" : "inf";
+		*--p = word[2];
+		*--p = word[1];
+		*--p = word[0];
+	} else {
+		if (exponent == 0)
+			exponent = 1;
+		else
+			mantissa |= 1ULL << 52;
+		int shift = exponent - 1075;
+
+		if (shift < 0) {
+			unsigned long long scaled = mantissa * 100;
+			unsigned long long q = 0;
+			if (-shift < 64) {
+				unsigned long long half = 1ULL << (-shift - 1);
+				unsigned long long r = scaled & ((half << 1) - 1);
+				q = scaled >> -shift;
+				if (r > half || (r == half && (q & 1)))
+					q++;
+			}
+			*--p = (char) ('0' + q % 10);
+			*--p = (char) ('0' + q / 10 % 10);
+			*--p = '.';
+			q /= 100;
+			do {
+				*--p = (char) ('0' + q % 10);
+				q /= 10;
+			} while (q != 0);
+		} else {
+			unsigned int limbs[36] = {0};
+			int count = shift / 32 + 3;
+			unsigned long long low = (mantissa << (shift % 32)) & 0xffffffffULL;
+			unsigned long long high = shift % 32 == 0 ? mantissa >> 32 : mantissa >> (32 - shift % 32);
+			limbs[shift / 32] = (unsigned int) low;
+			limbs[shift / 32 + 1] = (unsigned int) high;
+			limbs[shift / 32 + 2] = (unsigned int) (high >> 32);
+
+			*--p = '0';
+			*--p = '0';
+			*--p = '.';
+			while (1) {
+				// divide by 10^9, the remainder is the next nine digits
+				unsigned long long remainder = 0;
+				int nonZero = 0;
+				int i;
+				for (i = count - 1; i >= 0; i--) {
+					unsigned long long cur = (remainder << 32) | limbs[i];
+					limbs[i] = (unsigned int) (cur / 1000000000ULL);
+					remainder = cur % 1000000000ULL;
+					if (limbs[i] != 0)
+						nonZero = 1;
+				}
+				int digits = 0;
+				while (digits < 9 && (nonZero || remainder != 0 || digits == 0)) {
+					*--p = (char) ('0' + remainder % 10);
+					remainder /= 10;
+					digits++;
+				}
+				if (!nonZero)
+					break;
+			}
+		}
+	}
+	if (negative)
+		*--p = '-';
+	X64Runtime_write(rt, p, (size_t) (text + sizeof(text) - p));
+}
+
+void X64Runtime_printBool(X64Runtime *rt, int v) {
+	if (v == 0)
+		X64Runtime_write(rt, "FALSE\n", 6);
+	else
+		X64Runtime_write(rt, "TRUE\n", 5);
+}
+
+void X64Runtime_printStr(X64Runtime *rt, const X64String *s) {
+	X64Runtime_write(rt, s->ptr, s->len);
+	X64Runtime_write(rt, "\n", 1);
+}
+
+// the next byte of stdin without consuming it, -1 at the end of input
+static int X64Runtime_peek(X64Runtime *rt) {
+	if (rt->inPos == rt->inLen) {
+		// prompts have to be on screen before we wait on the user
+		X64Runtime_flush(rt);
+		long n;
+		do {
+			n = X64Runtime_syscall(SYS_READ, 0, (long) rt->in, X64RUNTIME_IN_SIZE, 0, 0, 0);
+		} while (n == -4);
+		if (n <= 0)
+			return -1;
+		rt->inPos = 0;
+		rt->inLen = (size_t) n;
+	}
+	return (unsigned char) rt->in[rt->inPos];
+}
+
+static int X64Runtime_isSpace(int c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// skips whitespace, returns 0 if only the end of input is left
+static int X64Runtime_skipSpace(X64Runtime *rt) {
+	int c;
+	while ((c = X64Runtime_peek(rt)) != -1 && X64Runtime_isSpace(c))
+		rt->inPos++;
+	return c != -1;
+}
+
+// bad input becomes 0 and the offending word is thrown away
+static void X64Runtime_skipWord(X64Runtime *rt) {
+	int c;
+	while ((c = X64Runtime_peek(rt)) != -1 && !X64Runtime_isSpace(c))
+		rt->inPos++;
+}
+
+void X64Runtime_inputInt(X64Runtime *rt, int *v) {
+	if (!X64Runtime_skipSpace(rt))
+		return;
+	rt->inMidLine = 1;
+	int negative = 0;
+	int c = X64Runtime_peek(rt);
+	if (c == '-' || c == '+') {
+		negative = c == '-';
+		rt->inPos++;
+	}
+	unsigned int u = 0;
+	int digits = 0;
+	while ((c = X64Runtime_peek(rt)) >= '0' && c <= '9') {
+		u = u * 10 + (unsigned int) (c - '0');
+		digits++;
+		rt->inPos++;
+	}
+	if (digits == 0) {
+		*v = 0;
+		X64Runtime_skipWord(rt);
+		return;
+	}
+	*v = (int) (negative ? 0u - u : u);
+}
+
+// how much of word, lower case, the input goes on with in any case
+static int X64Runtime_word(X64Runtime *rt, const char *word) {
+	int i;
+	for (i = 0; word[i] != '\0'; i++) {
+		int c = X64Runtime_peek(rt);
+		if (c == -1 || (c | 0x20) != word[i])
+			break;
+		rt->inPos++;
+	}
+	return i;
+}
+
+// same algorithm as tt_input_float in the C backend's runtime
+void X64Runtime_inputFloat(X64Runtime *rt, float *v) {
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	if (!X64Runtime_skipSpace(rt))
+		return;
+	rt->inMidLine = 1;
+	int negative = 0;
+	int c = X64Runtime_peek(rt);
+	if (c == '-' || c == '+') {
+		negative = c == '-';
+		rt->inPos++;
+	}
+	// nan, inf and infinity, in any case, as scanf took them
+	if ((c = X64Runtime_peek(rt) | 0x20) == 'n' || c == 'i') {
+		if (c == 'n' ? X64Runtime_word(rt, "nan") != 3 : X64Runtime_word(rt, "inf") != 3) {
+			*v = 0;
+			X64Runtime_skipWord(rt);
+			return;
+		}
+		if (c == 'i')
+			X64Runtime_word(rt, "inity");
+		float special = c == 'n' ? __builtin_nanf("") : __builtin_inff();
+		*v = negative ? -special : special;
+		return;
+	}
+	unsigned long long mantissa = 0;
+	int significant = 0;
+	int exponent = 0;
+	int digits = 0;
+	while ((c = X64Runtime_peek(rt)) >= '0' && c <= '9') {
+		if (significant < 19) {
+			mantissa = mantissa * 10 + (unsigned long long) (c - '0');
+			if (mantissa != 0)
+				significant++;
+		} else {
+			exponent++;
+		}
+		digits++;
+		rt->inPos++;
+	}
+	if (c == '.') {
+		rt->inPos++;
+		while ((c = X64Runtime_peek(rt)) >= '0' && c <= '9') {
+			if (significant < 19) {
+				mantissa = mantissa * 10 + (unsigned long long) (c - '0');
+				if (mantissa != 0)
+					significant++;
+				exponent--;
+			}
+			digits++;
+			rt->inPos++;
+		}
+	}
+	if (digits == 0) {
+		*v = 0;
+		X64Runtime_skipWord(rt);
+		return;
+	}
+	if (c == 'e' || c == 'E') {
+		rt->inPos++;
+		int expNegative = 0;
+		int e = 0;
+		c = X64Runtime_peek(rt);
+		if (c == '-' || c == '+') {
+			expNegative = c == '-';
+			rt->inPos++;
+		}
+		while ((c = X64Runtime_peek(rt)) >= '0' && c <= '9') {
+			if (e < 10000)
+				e = e * 10 + (c - '0');
+			rt->inPos++;
+		}
+		exponent += expNegative ? -e : e;
+	}
+	double value = (double) mantissa;
+	while (exponent > 22) {
+		value *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22) {
+		value /= 1e22;
+		exponent += 22;
+	}
+	value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+	*v = (float) (negative ? -value : value);
+}
+
+// room for n characters plus the terminator, old contents are kept.
+// Buffers are whole pages straight from mmap, grown with mremap.
+static void X64Runtime_reserve(X64String *s, size_t n) {
+	if (n < s->cap)
+		return;
+	size_t cap = s->cap < PAGE_SIZE ? PAGE_SIZE : s->cap;
+	while (cap <= n)
+		cap *= 2;
+	char *buf;
+	if (s->buf == NULL) {
+		buf = X64Runtime_map(cap);
+	} else {
+		long p = X64Runtime_syscall(SYS_MREMAP, (long) s->buf, (long) s->cap, (long) cap, MREMAP_MAYMOVE, 0, 0);
+		if (p < 0 && p > -4096)
+			X64Runtime_oom();
+		buf = (char *) p;
+	}
+	if (s->ptr == s->buf)
+		s->ptr = buf;
+	s->buf = buf;
+	s->cap = cap;
+}
+
+void X64Runtime_strInput(X64Runtime *rt, X64String *s) {
+	int c;
+	if (rt->inMidLine) {
+		// throw away what is left of the line the last number came from
+		while ((c = X64Runtime_peek(rt)) != -1) {
+			rt->inPos++;
+			if (c == '\n')
+				break;
+		}
+		rt->inMidLine = 0;
+	}
+	s->hash = 0;
+	if (X64Runtime_peek(rt) == -1) {
+		s->ptr = "";
+		s->len = 0;
+		return;
+	}
+	size_t len = 0;
+	while (X64Runtime_peek(rt) != -1) {
+		const char *start = rt->in + rt->inPos;
+		size_t n = 0;
+		while (rt->inPos + n < rt->inLen && start[n] != '\n')
+			n++;
+		X64Runtime_reserve(s, len + n);
+		X64Runtime_copy(s->buf + len, start, n);
+		len += n;
+		rt->inPos += n;
+		if (rt->inPos < rt->inLen) {
+			rt->inPos++;
+			break;
+		}
+	}
+	X64Runtime_reserve(s, len);
+	s->buf[len] = '\0';
+	s->ptr = s->buf;
+	s->len = len;
+}
+
+void X64Runtime_strSet(X64Runtime *rt, X64String *dst, const X64String *src) {
+	(void) rt;
+	if (dst->ptr == src->ptr && dst->len == src->len)
+		return;
+	if (src->ptr != src->buf) {
+		// a literal, share it instead of copying
+		dst->ptr = src->ptr;
+		dst->len = src->len;
+		dst->hash = src->hash;
+		return;
+	}
+	X64Runtime_reserve(dst, src->len);
+	X64Runtime_copy(dst->buf, src->ptr, src->len);
+	dst->buf[src->len] = '\0';
+	dst->ptr = dst->buf;
+	dst->len = src->len;
+	dst->hash = src->hash;
+}
+
+// same contract as tt_str_cat: one sized allocation, in place when parts[0]
+// is dst, and a fresh buffer when dst's buffer is read again further along
+void X64Runtime_strCat(X64Runtime *rt, X64String *dst, const X64String *const *parts, int n) {
+	(void) rt;
+	size_t len = 0;
+	size_t at = 0;
+	int first = 0;
+	int alias = 0;
+	int i;
+	for (i = 0; i < n; i++)
+		len += parts[i]->len;
+	if (dst->ptr == dst->buf && dst->buf != NULL && parts[0]->ptr == dst->buf && parts[0]->len == dst->len) {
+		first = 1;
+		at = dst->len;
+	}
+	for (i = first; i < n; i++) {
+		if (dst->buf != NULL && parts[i]->ptr == dst->buf)
+			alias = 1;
+	}
+	if (alias) {
+		X64String fresh = { "", 0, NULL, 0, 0 };
+		X64Runtime_reserve(&fresh, len);
+		at = 0;
+		for (i = 0; i < n; i++) {
+			X64Runtime_copy(fresh.buf + at, parts[i]->ptr, parts[i]->len);
+			at += parts[i]->len;
+		}
+		X64Runtime_syscall(SYS_MUNMAP, (long) dst->buf, (long) dst->cap, 0, 0, 0, 0);
+		dst->buf = fresh.buf;
+		dst->cap = fresh.cap;
+	} else {
+		X64Runtime_reserve(dst, len);
+		for (i = first; i < n; i++) {
+			X64Runtime_copy(dst->buf + at, parts[i]->ptr, parts[i]->len);
+			at += parts[i]->len;
+		}
+	}
+	dst->buf[len] = '\0';
+	dst->ptr = dst->buf;
+	dst->len = len;
+	dst->hash = 0;
+}
+
+int X64Runtime_strEq(X64Runtime *rt, const X64String *a, const X64String *b) {
+	(void) rt;
+	if (a->len != b->len)
+		return 0;
+	if (a->ptr == b->ptr)
+		return 1;
+	if (a->hash != 0 && b->hash != 0 && a->hash != b->hash)
+		return 0;
+	size_t i;
+	for (i = 0; i < a->len; i++) {
+		if (a->ptr[i] != b->ptr[i])
+			return 0;
+	}
+	return 1;
+}
@@ -0,0 +1,80 @@
+#ifndef X64RT_H
+#define X64RT_H
+
+#include <stddef.h>
+
+// Runtime for the native backend. It is freestanding C that only talks to
+// the kernel through raw syscalls, so the Makefile can build it into a
+// position independent blob that gets copied into every executable we write.
+
+#define X64RUNTIME_OUT_SIZE (1 << 16)
+#define X64RUNTIME_IN_SIZE (1 << 16)
+
+// same layout as the C backend's tt_str
+typedef struct X64String {
+	const char *ptr;
+	size_t len;
+	char *buf;
+	size_t cap;
+	unsigned int hash;
+} X64String;
+
+// all mutable runtime state lives here, in the program's zeroed data, so
+// the blob itself can stay read only
+typedef struct X64Runtime {
+	char *out;
+	size_t outLen;
+	char *in;
+	size_t inPos;
+	size_t inLen;
+	int inMidLine;
+} X64Runtime;
+
+// order of the jump table at the start of the blob
+typedef enum X64RuntimeCall {
+	X64RUNTIME_INIT = 0,
+	X64RUNTIME_FLUSH = 1,
+	X64RUNTIME_WRITE = 2,
+	X64RUNTIME_PRINT_INT = 3,
+	X64RUNTIME_PRINT_FLOAT = 4,
+	X64RUNTIME_PRINT_BOOL = 5,
+	X64RUNTIME_PRINT_STR = 6,
+	X64RUNTIME_INPUT_INT = 7,
+	X64RUNTIME_INPUT_FLOAT = 8,
+	X64RUNTIME_STR_INPUT = 9,
+	X64RUNTIME_STR_SET = 10,
+	X64RUNTIME_STR_CAT = 11,
+	X64RUNTIME_STR_EQ = 12,
+	X64RUNTIME_COUNT = 13
+} X64RuntimeCall;
+
+// every entry of the jump table is a 5 byte jmp rel32
+#define X64RUNTIME_ENTRY_SIZE 5
+
+void X64Runtime_init(X64Runtime *rt);
+
+void X64Runtime_flush(X64Runtime *rt);
+
+void X64Runtime_write(X64Runtime *rt, const char *s, size_t n);
+
+void X64Runtime_printInt(X64Runtime *rt, int v);
+
+void X64Runtime_printFloat(X64Runtime *rt, double v);
+
+void X64Runtime_printBool(X64Runtime *rt, int v);
+
+void X64Runtime_printStr(X64Runtime *rt, const X64String *s);
+
+void X64Runtime_inputInt(X64Runtime *rt, int *v);
+
+void X64Runtime_inputFloat(X64Runtime *rt, float *v);
+
+void X64Runtime_strInput(X64Runtime *rt, X64String *s);
+
+void X64Runtime_strSet(X64Runtime *rt, X64String *dst, const X64String *src);
+
+void X64Runtime_strCat(X64Runtime *rt, X64String *dst, const X64String *const *parts, int n);
+
+int X64Runtime_strEq(X64Runtime *rt, const X64String *a, const X64String *b);
+
+#endif
@@ -1,26 +1,44 @@
 #!/bin/bash
+# with TT_CACHE set to a directory, the compiler keeps the C it generates
+# there and the executables gcc builds from it are kept next to it, by a
+# hash of the C and of gcc's version
 
 if [[ $# -eq 0 ]]; then
-    for tiny in examples/*.teeny; do
-        echo "--------------"
-        if src/teenytiny "$tiny"; then
-            # compilation was successful!
-            gcc out.c -o "$(basename "${tiny%.teeny}")"
-        fi
-    done
-    # if the files don't exist, don't tell the user :)
-    rm .header &> /dev/null
-    rm .code &> /dev/null
-    rm out.c &> /dev/null
-else
-    for tiny in "$@"; do
-        echo "--------------"
-        if src/teenytiny "$tiny"; then
-            # compilation was successful!
-            gcc out.c -o "$(basename "${tiny%.teeny}")"
-        fi
-    done
-    rm .header &> /dev/null
-    rm .code &> /dev/null
-    rm out.c &> /dev/null
+    set -- examples/*.teeny
+fi
+cache=()
+if [[ -n "$TT_CACHE" ]]; then
+    cache=(--cache="$TT_CACHE")
 fi
+# one compiler process for all of them, it writes name.c for every
+# name.teeny, or out.c when there is only one. A file that fails to compile
+# gets no name.c, the rest are still linked
+src/teenytiny "${cache[@]}" "$@"
+failed=$?
+if [[ $# -eq 1 ]]; then
+    if [[ $failed -ne 0 ]]; then
+        rm -f out.c
+        exit 1
+    fi
+    mv out.c "$(basename "${1%.teeny}").c"
+fi
+for tiny in "$@"; do
+    name="$(basename "${tiny%.teeny}")"
+    # the compiler already said why this one failed
+    [[ -f "$name.c" ]] || continue
+    if [[ -n "$TT_CACHE" ]]; then
+        binary="$TT_CACHE/$( (cat "$name.c"; gcc --version) | sha256sum | cut -d' ' -f1).bin"
+        if [[ -f "$binary" ]]; then
+            cp "$binary" "$name" && touch "$binary" || failed=1
+        elif gcc "$name.c" -pthread -o "$name"; then
+            # renamed into place, so no one copies half an executable
+            cp "$name" "$binary.$$" && mv "$binary.$$" "$binary"
+        else
+            failed=1
+        fi
+    elif ! gcc "$name.c" -pthread -o "$name"; then
+        failed=1
+    fi
+    rm "$name.c"
+done
+exit $failed
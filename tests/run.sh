@@ -0,0 +1,60 @@
+#!/bin/bash
+# builds every program in examples and tests through each backend and checks
+# that what it prints, given tests/name.in on stdin when there is one, is
+# tests/name.expected. Run from the repository root or through make test,
+# rerecord every .expected from the C path with tests/run.sh -w.
+
+ROOT=$(pwd)
+DIR=$(mktemp -d)
+BACKENDS="c eval native run jit ast"
+# more workers than this machine may have CPUs, so a PARALLEL FOR is split
+export TT_THREADS=4
+failed=0
+record=0
+[ "$1" == "-w" ] && record=1
+
+# what the program $1 prints when built by backend $2, reading $3
+output() {
+	case $2 in
+	c)
+		(cd $DIR && $ROOT/src/teenytiny --no-eval $ROOT/$1 > /dev/null && gcc -w out.c -o program -pthread) && $DIR/program < $3 ;;
+	eval)
+		# what can be run at compile time is, and only its output is left
+		(cd $DIR && $ROOT/src/teenytiny $ROOT/$1 > /dev/null && gcc -w out.c -o program -pthread) && $DIR/program < $3 ;;
+	native)
+		(cd $DIR && $ROOT/src/teenytiny --native $ROOT/$1 > /dev/null) && $DIR/$(basename $1 .teeny) < $3 ;;
+	run)
+		src/teenytiny run $1 < $3 ;;
+	jit)
+		src/teenytiny --jit $1 < $3 ;;
+	ast)
+		(cd $DIR && $ROOT/src/teenytiny --no-eval --emit-ast=program.tta $ROOT/$1 > /dev/null && rm out.c \
+			&& $ROOT/src/teenytiny --no-eval --from-ast program.tta > /dev/null && gcc -w out.c -o program -pthread) && $DIR/program < $3 ;;
+	esac
+}
+
+for program in examples/*.teeny tests/*.teeny; do
+	name=$(basename $program .teeny)
+	input=tests/$name.in
+	[ -f $input ] || input=/dev/null
+	backends=$BACKENDS
+	# arrays are only supported when compiling to C
+	grep -q '^ *ARRAY' $program && backends="c eval ast"
+	for backend in $backends; do
+		output $program $backend $input > $DIR/output 2>&1
+		if [ $record == 1 ] && [ $backend == c ]; then
+			cp $DIR/output tests/$name.expected
+		elif ! cmp -s $DIR/output tests/$name.expected; then
+			echo "$name $backend: wrong output"
+			diff tests/$name.expected $DIR/output | head -5
+			failed=$((failed + 1))
+		fi
+	done
+done
+
+rm -rf $DIR
+if [ $failed -gt 0 ]; then
+	echo "$failed failed"
+	exit 1
+fi
+echo "all passed"